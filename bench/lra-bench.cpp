@@ -0,0 +1,466 @@
+// lra-bench.cpp - Headless batch simulation / benchmark harness
+// Runs buildScene() + simulate() without GLUT so solver throughput is not tied to vsync.
+//
+// Usage:
+//   lra-bench [--steps N] [--warmup N] [--sizes 30,64,128] [--iters 1,5,10] [--lra on|off|simd|both|all]
+//             [--solver gs|colored|jacobi|grid|both|all] [--instances N] [--compliance A]
+//             [--layout on|off] [--substeps 1,4] [--phases] [--trace out.json] [--memory]
+//             [--tethers 1,2,4] [--animate] [--adaptive TOL] [--sleep] [--lod] [--collide]
+//             [--record out.lrar] [--tear S]
+
+#include "simulation.h"
+#include "cloth_world.h"
+#include "cloth_lod.h"
+#include "lra_simd.h"
+#include "thread_pool.h"
+#include "profiler.h"
+#include "cloth_grid.h"
+#include "compact_constraints.h"
+#include "replay.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+// ---------------------------------------------------------
+// Options
+// ---------------------------------------------------------
+
+enum LRAMode { LRA_OFF, LRA_SCALAR, LRA_SIMD };
+static const char* lraModeName(int m) { return m == LRA_OFF ? "OFF" : (m == LRA_SCALAR ? "ON" : "SIMD"); }
+
+// Compile-time ClothGrid path, benchmarked next to the runtime SolverMode values
+static const int kSolverGrid = SOLVER_JACOBI + 1;
+static const char* solverName(int s) {
+    return s == kSolverGrid ? "grid" : s == SOLVER_JACOBI ? "jacobi" : (s == SOLVER_COLORED_PARALLEL ? "colored" : "gs");
+}
+
+struct BenchOptions {
+    int steps = 600;
+    int warmup = 60;
+    int instances = 1;
+    bool phases = false;
+    bool memory = false;
+    bool animate = false;
+    bool collide = false;   // sphere + capsule body per instance and self-collision
+    bool lod = false;       // simulate each instance through a ClothLOD seen by a virtual camera
+    bool adaptive = false;  // ITERATIONS_ADAPTIVE with --iters as the cap
+    float tolerance = 0.0f; // 0 never stops early: fixed count, but the error is reported
+    const char* tracePath = nullptr;
+    const char* recordPath = nullptr; // replay of the single cloth, warmup included
+    std::vector<int> sizes = {30, 64, 128};
+    std::vector<int> iterations = {1, 5, 10};
+    std::vector<int> substeps = {1};
+    std::vector<int> tethers = {1};
+    std::vector<int> lraModes = {LRA_SIMD, LRA_OFF};
+    std::vector<int> solvers = {SOLVER_GAUSS_SEIDEL};
+};
+
+static std::vector<int> parseIntList(const char* s) {
+    std::vector<int> out;
+    while (*s) {
+        char* end = nullptr;
+        long v = std::strtol(s, &end, 10);
+        if (end == s) break;
+        if (v > 0) out.push_back((int)v);
+        s = (*end == ',') ? end + 1 : end;
+    }
+    return out;
+}
+
+static void usage() {
+    printf("=== SCA 2012 LRA Headless Benchmark ===\n");
+    printf("--steps N      : Timed steps per configuration (default 600)\n");
+    printf("--warmup N     : Untimed steps before measuring (default 60)\n");
+    printf("--sizes a,b,.. : Square cloth resolutions (default 30,64,128)\n");
+    printf("--iters a,b,.. : Solver iteration counts (default 1,5,10)\n");
+    printf("--lra MODE     : on (scalar) | simd | off | both (simd+off) | all (default both)\n");
+    printf("--solver MODE  : gs | colored | jacobi | grid | both (gs+colored) | all (default gs)\n");
+    printf("                 grid = ClothGrid<S,S,I>, instantiated for sizes 30,64,128 x iters 1,5,10\n");
+    printf("--compliance A : XPBD compliance of every edge in m/N (default 0, rigid; not with grid)\n");
+    printf("--instances N  : Independent cloths stepped per frame by ClothWorld (default 1)\n");
+    printf("--layout MODE  : on | off, Morton particle reordering after buildScene (default on)\n");
+    printf("--substeps a,..: Substeps per dt, each running --iters iterations (default 1)\n");
+    printf("--tethers a,.. : LRA tethers per particle, K nearest attachments (default 1)\n");
+    printf("--animate      : Skin the pins to a swaying, twisting bone every step (not with grid)\n");
+    printf("--adaptive TOL : Stop each substep once the RMS edge error is below TOL; --iters is the cap.\n");
+    printf("                 TOL 0 runs every iteration and only reports the error (pick TOL from it)\n");
+    printf("--sleep        : Let settled tiles sleep; the asleep column is the share at the end\n");
+    printf("--collide      : Drape every cloth over a sphere and capsule body, with self-collision\n");
+    printf("--tear S       : Tear edges stretched past strain S (0.5 = 50%%); reports torn edges (not with grid)\n");
+    printf("--lod          : Crowd scene: instances stand 2 m + 3 m * k from a dollying camera and run\n");
+    printf("                 the ClothLOD level their screen size picks (1080p, 60 deg; not with grid)\n");
+    printf("--phases       : Print per-phase ms/step (avg, p50, p95, p99) for each configuration\n");
+    printf("--trace FILE   : Write a Chrome trace of every simulated step\n");
+    printf("--memory       : Print solver vs compact constraint storage per size before benchmarking\n");
+    printf("--record FILE  : Write a replay of the cloth (see lra-replay), warmup and timed steps; one\n");
+    printf("                 instance, not with grid or --lod. Each configuration overwrites FILE\n");
+}
+
+static bool parseArgs(int argc, char** argv, BenchOptions& opt) {
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        const char* v = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        if (!strcmp(a, "--help") || !strcmp(a, "-h")) return false;
+        if (!strcmp(a, "--phases")) { opt.phases = true; continue; }
+        if (!strcmp(a, "--memory")) { opt.memory = true; continue; }
+        if (!strcmp(a, "--animate")) { opt.animate = true; continue; }
+        if (!strcmp(a, "--sleep")) { g_sleep = true; continue; }
+        if (!strcmp(a, "--lod")) { opt.lod = true; continue; }
+        if (!strcmp(a, "--collide")) { opt.collide = true; continue; }
+        if (!v) { fprintf(stderr, "Missing value for %s\n", a); return false; }
+
+        if      (!strcmp(a, "--steps"))  opt.steps  = std::max(1, atoi(v));
+        else if (!strcmp(a, "--warmup")) opt.warmup = std::max(0, atoi(v));
+        else if (!strcmp(a, "--instances")) opt.instances = std::max(1, atoi(v));
+        else if (!strcmp(a, "--sizes"))  opt.sizes = parseIntList(v);
+        else if (!strcmp(a, "--iters"))  opt.iterations = parseIntList(v);
+        else if (!strcmp(a, "--substeps")) opt.substeps = parseIntList(v);
+        else if (!strcmp(a, "--tethers")) opt.tethers = parseIntList(v);
+        else if (!strcmp(a, "--trace"))  opt.tracePath = v;
+        else if (!strcmp(a, "--record")) opt.recordPath = v;
+        else if (!strcmp(a, "--compliance")) g_compliance = std::max(0.0f, (float)atof(v));
+        else if (!strcmp(a, "--tear")) g_tearStrain = std::max(0.0f, (float)atof(v));
+        else if (!strcmp(a, "--adaptive")) { opt.adaptive = true; opt.tolerance = std::max(0.0f, (float)atof(v)); }
+        else if (!strcmp(a, "--lra")) {
+            if      (!strcmp(v, "on"))   opt.lraModes = {LRA_SCALAR};
+            else if (!strcmp(v, "simd")) opt.lraModes = {LRA_SIMD};
+            else if (!strcmp(v, "off"))  opt.lraModes = {LRA_OFF};
+            else if (!strcmp(v, "both")) opt.lraModes = {LRA_SIMD, LRA_OFF};
+            else if (!strcmp(v, "all"))  opt.lraModes = {LRA_SCALAR, LRA_SIMD, LRA_OFF};
+            else { fprintf(stderr, "Unknown --lra mode: %s\n", v); return false; }
+        } else if (!strcmp(a, "--solver")) {
+            if      (!strcmp(v, "gs"))      opt.solvers = {SOLVER_GAUSS_SEIDEL};
+            else if (!strcmp(v, "colored")) opt.solvers = {SOLVER_COLORED_PARALLEL};
+            else if (!strcmp(v, "jacobi"))  opt.solvers = {SOLVER_JACOBI};
+            else if (!strcmp(v, "grid"))    opt.solvers = {kSolverGrid};
+            else if (!strcmp(v, "both"))    opt.solvers = {SOLVER_GAUSS_SEIDEL, SOLVER_COLORED_PARALLEL};
+            else if (!strcmp(v, "all"))     opt.solvers = {SOLVER_GAUSS_SEIDEL, SOLVER_COLORED_PARALLEL, SOLVER_JACOBI, kSolverGrid};
+            else { fprintf(stderr, "Unknown --solver mode: %s\n", v); return false; }
+        } else if (!strcmp(a, "--layout")) {
+            if      (!strcmp(v, "on"))  g_optimizeLayout = true;
+            else if (!strcmp(v, "off")) g_optimizeLayout = false;
+            else { fprintf(stderr, "Unknown --layout mode: %s\n", v); return false; }
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", a);
+            return false;
+        }
+        ++i;
+    }
+    return !opt.sizes.empty() && !opt.iterations.empty() && !opt.substeps.empty() && !opt.tethers.empty();
+}
+
+// ---------------------------------------------------------
+// Benchmark
+// ---------------------------------------------------------
+
+// Step every instance through a ClothGrid<S, S, I> copy (written back afterwards for the stats).
+// `loop(step)` runs the warmup and timed loops.
+template <int S, int I>
+static void stepGrids(ClothWorld& world, const std::function<void(const std::function<void()>&)>& loop) {
+    std::vector<ClothGrid<S, S, I>> grids(world.size());
+    for (size_t k = 0; k < world.size(); ++k) grids[k].assign(world[k]);
+    loop([&] {
+        if (grids.size() == 1) {
+            grids[0].simulate();
+        } else {
+            TaskGroup group;
+            for (auto& grid : grids) solverPool().submit(group, [&grid] { grid.simulate(); });
+            solverPool().wait(group);
+        }
+    });
+    for (size_t k = 0; k < world.size(); ++k) grids[k].store(world[k]);
+}
+
+typedef void (*GridStepFn)(ClothWorld&, const std::function<void(const std::function<void()>&)>&);
+
+struct GridEntry {
+    int size;
+    int iterations;
+    GridStepFn fn;
+};
+
+static const GridEntry kGridTable[] = {
+    {30, 1, stepGrids<30, 1>},   {30, 5, stepGrids<30, 5>},   {30, 10, stepGrids<30, 10>},
+    {64, 1, stepGrids<64, 1>},   {64, 5, stepGrids<64, 5>},   {64, 10, stepGrids<64, 10>},
+    {128, 1, stepGrids<128, 1>}, {128, 5, stepGrids<128, 5>}, {128, 10, stepGrids<128, 10>},
+};
+
+static GridStepFn findGrid(int size, int iterations) {
+    for (const auto& e : kGridTable) {
+        if (e.size == size && e.iterations == iterations) return e.fn;
+    }
+    return nullptr;
+}
+
+// Constraint bytes in solver format vs CompactConstraints, and the round-trip error
+// (relative for rest lengths, absolute for tether lengths)
+static void reportMemory(const BenchOptions& opt) {
+    printf("%-9s %12s %12s %9s %9s %12s %12s\n",
+           "size", "solver KB", "compact KB", "B/constr", "ratio", "maxRestErr", "tetherErr mm");
+    for (int size : opt.sizes) {
+        ClothInstance cloth;
+        cloth.buildScene(size, size);
+        CompactConstraints cc = compactConstraints(cloth);
+
+        ClothInstance copy = cloth;
+        expandConstraints(cc, copy);
+        float restErr = 0.0f, tetherErr = 0.0f;
+        for (size_t k = 0; k < cloth.localConstraints.size(); ++k) {
+            const auto& a = cloth.localConstraints[k];
+            const auto& b = copy.localConstraints[k];
+            restErr = (a.i == b.i && a.j == b.j) ? std::max(restErr, std::fabs(a.restLen - b.restLen) / a.restLen) : INFINITY;
+        }
+        for (const auto& a : cloth.lraConstraints) {
+            int k = copy.lraOfParticle[a.particleIdx];
+            const auto* b = (k == -1) ? nullptr : &copy.lraConstraints[k];
+            tetherErr = (b && b->attachmentIdx == a.attachmentIdx)
+                      ? std::max(tetherErr, std::fabs(a.maxDist - b->maxDist)) : INFINITY;
+        }
+
+        size_t raw = constraintMemoryBytes(cloth), packed = cc.memoryBytes();
+        char dim[32];
+        snprintf(dim, sizeof(dim), "%dx%d", size, size);
+        printf("%-9s %12.1f %12.1f %9.2f %8.1fx %12.2e %12.2e\n", dim, raw / 1024.0, packed / 1024.0,
+               (double)packed / (cc.numEdges + cc.numTethers), (double)raw / packed, restErr, tetherErr * 1000.0f);
+    }
+    printf("\n");
+}
+
+// Pin bone of instance `k` at time t: a twist about its own vertical axis plus a sideways sway,
+// phase-shifted per instance so the characters do not move in lockstep
+static glm::mat4 swayBone(float t, int k, const vec3& origin) {
+    float ph = 0.7f * k;
+    float a = 0.6f * std::sin(t * 1.3f + ph) - 0.6f * std::sin(ph);
+    float c = std::cos(a), s = std::sin(a);
+    vec3 shift = vec3(0.4f * (std::sin(t * 0.9f + ph) - std::sin(ph)), 0.0f, 0.0f);
+    glm::mat4 m(1.0f);
+    m[0] = glm::vec4(c, 0.0f, -s, 0.0f);
+    m[2] = glm::vec4(s, 0.0f, c, 0.0f);
+    // Rotate about `origin`: shift + origin - R * origin
+    vec3 o = origin + shift - vec3(c * origin.x + s * origin.z, origin.y, -s * origin.x + c * origin.z);
+    m[3] = glm::vec4(o, 1.0f);
+    return m;
+}
+
+struct BenchConfig {
+    int size;
+    int iterations;
+    int substeps;
+    int tethers;
+    int lraMode;
+    int solver;
+};
+
+static void runConfig(const BenchOptions& opt, const BenchConfig& cfg) {
+    GridStepFn gridFn = nullptr;
+    if (cfg.solver == kSolverGrid) {
+        gridFn = findGrid(cfg.size, cfg.iterations);
+        if (!gridFn) {
+            printf("%dx%d / %d iters: no ClothGrid instantiation, skipped\n", cfg.size, cfg.size, cfg.iterations);
+            return;
+        }
+        if (opt.animate || opt.adaptive || opt.lod || opt.collide || g_compliance > 0.0f || g_tearStrain > 0.0f) {
+            printf("%dx%d / grid: fixed iterations, static anchors, full detail, rigid untearable edges and no collisions only, skipped\n", cfg.size, cfg.size);
+            return;
+        }
+    }
+
+    g_solverMode = (cfg.solver == kSolverGrid) ? SOLVER_GAUSS_SEIDEL : cfg.solver;
+    g_iterations = cfg.iterations;
+    g_iterationMode = opt.adaptive ? ITERATIONS_ADAPTIVE : ITERATIONS_FIXED;
+    g_iterationTolerance = opt.tolerance;
+    g_maxIterations = cfg.iterations;
+    g_substeps = cfg.substeps;
+    g_lraTethers = cfg.tethers;
+    g_useLRA = (cfg.lraMode != LRA_OFF);
+    g_lraSimd = (cfg.lraMode == LRA_SIMD);
+    g_selfCollision = opt.collide; // instances take all of these as their params when created
+
+    // Instances are spaced apart so they could be drawn side by side; they never interact.
+    ClothWorld world;
+    std::vector<vec3> origins;
+    for (int k = 0; k < opt.instances; ++k) {
+        origins.push_back(vec3(k * cfg.size * spacing * 1.5f, 0.0f, 0.0f));
+        if (opt.lod) {
+            ClothInstance source;
+            source.buildScene(cfg.size, cfg.size, origins.back());
+            ClothLOD& lod = world.spawnLOD();
+            lod.build(source);
+            for (int l = 0; opt.animate && l < lod.numLevels(); ++l) {
+                ClothInstance& level = lod.level(l);
+                level.bindAttachments(std::vector<int>(level.attachmentIndices.size(), 0));
+            }
+            continue;
+        }
+        ClothInstance& cloth = world.spawn();
+        cloth.buildScene(cfg.size, cfg.size, origins.back());
+        if (opt.animate) cloth.bindAttachments(std::vector<int>(cloth.attachmentIndices.size(), 0));
+    }
+    const size_t numCloths = opt.instances;
+    auto cloth = [&](size_t k) -> ClothInstance& { return opt.lod ? world.lod(k).current() : world[k]; };
+
+    // --collide: a head-sized sphere pressing into the cloth and a torso capsule behind it
+    for (size_t k = 0; opt.collide && k < numCloths; ++k) {
+        const float size = (cfg.size - 1) * spacing;
+        const vec3 o = origins[k];
+        cloth(k).colliders.spheres.push_back({o + vec3(0.0f, 0.6f * size, 0.1f * size), 0.2f * size});
+        cloth(k).colliders.capsules.push_back({o + vec3(-0.2f * size, 0.3f * size, 0.15f * size),
+                                               o + vec3(0.2f * size, 0.3f * size, 0.15f * size), 0.2f * size});
+    }
+
+    // --lod camera: 1080p, 60 degree vertical field of view, slowly dollying in and out
+    const float clothSize = (cfg.size - 1) * spacing;
+    const float fovY = 1.0472f;
+    int switches = 0;
+
+    int frame = 0;
+    double iterationsRun = 0.0; // over the timed steps, summed over instances
+    double rmsErrorSum = 0.0;
+    double particleSteps = 0.0; // particles simulated over the timed steps
+    auto step = [&] {
+        const float t = ++frame * dt;
+        if (opt.lod) {
+            for (size_t k = 0; k < numCloths; ++k) {
+                float distance = (2.0f + 3.0f * k) * (1.0f + 0.3f * std::sin(0.5f * t + 0.7f * k));
+                switches += world.lod(k).update(ClothLOD::screenSize(clothSize, distance, fovY, 1080));
+            }
+        }
+        if (opt.animate) {
+            for (size_t k = 0; k < numCloths; ++k) {
+                glm::mat4 bone = swayBone(t, (int)k, origins[k]);
+                cloth(k).skinAttachments(&bone, 1);
+            }
+        }
+        if (numCloths == 1) cloth(0).simulate();
+        else world.step();
+        for (size_t k = 0; k < numCloths; ++k) {
+            iterationsRun += cloth(k).lastSolve.iterations;
+            rmsErrorSum += cloth(k).lastSolve.rmsError;
+            particleSteps += (double)cloth(k).P.size();
+        }
+    };
+
+    std::chrono::steady_clock::time_point t0, t1;
+    auto loop = [&](const std::function<void()>& stepFn) {
+        for (int s = 0; s < opt.warmup; ++s) stepFn();
+        profiler().reset();
+        iterationsRun = rmsErrorSum = particleSteps = 0.0;
+        switches = 0;
+
+        t0 = std::chrono::steady_clock::now();
+        for (int s = 0; s < opt.steps; ++s) {
+            stepFn();
+            profiler().endFrame();
+        }
+        t1 = std::chrono::steady_clock::now();
+    };
+    ReplayRecorder recorder;
+    if (opt.recordPath && !gridFn && !opt.lod && numCloths == 1 && !recorder.begin(cloth(0), opt.recordPath)) {
+        fprintf(stderr, "Could not write %s\n", opt.recordPath);
+    }
+    if (gridFn) gridFn(world, loop);
+    else loop(step);
+    recorder.end();
+
+    double particles = 0.0;
+    int tiles = 0, asleep = 0, torn = 0, tethered = 0;
+    StretchStats st = {0.0f, 0.0f};
+    std::vector<int> atLevel;
+    for (size_t k = 0; k < numCloths; ++k) {
+        particles += (double)cloth(k).P.size();
+        tiles += cloth(k).numTiles();
+        asleep += cloth(k).sleepingTiles();
+        torn += cloth(k).tornEdges;
+        tethered += (int)cloth(k).lraConstraints.size() / cloth(k).tethersPerParticle;
+        StretchStats sk = cloth(k).measureStretch();
+        st.maxStrain = std::max(st.maxStrain, sk.maxStrain);
+        st.meanStrain += sk.meanStrain / numCloths;
+        if (opt.lod) {
+            atLevel.resize(std::max(atLevel.size(), (size_t)world.lod(k).numLevels()), 0);
+            ++atLevel[world.lod(k).activeLevel()];
+        }
+    }
+
+    // ClothGrid does not report iterations: always Iters per substep
+    if (gridFn) iterationsRun = (double)opt.steps * numCloths * cfg.iterations * cfg.substeps;
+    else particles = particleSteps / opt.steps; // average over the timed steps (LOD switches)
+    const double itersPerStep = iterationsRun / ((double)opt.steps * numCloths);
+    char rmsError[16] = "-";
+    char asleepShare[16] = "-";
+    if (g_sleep && !gridFn) snprintf(asleepShare, sizeof(asleepShare), "%.0f%%", 100.0 * asleep / std::max(1, tiles));
+    if (opt.adaptive) snprintf(rmsError, sizeof(rmsError), "%.2f%%", 100.0 * rmsErrorSum / ((double)opt.steps * numCloths));
+
+    double sec = std::chrono::duration<double>(t1 - t0).count();
+    double nsPerParticleIter = sec * 1e9 / ((double)opt.steps * particles * itersPerStep);
+
+    char dim[32];
+    snprintf(dim, sizeof(dim), "%dx%d", cfg.size, cfg.size);
+    printf("%-9s %5d %-7s %5d %4d %2d %4s %8.2f %12.1f %16.3f %10.2f%% %10.2f%% %8s %7s\n",
+           dim, opt.instances, solverName(cfg.solver), cfg.iterations, cfg.substeps, cfg.tethers,
+           lraModeName(cfg.lraMode), itersPerStep, opt.steps / sec, nsPerParticleIter,
+           st.maxStrain * 100.0f, st.meanStrain * 100.0f, rmsError, asleepShare);
+
+    if (opt.lod) {
+        const double full = (double)numCloths * cfg.size * cfg.size;
+        printf("    LOD: %.0f of %.0f particles simulated (%.1f%%), %d switches, instances per level at the end:",
+               particles, full, 100.0 * particles / full, switches);
+        for (size_t l = 0; l < atLevel.size(); ++l) printf(" L%d %d", (int)l, atLevel[l]);
+        printf("\n");
+    }
+
+    if (g_tearStrain > 0.0f && !gridFn) {
+        printf("    Tearing: %d edges torn, %d particles still tethered\n", torn, tethered);
+    }
+
+    if (opt.phases) {
+        // Rolling window covers the last Profiler::kHistory steps
+        for (int p = 0; p < PHASE_DISPLAY; ++p) { // no display() when headless
+            Profiler::PhaseStats ps = profiler().stats(p);
+            printf("    %-10s avg %8.4f  p50 %8.4f  p95 %8.4f  p99 %8.4f ms/step\n",
+                   phaseName(p), ps.avgMs, ps.p50Ms, ps.p95Ms, ps.p99Ms);
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    BenchOptions opt;
+    if (!parseArgs(argc, argv, opt)) {
+        usage();
+        return 1;
+    }
+
+    if (opt.memory) reportMemory(opt);
+
+    printf("LRA kernel: %s | threads: %d\n", lraSimdName(), solverPool().size());
+    profiler().enabled = opt.phases || opt.tracePath;
+    if (opt.tracePath) profiler().beginTrace();
+    printf("%-9s %5s %-7s %5s %4s %2s %4s %8s %12s %16s %11s %11s %8s %7s\n",
+           "size", "inst", "solver", "iters", "sub", "K", "LRA", "it/step", "steps/sec", "ns/particle/it", "maxStrain", "meanStrain", "rmsErr", "asleep");
+
+    for (int size : opt.sizes) {
+        for (int iters : opt.iterations) {
+            for (int sub : opt.substeps) {
+                for (int k : opt.tethers) {
+                    for (int lra : opt.lraModes) {
+                        for (int solver : opt.solvers) {
+                            runConfig(opt, {size, iters, sub, k, lra, solver});
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    if (opt.tracePath && !profiler().endTrace(opt.tracePath)) {
+        fprintf(stderr, "Could not write %s\n", opt.tracePath);
+        return 1;
+    }
+    return 0;
+}
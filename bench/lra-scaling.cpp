@@ -0,0 +1,506 @@
+// lra-scaling.cpp - Scaling benchmark matrix for release regression runs
+// Sweeps cloth resolution, attachment count, iterations, LRA on/off, solver backend and thread
+// count, timing buildGrid() (the body of buildScene()) and simulate(), and writes one row per
+// configuration as CSV and / or JSON. Against a baseline CSV of an earlier run it reports every
+// configuration that got slower than the tolerance and exits with status 2.
+//
+// Usage:
+//   lra-scaling [--steps N] [--warmup N] [--repeats N] [--sizes 30,64,...,1024] [--pins 2,8,row] [--iters 5,10]
+//               [--lra on|off|both] [--backend serial,simd,colored,jacobi,gpu] [--threads 1,2,4,0]
+//               [--csv FILE] [--json FILE] [--baseline FILE] [--tolerance PCT]
+
+#include "simulation.h"
+#include "lra_simd.h"
+#include "thread_pool.h"
+#include "profiler.h"
+#include "compact_constraints.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#elif defined(__APPLE__)
+#include <mach/mach.h>
+#include <sys/resource.h>
+#else
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ---------------------------------------------------------
+// Options
+// ---------------------------------------------------------
+
+enum Backend { BACKEND_SERIAL, BACKEND_SIMD, BACKEND_COLORED, BACKEND_JACOBI, BACKEND_GPU };
+static const char* backendName(int b) {
+    static const char* names[] = {"serial", "simd", "colored", "jacobi", "gpu"};
+    return names[b];
+}
+static bool threadedBackend(int b) { return b == BACKEND_COLORED || b == BACKEND_JACOBI; }
+
+static const int kPinRow = 0; // --pins value for a fully pinned top row
+
+struct ScalingOptions {
+    int steps = 200;
+    int warmup = 20;
+    int repeats = 5;
+    float tolerance = 10.0f; // percent
+    const char* csvPath = nullptr;
+    const char* jsonPath = nullptr;
+    const char* baselinePath = nullptr;
+    std::vector<int> sizes = {30, 64, 128, 256, 512, 1024};
+    std::vector<int> pins = {2, 8, kPinRow};
+    std::vector<int> iterations = {5, 10};
+    std::vector<int> lra = {1, 0};
+    std::vector<int> backends = {BACKEND_SERIAL, BACKEND_SIMD, BACKEND_COLORED};
+    std::vector<int> threads = {0};
+};
+
+// Comma-separated integers; `row` (for --pins) maps to kPinRow
+static bool parseIntList(const char* s, std::vector<int>& out, int minValue) {
+    out.clear();
+    while (*s) {
+        char* end = nullptr;
+        long v;
+        if (!strncmp(s, "row", 3)) { v = kPinRow; end = (char*)s + 3; }
+        else v = std::strtol(s, &end, 10);
+        if (end == s || v < minValue) return false;
+        out.push_back((int)v);
+        s = (*end == ',') ? end + 1 : end;
+    }
+    return !out.empty();
+}
+
+static bool parseBackends(const char* s, std::vector<int>& out) {
+    out.clear();
+    while (*s) {
+        const char* end = strchr(s, ',');
+        size_t n = end ? (size_t)(end - s) : strlen(s);
+        int b = -1;
+        for (int k = BACKEND_SERIAL; k <= BACKEND_GPU; ++k) {
+            if (strlen(backendName(k)) == n && !strncmp(s, backendName(k), n)) b = k;
+        }
+        if (b == -1) return false;
+        out.push_back(b);
+        s = end ? end + 1 : s + n;
+    }
+    return !out.empty();
+}
+
+static void usage() {
+    printf("=== SCA 2012 LRA Scaling Benchmark ===\n");
+    printf("--steps N        : Timed steps per configuration (default 200)\n");
+    printf("--warmup N       : Untimed steps before measuring (default 20)\n");
+    printf("--repeats N      : Timed runs the steps are split into; steps/sec is their median (default 5)\n");
+    printf("--sizes a,b,..   : Square cloth resolutions (default 30,64,128,256,512,1024)\n");
+    printf("--pins a,b,..    : Attachments spread evenly along the top row, `row` = all of it (default 2,8,row)\n");
+    printf("--iters a,b,..   : Solver iterations per step (default 5,10)\n");
+    printf("--lra MODE       : on | off | both (default both)\n");
+    printf("--backend a,b,.. : serial (GS, scalar LRA) | simd (GS, SIMD LRA) | colored | jacobi | gpu\n");
+    printf("                   (default serial,simd,colored). colored and jacobi use the SIMD LRA kernel;\n");
+    printf("                   gpu needs a GL context and is skipped here (use the demo's G key)\n");
+    printf("--threads a,b,.. : Solver pool sizes for colored / jacobi, 0 = all cores (default 0)\n");
+    printf("--csv FILE       : Write the results as CSV (- = stdout)\n");
+    printf("--json FILE      : Write the results as JSON (- = stdout)\n");
+    printf("--baseline FILE  : CSV of an earlier run; report configurations slower than --tolerance\n");
+    printf("--tolerance PCT  : Allowed steps/sec drop and build time growth vs the baseline (default 10),\n");
+    printf("                   widened by the spread of this run's repeats\n");
+}
+
+static bool parseArgs(int argc, char** argv, ScalingOptions& opt) {
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        const char* v = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        if (!strcmp(a, "--help") || !strcmp(a, "-h")) return false;
+        if (!v) { fprintf(stderr, "Missing value for %s\n", a); return false; }
+
+        bool ok = true;
+        if      (!strcmp(a, "--steps"))  opt.steps  = std::max(1, atoi(v));
+        else if (!strcmp(a, "--warmup")) opt.warmup = std::max(0, atoi(v));
+        else if (!strcmp(a, "--repeats")) opt.repeats = std::max(1, atoi(v));
+        else if (!strcmp(a, "--sizes"))  ok = parseIntList(v, opt.sizes, 2);
+        else if (!strcmp(a, "--pins"))   ok = parseIntList(v, opt.pins, kPinRow);
+        else if (!strcmp(a, "--iters"))  ok = parseIntList(v, opt.iterations, 1);
+        else if (!strcmp(a, "--threads")) ok = parseIntList(v, opt.threads, 0);
+        else if (!strcmp(a, "--backend")) ok = parseBackends(v, opt.backends);
+        else if (!strcmp(a, "--csv"))    opt.csvPath = v;
+        else if (!strcmp(a, "--json"))   opt.jsonPath = v;
+        else if (!strcmp(a, "--baseline")) opt.baselinePath = v;
+        else if (!strcmp(a, "--tolerance")) opt.tolerance = std::max(0.0f, (float)atof(v));
+        else if (!strcmp(a, "--lra")) {
+            if      (!strcmp(v, "on"))   opt.lra = {1};
+            else if (!strcmp(v, "off"))  opt.lra = {0};
+            else if (!strcmp(v, "both")) opt.lra = {1, 0};
+            else ok = false;
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", a);
+            return false;
+        }
+        if (!ok) { fprintf(stderr, "Bad value for %s: %s\n", a, v); return false; }
+        ++i;
+    }
+    return true;
+}
+
+// ---------------------------------------------------------
+// Memory
+// ---------------------------------------------------------
+
+// Resident set size now and its high-water mark, in bytes (0 if unknown)
+static size_t residentBytes() {
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS pmc;
+    return GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)) ? pmc.WorkingSetSize : 0;
+#elif defined(__APPLE__)
+    mach_task_basic_info info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &count) != KERN_SUCCESS) return 0;
+    return info.resident_size;
+#else
+    FILE* f = fopen("/proc/self/statm", "r");
+    if (!f) return 0;
+    long pages = 0, resident = 0;
+    int n = fscanf(f, "%ld %ld", &pages, &resident);
+    fclose(f);
+    return n == 2 ? (size_t)resident * (size_t)sysconf(_SC_PAGESIZE) : 0;
+#endif
+}
+
+static size_t peakResidentBytes() {
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS pmc;
+    return GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)) ? pmc.PeakWorkingSetSize : 0;
+#elif defined(__APPLE__)
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) != 0) return 0;
+    return (size_t)ru.ru_maxrss; // bytes
+#else
+    // VmHWM, which resetPeakResident() can lower (ru_maxrss keeps the peak of exited threads)
+    FILE* f = fopen("/proc/self/status", "r");
+    if (!f) return 0;
+    char line[256];
+    size_t kb = 0;
+    while (fgets(line, sizeof(line), f)) {
+        if (sscanf(line, "VmHWM: %zu kB", &kb) == 1) break;
+    }
+    fclose(f);
+    return kb * 1024;
+#endif
+}
+
+// Restart the high-water mark from the current RSS. Only Linux can; elsewhere it stays the
+// process peak and false is returned.
+static bool resetPeakResident() {
+#if defined(_WIN32) || defined(__APPLE__)
+    return false;
+#else
+    FILE* f = fopen("/proc/self/clear_refs", "w");
+    if (!f) return false;
+    bool ok = fputs("5", f) >= 0;
+    return (fclose(f) == 0) && ok;
+#endif
+}
+
+// ---------------------------------------------------------
+// Benchmark
+// ---------------------------------------------------------
+
+struct ScalingConfig {
+    int size;
+    int pins;     // attachments requested (kPinRow = the whole top row)
+    int iterations;
+    int lra;
+    int backend;
+    int threads;  // solver pool size, 1 for the serial backends
+};
+
+struct ScalingResult {
+    ScalingConfig cfg;
+    int attachments;
+    int particles;
+    double buildMs;         // best of the builds
+    double buildSpreadPct;  // median absolute deviation of the builds, % of their median
+    double stepsPerSec;     // median of the repeats
+    double stepsSpreadPct;  // median absolute deviation of the repeats' steps/sec, % of their median
+    double nsPerParticleIter;
+    float phaseMs[PHASE_DISPLAY]; // avg ms/step over the last Profiler::kHistory steps
+    double memGrowthMB;           // RSS at the end over the RSS just before the first build
+    double peakGrowthMB;          // high-water mark over that RSS
+    double constraintKB;
+    float maxStretch;  // max over edges of len / restLen at the end of the run
+    float meanStretch; // 1 + mean |len / restLen - 1|
+};
+
+// `count` attachments spread evenly along the top row of a w-wide grid, corners included
+static void topRowPins(int w, int count, std::vector<int>& pins) {
+    count = (count == kPinRow) ? w : std::min(std::max(count, 1), w);
+    pins.clear();
+    for (int k = 0; k < count; ++k) {
+        int x = (count == 1) ? (w - 1) / 2 : (int)std::lround((double)k * (w - 1) / (count - 1));
+        if (pins.empty() || pins.back() != x) pins.push_back(x);
+    }
+}
+
+// Median of `v` (reordered) and its median absolute deviation in % of the median
+static double median(std::vector<double>& v) {
+    std::sort(v.begin(), v.end());
+    const size_t mid = v.size() / 2;
+    return (v.size() % 2) ? v[mid] : 0.5 * (v[mid - 1] + v[mid]);
+}
+
+static double spreadPct(std::vector<double>& v) {
+    const double m = median(v);
+    for (double& x : v) x = std::fabs(x - m);
+    return 100.0 * median(v) / m;
+}
+
+static ScalingResult runConfig(const ScalingOptions& opt, const ScalingConfig& cfg) {
+    resizeSolverPool(cfg.threads);
+    g_solverMode = cfg.backend == BACKEND_COLORED ? SOLVER_COLORED_PARALLEL
+                 : cfg.backend == BACKEND_JACOBI  ? SOLVER_JACOBI : SOLVER_GAUSS_SEIDEL;
+    g_iterations = cfg.iterations;
+    g_iterationMode = ITERATIONS_FIXED;
+    g_substeps = 1;
+    g_lraTethers = 1;
+    g_useLRA = cfg.lra != 0;
+    g_lraSimd = cfg.backend != BACKEND_SERIAL;
+
+    ScalingResult r = {};
+    r.cfg = cfg;
+
+    // buildScene() with the attachments of this configuration instead of the two corners
+    const int w = cfg.size, h = cfg.size;
+    std::vector<vec3> rest(w * h);
+    std::vector<int> pinned;
+    topRowPins(w, cfg.pins, pinned);
+    // Memory is measured as growth over the RSS from here, before anything of this configuration
+    // is allocated, so earlier (larger) configurations do not show up in it
+    const size_t baseBytes = residentBytes();
+    const size_t peakBefore = peakResidentBytes();
+    const bool peakReset = resetPeakResident();
+    ClothInstance cloth;
+    // Small cloths build in well under a millisecond: best of repeated builds (>= 3, >= 50 ms in total)
+    std::vector<double> builds;
+    double totalMs = 0.0;
+    r.buildMs = INFINITY;
+    for (int rep = 0; rep < 20 && (rep < 3 || totalMs < 50.0); ++rep) {
+        auto b0 = std::chrono::steady_clock::now();
+        for (int y = 0; y < h; ++y) {
+            for (int x = 0; x < w; ++x) rest[y * w + x] = vec3((x - (w - 1) * 0.5f) * spacing, (h - 1 - y) * spacing, 0.0f);
+        }
+        cloth.buildGrid(w, h, rest, pinned);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - b0).count();
+        r.buildMs = std::min(r.buildMs, ms);
+        builds.push_back(ms);
+        totalMs += ms;
+    }
+    r.buildSpreadPct = spreadPct(builds);
+    r.attachments = (int)cloth.attachmentIndices.size();
+    r.particles = (int)cloth.P.size();
+
+    for (int s = 0; s < opt.warmup; ++s) cloth.simulate();
+    profiler().reset();
+    // The steps are split into timed runs and steps/sec is their median, so a run the scheduler
+    // preempted does not move it. Like the builds' spread, theirs widens the baseline tolerance.
+    const int repeats = std::min(opt.repeats, opt.steps);
+    std::vector<double> rates;
+    double iterationsRun = 0.0, sec = 0.0;
+    for (int rep = 0; rep < repeats; ++rep) {
+        const int steps = opt.steps / repeats + (rep < opt.steps % repeats);
+        auto t0 = std::chrono::steady_clock::now();
+        for (int s = 0; s < steps; ++s) {
+            cloth.simulate();
+            profiler().endFrame();
+            iterationsRun += cloth.lastSolve.iterations;
+        }
+        const double runSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        rates.push_back(steps / runSec);
+        sec += runSec;
+    }
+    r.stepsPerSec = median(rates);
+    r.stepsSpreadPct = spreadPct(rates);
+    r.nsPerParticleIter = sec * 1e9 / ((double)r.particles * std::max(1.0, iterationsRun));
+    for (int p = 0; p < PHASE_DISPLAY; ++p) r.phaseMs[p] = profiler().stats(p).avgMs;
+    // Without a reset the high-water mark only belongs to this configuration if it rose during it;
+    // otherwise the RSS at the end is all that is known
+    const size_t endBytes = residentBytes();
+    const size_t peakBytes = peakResidentBytes();
+    const size_t topBytes = std::max(endBytes, (peakReset || peakBytes > peakBefore) ? peakBytes : 0);
+    r.memGrowthMB = (endBytes > baseBytes ? endBytes - baseBytes : 0) / (1024.0 * 1024.0);
+    r.peakGrowthMB = (topBytes > baseBytes ? topBytes - baseBytes : 0) / (1024.0 * 1024.0);
+    r.constraintKB = constraintMemoryBytes(cloth) / 1024.0;
+    StretchStats st = cloth.measureStretch();
+    r.maxStretch = 1.0f + st.maxStrain;
+    r.meanStretch = 1.0f + st.meanStrain;
+    return r;
+}
+
+// ---------------------------------------------------------
+// Output
+// ---------------------------------------------------------
+
+static FILE* openOutput(const char* path) {
+    return strcmp(path, "-") ? fopen(path, "w") : stdout;
+}
+
+static void closeOutput(FILE* f) {
+    if (f != stdout) fclose(f);
+}
+
+static const char* kCsvHeader = "size,pins,iters,lra,backend,threads,attachments,particles,build_ms,steps_per_sec,"
+                                "steps_spread_pct,build_spread_pct,ns_per_particle_iter,ms_aero,ms_integrate,ms_local,ms_lra,ms_collide,ms_velocity,"
+                                "mem_growth_mb,peak_growth_mb,constraint_kb,max_stretch,mean_stretch";
+
+static bool writeCSV(const char* path, const std::vector<ScalingResult>& results) {
+    FILE* f = openOutput(path);
+    if (!f) return false;
+    fprintf(f, "%s\n", kCsvHeader);
+    for (const ScalingResult& r : results) {
+        const ScalingConfig& c = r.cfg;
+        fprintf(f, "%d,%d,%d,%s,%s,%d,%d,%d,%.3f,%.2f,%.2f,%.2f,%.4f", c.size, c.pins, c.iterations, c.lra ? "on" : "off",
+                backendName(c.backend), c.threads, r.attachments, r.particles, r.buildMs, r.stepsPerSec,
+                r.stepsSpreadPct, r.buildSpreadPct, r.nsPerParticleIter);
+        for (int p = 0; p < PHASE_DISPLAY; ++p) fprintf(f, ",%.4f", r.phaseMs[p]);
+        fprintf(f, ",%.1f,%.1f,%.1f,%.5f,%.5f\n", r.memGrowthMB, r.peakGrowthMB, r.constraintKB, r.maxStretch, r.meanStretch);
+    }
+    closeOutput(f);
+    return true;
+}
+
+static bool writeJSON(const char* path, const std::vector<ScalingResult>& results, const ScalingOptions& opt) {
+    FILE* f = openOutput(path);
+    if (!f) return false;
+    fprintf(f, "{\"lraKernel\":\"%s\",\"cores\":%u,\"steps\":%d,\"warmup\":%d,\"repeats\":%d,\"results\":[\n",
+            lraSimdName(), std::max(1u, std::thread::hardware_concurrency()), opt.steps, opt.warmup, opt.repeats);
+    for (size_t k = 0; k < results.size(); ++k) {
+        const ScalingResult& r = results[k];
+        const ScalingConfig& c = r.cfg;
+        fprintf(f, "{\"size\":%d,\"pins\":%d,\"iters\":%d,\"lra\":%s,\"backend\":\"%s\",\"threads\":%d,"
+                   "\"attachments\":%d,\"particles\":%d,\"buildMs\":%.3f,\"stepsPerSec\":%.2f,\"stepsSpreadPct\":%.2f,"
+                   "\"buildSpreadPct\":%.2f,\"nsPerParticleIter\":%.4f,\"phaseMs\":{",
+                c.size, c.pins, c.iterations, c.lra ? "true" : "false", backendName(c.backend), c.threads,
+                r.attachments, r.particles, r.buildMs, r.stepsPerSec, r.stepsSpreadPct, r.buildSpreadPct,
+                r.nsPerParticleIter);
+        for (int p = 0; p < PHASE_DISPLAY; ++p) fprintf(f, "%s\"%s\":%.4f", p ? "," : "", phaseName(p), r.phaseMs[p]);
+        fprintf(f, "},\"memGrowthMB\":%.1f,\"peakGrowthMB\":%.1f,\"constraintKB\":%.1f,\"maxStretch\":%.5f,\"meanStretch\":%.5f}%s\n",
+                r.memGrowthMB, r.peakGrowthMB, r.constraintKB, r.maxStretch, r.meanStretch, k + 1 < results.size() ? "," : "");
+    }
+    fprintf(f, "]}\n");
+    closeOutput(f);
+    return true;
+}
+
+// Compare with a CSV written by an earlier run (same leading columns). A configuration regressed
+// if it lost more than the tolerance plus its own spread in this run. Returns the number of regressions,
+// -1 if the file cannot be read.
+static int compareBaseline(const char* path, const std::vector<ScalingResult>& results, float tolerancePct) {
+    FILE* f = fopen(path, "r");
+    if (!f) return -1;
+    const double tol = tolerancePct / 100.0;
+    int regressions = 0, matched = 0;
+    char line[1024];
+    if (!fgets(line, sizeof(line), f)) { fclose(f); return -1; } // header
+    while (fgets(line, sizeof(line), f)) {
+        ScalingConfig c;
+        char lra[8], backend[16];
+        int attachments, particles;
+        double buildMs, stepsPerSec;
+        if (sscanf(line, "%d,%d,%d,%7[^,],%15[^,],%d,%d,%d,%lf,%lf", &c.size, &c.pins, &c.iterations, lra, backend,
+                   &c.threads, &attachments, &particles, &buildMs, &stepsPerSec) != 10) continue;
+        for (const ScalingResult& r : results) {
+            const ScalingConfig& n = r.cfg;
+            if (n.size != c.size || n.pins != c.pins || n.iterations != c.iterations || n.threads != c.threads ||
+                strcmp(n.lra ? "on" : "off", lra) || strcmp(backendName(n.backend), backend)) continue;
+            ++matched;
+            bool slowerStep = r.stepsPerSec < stepsPerSec * (1.0 - tol - r.stepsSpreadPct / 100.0);
+            bool slowerBuild = r.buildMs > buildMs * (1.0 + tol + r.buildSpreadPct / 100.0);
+            if (slowerStep || slowerBuild) {
+                ++regressions;
+                printf("REGRESSION %dx%d pins %d iters %d LRA %s %s x%d: steps/sec %.1f -> %.1f (%+.1f%%), build %.2f -> %.2f ms (%+.1f%%)\n",
+                       c.size, c.size, c.pins, c.iterations, lra, backend, c.threads, stepsPerSec, r.stepsPerSec,
+                       100.0 * (r.stepsPerSec / stepsPerSec - 1.0), buildMs, r.buildMs, 100.0 * (r.buildMs / buildMs - 1.0));
+            }
+        }
+    }
+    fclose(f);
+    printf("Baseline %s: %d configurations compared, %d regressions (tolerance %.0f%%)\n", path, matched, regressions, tolerancePct);
+    return regressions;
+}
+
+int main(int argc, char** argv) {
+    ScalingOptions opt;
+    if (!parseArgs(argc, argv, opt)) {
+        usage();
+        return 1;
+    }
+    profiler().enabled = true; // per-phase ms/step columns
+    // The table goes to stderr when a machine-readable report is written to stdout
+    const bool quiet = (opt.csvPath && !strcmp(opt.csvPath, "-")) || (opt.jsonPath && !strcmp(opt.jsonPath, "-"));
+    FILE* out = quiet ? stderr : stdout;
+
+    fprintf(out, "LRA kernel: %s | cores: %u\n", lraSimdName(), std::max(1u, std::thread::hardware_concurrency()));
+    fprintf(out, "%-9s %5s %5s %4s %-7s %3s %10s %12s %6s %14s %9s %9s %10s\n",
+            "size", "pins", "iters", "LRA", "backend", "thr", "build ms", "steps/sec", "+-%", "ns/particle/it",
+            "+mem MB", "+peak MB", "maxStretch");
+
+    std::vector<ScalingResult> results;
+    bool gpuNoted = false;
+    for (int size : opt.sizes) {
+        for (int pins : opt.pins) {
+            for (int iters : opt.iterations) {
+                for (int lra : opt.lra) {
+                    for (int backend : opt.backends) {
+                        if (backend == BACKEND_GPU) {
+                            if (!gpuNoted) fprintf(out, "gpu: needs a GL 4.3 context, skipped (use the demo's G key)\n");
+                            gpuNoted = true;
+                            continue;
+                        }
+                        // Without LRA serial and simd run the same code
+                        if (!lra && backend == BACKEND_SIMD) continue;
+                        for (int threads : opt.threads) {
+                            ScalingConfig cfg = {size, pins, iters, lra, backend, threadedBackend(backend) ? threads : 1};
+                            ScalingResult r = runConfig(opt, cfg);
+                            results.push_back(r);
+
+                            char dim[32], thr[16];
+                            snprintf(dim, sizeof(dim), "%dx%d", size, size);
+                            snprintf(thr, sizeof(thr), "%d", solverPool().size());
+                            fprintf(out, "%-9s %5d %5d %4s %-7s %3s %10.2f %12.1f %6.1f %14.3f %9.1f %9.1f %9.2f%%\n",
+                                    dim, r.attachments, iters, lra ? "ON" : "OFF", backendName(backend), thr,
+                                    r.buildMs, r.stepsPerSec, r.stepsSpreadPct, r.nsPerParticleIter, r.memGrowthMB, r.peakGrowthMB,
+                                    100.0f * (r.maxStretch - 1.0f));
+                            if (!threadedBackend(backend)) break; // pool size does not matter
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    if (opt.csvPath && !writeCSV(opt.csvPath, results)) {
+        fprintf(stderr, "Could not write %s\n", opt.csvPath);
+        return 1;
+    }
+    if (opt.jsonPath && !writeJSON(opt.jsonPath, results, opt)) {
+        fprintf(stderr, "Could not write %s\n", opt.jsonPath);
+        return 1;
+    }
+    if (opt.baselinePath) {
+        int regressions = compareBaseline(opt.baselinePath, results, opt.tolerance);
+        if (regressions < 0) {
+            fprintf(stderr, "Could not read %s\n", opt.baselinePath);
+            return 1;
+        }
+        if (regressions > 0) return 2;
+    }
+    return 0;
+}
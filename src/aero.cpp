@@ -0,0 +1,366 @@
+// aero.cpp - Wind and per-triangle aerodynamic forces for the cloth integration step
+//
+// Force on a triangle with relative air velocity vr (particle minus air) and unit normal n, area A:
+//   drag = -1/2 rho Cd A (vr . n) |vr| n
+//   lift =  1/2 rho Cl A (vr . n) / |vr| * (n x vr) x vr, perpendicular to vr
+// With N = 2 A n the unnormalized normal and s = vr . N both fold into
+//   F = rho / 4 * s / |N| * (Cl s / |vr| vr - (Cd + Cl) |vr| N)
+// which needs one square root per factor and no cross product beyond N itself.
+
+#include "aero.h"
+#include "lra_simd.h"
+#include "build_scratch.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(LRA_SIMD_AVX2)
+#include <immintrin.h>
+#elif defined(LRA_SIMD_SSE2)
+#include <emmintrin.h>
+#elif defined(LRA_SIMD_NEON)
+#include <arm_neon.h>
+#endif
+
+// Keeps degenerate triangles and still air from dividing by zero
+static const float kAeroEps = 1e-9f;
+
+// ---------------------------------------------------------
+// Lanes
+// ---------------------------------------------------------
+// The passes below are plain vertical arithmetic on contiguous rows, written once over a lane
+// type: float for tails and meshes, the LRA_SIMD_WIDTH-wide register of lra_simd.h otherwise.
+
+namespace {
+
+inline float load(const float* p, float) { return *p; }
+inline void store(float* p, float a) { *p = a; }
+inline float splat(float a, float) { return a; }
+inline float vsqrt(float a) { return std::sqrt(a); }
+inline float vmin(float a, float b) { return std::min(a, b); }
+
+#if defined(LRA_SIMD_AVX2)
+struct Lanes { __m256 v; };
+inline Lanes load(const float* p, Lanes) { return {_mm256_loadu_ps(p)}; }
+inline void store(float* p, Lanes a) { _mm256_storeu_ps(p, a.v); }
+inline Lanes splat(float a, Lanes) { return {_mm256_set1_ps(a)}; }
+inline Lanes operator+(Lanes a, Lanes b) { return {_mm256_add_ps(a.v, b.v)}; }
+inline Lanes operator-(Lanes a, Lanes b) { return {_mm256_sub_ps(a.v, b.v)}; }
+inline Lanes operator*(Lanes a, Lanes b) { return {_mm256_mul_ps(a.v, b.v)}; }
+inline Lanes operator/(Lanes a, Lanes b) { return {_mm256_div_ps(a.v, b.v)}; }
+inline Lanes vsqrt(Lanes a) { return {_mm256_sqrt_ps(a.v)}; }
+inline Lanes vmin(Lanes a, Lanes b) { return {_mm256_min_ps(a.v, b.v)}; }
+#elif defined(LRA_SIMD_SSE2)
+struct Lanes { __m128 v; };
+inline Lanes load(const float* p, Lanes) { return {_mm_loadu_ps(p)}; }
+inline void store(float* p, Lanes a) { _mm_storeu_ps(p, a.v); }
+inline Lanes splat(float a, Lanes) { return {_mm_set1_ps(a)}; }
+inline Lanes operator+(Lanes a, Lanes b) { return {_mm_add_ps(a.v, b.v)}; }
+inline Lanes operator-(Lanes a, Lanes b) { return {_mm_sub_ps(a.v, b.v)}; }
+inline Lanes operator*(Lanes a, Lanes b) { return {_mm_mul_ps(a.v, b.v)}; }
+inline Lanes operator/(Lanes a, Lanes b) { return {_mm_div_ps(a.v, b.v)}; }
+inline Lanes vsqrt(Lanes a) { return {_mm_sqrt_ps(a.v)}; }
+inline Lanes vmin(Lanes a, Lanes b) { return {_mm_min_ps(a.v, b.v)}; }
+#elif defined(LRA_SIMD_NEON)
+struct Lanes { float32x4_t v; };
+inline Lanes load(const float* p, Lanes) { return {vld1q_f32(p)}; }
+inline void store(float* p, Lanes a) { vst1q_f32(p, a.v); }
+inline Lanes splat(float a, Lanes) { return {vdupq_n_f32(a)}; }
+inline Lanes operator+(Lanes a, Lanes b) { return {vaddq_f32(a.v, b.v)}; }
+inline Lanes operator-(Lanes a, Lanes b) { return {vsubq_f32(a.v, b.v)}; }
+inline Lanes operator*(Lanes a, Lanes b) { return {vmulq_f32(a.v, b.v)}; }
+inline Lanes operator/(Lanes a, Lanes b) { return {vdivq_f32(a.v, b.v)}; }
+inline Lanes vsqrt(Lanes a) { return {vsqrtq_f32(a.v)}; }
+inline Lanes vmin(Lanes a, Lanes b) { return {vminq_f32(a.v, b.v)}; }
+#else
+typedef float Lanes;
+#endif
+
+// Wind coefficients broadcast into one lane type
+template <class T>
+struct AeroConst {
+    T q, cl, cdl, third, eps;
+    explicit AeroConst(const WindField& w)
+        : q(splat(0.25f * w.airDensity, T())), cl(splat(w.lift, T())), cdl(splat(w.drag + w.lift, T())),
+          third(splat(1.0f / 3.0f, T())), eps(splat(kAeroEps, T())) {}
+};
+
+// Force on triangle (p0, p1, p2) from the relative velocities r0, r1, r2 of its corners
+template <class T>
+inline void triangleForce(const AeroConst<T>& k,
+                          T x0, T y0, T z0, T x1, T y1, T z1, T x2, T y2, T z2,
+                          T rx, T ry, T rz, T& fx, T& fy, T& fz) {
+    const T ax = x1 - x0, ay = y1 - y0, az = z1 - z0;
+    const T bx = x2 - x0, by = y2 - y0, bz = z2 - z0;
+    const T nx = ay * bz - az * by, ny = az * bx - ax * bz, nz = ax * by - ay * bx;
+    rx = rx * k.third; ry = ry * k.third; rz = rz * k.third;
+
+    const T nLen = vsqrt(nx * nx + ny * ny + nz * nz);
+    const T speed = vsqrt(rx * rx + ry * ry + rz * rz);
+    const T s = rx * nx + ry * ny + rz * nz;
+    const T a = k.q * s / (nLen + k.eps);
+    const T along = a * k.cl * s / (speed + k.eps);
+    const T normal = a * k.cdl * speed;
+    fx = along * rx - normal * nx;
+    fy = along * ry - normal * ny;
+    fz = along * rz - normal * nz;
+}
+
+// Sum of six triangle forces at a vertex turned into a velocity change, clamped to the vertex's
+// own relative air speed (explicit drag must not overshoot the air)
+template <class T>
+inline void vertexDelta(T fx, T fy, T fz, T gain, T& rx, T& ry, T& rz, T eps) {
+    T dx = fx * gain, dy = fy * gain, dz = fz * gain;
+    const T dv2 = dx * dx + dy * dy + dz * dz;
+    const T rv2 = rx * rx + ry * ry + rz * rz;
+    const T s = vmin(splat(1.0f, T()), vsqrt(rv2 / (dv2 + eps)));
+    rx = dx * s; ry = dy * s; rz = dz * s;
+}
+
+// ---------------------------------------------------------
+// Turbulence
+// ---------------------------------------------------------
+
+inline unsigned hashLattice(int x, int y, int z) {
+    unsigned h = (unsigned)x * 73856093u ^ (unsigned)y * 19349663u ^ (unsigned)z * 83492791u;
+    h ^= h >> 13;
+    h *= 0x5bd1e995u;
+    h ^= h >> 15;
+    return h;
+}
+
+// Three 10-bit components of one lattice hash, in [-1, 1]
+inline vec3 latticeValue(int x, int y, int z) {
+    const unsigned h = hashLattice(x, y, z);
+    const float s = 2.0f / 1023.0f;
+    return vec3((h & 1023u) * s - 1.0f, ((h >> 10) & 1023u) * s - 1.0f, ((h >> 20) & 1023u) * s - 1.0f);
+}
+
+// Value noise: a vector per integer lattice point, blended trilinearly with smoothstep weights.
+// corner(dx, dy, dz) returns the lattice vector at (floor(q) + d).
+template <class Corner>
+inline vec3 smoothTrilinear(float tx, float ty, float tz, Corner corner) {
+    tx = tx * tx * (3.0f - 2.0f * tx);
+    ty = ty * ty * (3.0f - 2.0f * ty);
+    tz = tz * tz * (3.0f - 2.0f * tz);
+    const float sx = 1.0f - tx, sy = 1.0f - ty, sz = 1.0f - tz;
+    return ((corner(0, 0, 0) * sx + corner(1, 0, 0) * tx) * sy + (corner(0, 1, 0) * sx + corner(1, 1, 0) * tx) * ty) * sz +
+           ((corner(0, 0, 1) * sx + corner(1, 0, 1) * tx) * sy + (corner(0, 1, 1) * sx + corner(1, 1, 1) * tx) * ty) * tz;
+}
+
+} // namespace
+
+// ---------------------------------------------------------
+// Cloth Aerodynamics Stage
+// ---------------------------------------------------------
+
+void ClothAero::build(int numParticles, int w, int h, const std::vector<int>& particleOf,
+                      const std::vector<int>& triangles, const vec3* rest, const ParticleStore& P) {
+    n = numParticles;
+    gridW = (w * h == n && w >= 2 && h >= 2) ? w : 0;
+    gridH = gridW ? h : 0;
+
+    particle.resize(n);
+    for (int k = 0; k < n; ++k) particle[k] = (gridW && !particleOf.empty()) ? particleOf[k] : k;
+    x.resize(n);  y.resize(n);  z.resize(n);
+    rx.resize(n); ry.resize(n); rz.resize(n);
+
+    // Lumped rest area: a third of every triangle around the vertex
+    auto restPos = [&](int i) { return rest ? rest[i] : P.position(i); };
+    std::vector<float>& area = invMass;
+    area.assign(n, 0.0f);
+    std::vector<int>& stagedOf = buildScratch().ints;
+    stagedOf.resize(n);
+    for (int k = 0; k < n; ++k) stagedOf[particle[k]] = k;
+    for (size_t t = 0; t + 2 < triangles.size(); t += 3) {
+        const int a = triangles[t], b = triangles[t + 1], c = triangles[t + 2];
+        const float A = 0.5f * glm::length(glm::cross(restPos(b) - restPos(a), restPos(c) - restPos(a)));
+        area[stagedOf[a]] += A / 3.0f;
+        area[stagedOf[b]] += A / 3.0f;
+        area[stagedOf[c]] += A / 3.0f;
+    }
+    for (float& m : invMass) m = (m > 0.0f) ? 1.0f / m : 0.0f;
+
+    if (gridW) {
+        const size_t cells = size_t(gridW + 1) * (gridH + 1);
+        for (auto* f : {&f0x, &f0y, &f0z, &f1x, &f1y, &f1z}) f->assign(cells, 0.0f);
+        tris.clear();
+        vertTriOffsets.clear();
+        vertTris.clear();
+    } else {
+        tris = triangles;
+        const size_t numT = tris.size() / 3;
+        ftx.resize(numT); fty.resize(numT); ftz.resize(numT);
+        vertTriOffsets.assign(n + 1, 0);
+        for (int i : tris) ++vertTriOffsets[i + 1];
+        for (int i = 0; i < n; ++i) vertTriOffsets[i + 1] += vertTriOffsets[i];
+        vertTris.resize(tris.size());
+        std::vector<int>& cursor = buildScratch().cursor;
+        cursor.assign(vertTriOffsets.begin(), vertTriOffsets.end() - 1);
+        for (size_t k = 0; k < tris.size(); ++k) vertTris[cursor[tris[k]]++] = (int)(k / 3);
+    }
+}
+
+void ClothAero::apply(const WindField& wind, ParticleStore& P, float h) {
+    if (n == 0 || (int)P.size() != n) return;
+    stage(wind, P);
+    if (gridW) gridForces(wind);
+    else meshForces(wind);
+    accumulate(P, h / (3.0f * std::max(wind.areaDensity, 1e-6f)));
+    time += h;
+}
+
+// Positions and relative velocities in staging order
+void ClothAero::stage(const WindField& wind, const ParticleStore& P) {
+    const vec3 u = wind.velocity;
+    for (int k = 0; k < n; ++k) {
+        const int i = particle[k];
+        x[k] = P.x[i];
+        y[k] = P.y[i];
+        z[k] = P.z[i];
+        rx[k] = P.vx[i] - u.x;
+        ry[k] = P.vy[i] - u.y;
+        rz[k] = P.vz[i] - u.z;
+    }
+    if (wind.turbulence > 0.0f) gusts(wind);
+}
+
+// Subtract the turbulent part of the air velocity. Gusts are carried along with the mean wind and
+// drift slowly through the lattice on their own. The lattice points around the cloth are hashed once
+// per substep, so a vertex only blends its eight cached corners.
+void ClothAero::gusts(const WindField& wind) {
+    const float invScale = 1.0f / std::max(wind.turbulenceScale, 1e-3f);
+    const vec3 offset = -wind.velocity * time * invScale + vec3(wind.turbulenceRate * time);
+    auto latticeCoord = [&](int k) {
+        return vec3(x[k] * invScale + offset.x, y[k] * invScale + offset.y, z[k] * invScale + offset.z);
+    };
+
+    float lo[3] = {x[0], y[0], z[0]}, hi[3] = {x[0], y[0], z[0]};
+    for (int k = 1; k < n; ++k) {
+        lo[0] = std::min(lo[0], x[k]); hi[0] = std::max(hi[0], x[k]);
+        lo[1] = std::min(lo[1], y[k]); hi[1] = std::max(hi[1], y[k]);
+        lo[2] = std::min(lo[2], z[k]); hi[2] = std::max(hi[2], z[k]);
+    }
+    const vec3 qlo = vec3(lo[0], lo[1], lo[2]) * invScale + offset, qhi = vec3(hi[0], hi[1], hi[2]) * invScale + offset;
+    const int ox = (int)std::floor(qlo.x), oy = (int)std::floor(qlo.y), oz = (int)std::floor(qlo.z);
+    const int nx = (int)std::floor(qhi.x) - ox + 2, ny = (int)std::floor(qhi.y) - oy + 2, nz = (int)std::floor(qhi.z) - oz + 2;
+    const float a = wind.turbulence;
+    if ((double)nx * ny * nz > std::max(n, 64)) {
+        // Cloth spread over far more gust cells than it has vertices: hash the corners directly
+        for (int k = 0; k < n; ++k) {
+            const vec3 q = latticeCoord(k);
+            const vec3 f(std::floor(q.x), std::floor(q.y), std::floor(q.z));
+            const int ix = (int)f.x, iy = (int)f.y, iz = (int)f.z;
+            const vec3 g = smoothTrilinear(q.x - f.x, q.y - f.y, q.z - f.z,
+                                           [&](int dx, int dy, int dz) { return latticeValue(ix + dx, iy + dy, iz + dz); });
+            rx[k] -= a * g.x; ry[k] -= a * g.y; rz[k] -= a * g.z;
+        }
+        return;
+    }
+
+    lattice.resize(size_t(nx) * ny * nz);
+    for (int cz = 0; cz < nz; ++cz)
+        for (int cy = 0; cy < ny; ++cy)
+            for (int cx = 0; cx < nx; ++cx) lattice[(cz * ny + cy) * nx + cx] = latticeValue(ox + cx, oy + cy, oz + cz);
+
+    // Coordinates relative to the lattice origin are non-negative, so truncation is floor
+    const vec3 base = offset - vec3((float)ox, (float)oy, (float)oz);
+    const int sy = nx, sz = nx * ny;
+    for (int k = 0; k < n; ++k) {
+        const float qx = std::max(0.0f, x[k] * invScale + base.x);
+        const float qy = std::max(0.0f, y[k] * invScale + base.y);
+        const float qz = std::max(0.0f, z[k] * invScale + base.z);
+        const int ix = std::min((int)qx, nx - 2), iy = std::min((int)qy, ny - 2), iz = std::min((int)qz, nz - 2);
+        const vec3* c = &lattice[iz * sz + iy * sy + ix];
+        const vec3 g = smoothTrilinear(qx - ix, qy - iy, qz - iz,
+                                       [&](int dx, int dy, int dz) { return c[dz * sz + dy * sy + dx]; });
+        rx[k] -= a * g.x; ry[k] -= a * g.y; rz[k] -= a * g.z;
+    }
+}
+
+// Both triangles of every cell: (x, y) (x, y + 1) (x + 1, y + 1) and (x, y) (x + 1, y + 1) (x + 1, y),
+// as buildGrid() emits them
+void ClothAero::gridForces(const WindField& wind) {
+    const AeroConst<float> k1(wind);
+    const AeroConst<Lanes> kw(wind);
+    const int W = gridW, stride = gridW + 1;
+    for (int cy = 0; cy + 1 < gridH; ++cy) {
+        const int a = cy * W, c = a + W;            // rows y and y + 1
+        const int out = (cy + 1) * stride + 1;      // border offset
+        auto cells = [&](const auto& k, int cx) {
+            typedef decltype(k.q) T;
+            const T ax = load(&x[a + cx], T()), ay = load(&y[a + cx], T()), az = load(&z[a + cx], T());
+            const T bx = load(&x[a + cx + 1], T()), by = load(&y[a + cx + 1], T()), bz = load(&z[a + cx + 1], T());
+            const T cx_ = load(&x[c + cx], T()), cy_ = load(&y[c + cx], T()), cz_ = load(&z[c + cx], T());
+            const T dx = load(&x[c + cx + 1], T()), dy = load(&y[c + cx + 1], T()), dz = load(&z[c + cx + 1], T());
+            const T rax = load(&rx[a + cx], T()), ray = load(&ry[a + cx], T()), raz = load(&rz[a + cx], T());
+            const T rbx = load(&rx[a + cx + 1], T()), rby = load(&ry[a + cx + 1], T()), rbz = load(&rz[a + cx + 1], T());
+            const T rcx = load(&rx[c + cx], T()), rcy = load(&ry[c + cx], T()), rcz = load(&rz[c + cx], T());
+            const T rdx = load(&rx[c + cx + 1], T()), rdy = load(&ry[c + cx + 1], T()), rdz = load(&rz[c + cx + 1], T());
+            T fx, fy, fz;
+            triangleForce(k, ax, ay, az, cx_, cy_, cz_, dx, dy, dz, rax + rcx + rdx, ray + rcy + rdy, raz + rcz + rdz, fx, fy, fz);
+            store(&f0x[out + cx], fx); store(&f0y[out + cx], fy); store(&f0z[out + cx], fz);
+            triangleForce(k, ax, ay, az, dx, dy, dz, bx, by, bz, rax + rdx + rbx, ray + rdy + rby, raz + rdz + rbz, fx, fy, fz);
+            store(&f1x[out + cx], fx); store(&f1y[out + cx], fy); store(&f1z[out + cx], fz);
+        };
+        int cx = 0;
+        for (; LRA_SIMD_WIDTH > 1 && cx + LRA_SIMD_WIDTH <= W - 1; cx += LRA_SIMD_WIDTH) cells(kw, cx);
+        for (; cx < W - 1; ++cx) cells(k1, cx);
+    }
+}
+
+void ClothAero::meshForces(const WindField& wind) {
+    const AeroConst<float> k(wind);
+    const int numT = (int)tris.size() / 3;
+    for (int t = 0; t < numT; ++t) {
+        const int a = tris[3 * t], b = tris[3 * t + 1], c = tris[3 * t + 2];
+        triangleForce(k, x[a], y[a], z[a], x[b], y[b], z[b], x[c], y[c], z[c],
+                      rx[a] + rx[b] + rx[c], ry[a] + ry[b] + ry[c], rz[a] + rz[b] + rz[c], ftx[t], fty[t], ftz[t]);
+    }
+}
+
+// Every vertex sums the triangles around it (a gather, so lanes never share a destination), then
+// the velocity changes go back to the particles in one pass
+void ClothAero::accumulate(ParticleStore& P, float scale) {
+    if (gridW) {
+        const int W = gridW, stride = gridW + 1;
+        const Lanes gw = splat(scale, Lanes()), ew = splat(kAeroEps, Lanes());
+        for (int vy = 0; vy < gridH; ++vy) {
+            const int row = vy * W;
+            const int cur = (vy + 1) * stride + 1, prev = vy * stride + 1; // cells (x, y) and (x, y - 1)
+            auto vertices = [&](auto g, auto eps, int vx) {
+                typedef decltype(g) T;
+                auto sum = [&](const std::vector<float>& f0, const std::vector<float>& f1) {
+                    // (x, y): both, (x - 1, y): second, (x, y - 1): first, (x - 1, y - 1): both
+                    return load(&f0[cur + vx], T()) + load(&f1[cur + vx], T()) + load(&f1[cur + vx - 1], T()) +
+                           load(&f0[prev + vx], T()) + load(&f0[prev + vx - 1], T()) + load(&f1[prev + vx - 1], T());
+                };
+                const T fx = sum(f0x, f1x), fy = sum(f0y, f1y), fz = sum(f0z, f1z);
+                T rx_ = load(&rx[row + vx], T()), ry_ = load(&ry[row + vx], T()), rz_ = load(&rz[row + vx], T());
+                vertexDelta(fx, fy, fz, g * load(&invMass[row + vx], T()), rx_, ry_, rz_, eps);
+                store(&rx[row + vx], rx_); store(&ry[row + vx], ry_); store(&rz[row + vx], rz_);
+            };
+            int vx = 0;
+            for (; LRA_SIMD_WIDTH > 1 && vx + LRA_SIMD_WIDTH <= W; vx += LRA_SIMD_WIDTH) vertices(gw, ew, vx);
+            for (; vx < W; ++vx) vertices(scale, kAeroEps, vx);
+        }
+    } else {
+        for (int i = 0; i < n; ++i) {
+            float fx = 0.0f, fy = 0.0f, fz = 0.0f;
+            for (int e = vertTriOffsets[i]; e < vertTriOffsets[i + 1]; ++e) {
+                const int t = vertTris[e];
+                fx += ftx[t]; fy += fty[t]; fz += ftz[t];
+            }
+            vertexDelta(fx, fy, fz, scale * invMass[i], rx[i], ry[i], rz[i], kAeroEps);
+        }
+    }
+
+    // Staged rx/ry/rz now hold the velocity changes; pinned and sleeping particles have w = 0
+    for (int k = 0; k < n; ++k) {
+        const int i = particle[k];
+        if (P.w[i] <= 0.0f) continue;
+        P.vx[i] += rx[k];
+        P.vy[i] += ry[k];
+        P.vz[i] += rz[k];
+    }
+}
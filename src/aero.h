@@ -0,0 +1,70 @@
+// aero.h - Wind and per-triangle aerodynamic forces for the cloth integration step
+//
+// Every substep, before integration, each triangle feels drag along its normal and lift across the
+// relative air flow, from a uniform wind plus value-noise turbulence sampled at its corners. On grid
+// cloths the triangles follow idx(x, y), so both the triangle pass and the per-vertex sum read the
+// cached state as contiguous rows and run LRA_SIMD_WIDTH cells per instruction. Each vertex gathers
+// the forces of the six triangles around it instead of triangles scattering into vertices, so no two
+// lanes ever write the same particle. Other meshes take a scalar path over ClothInstance::triangles.
+
+#pragma once
+
+#include "cloth_types.h"
+
+#include <vector>
+
+// Air around one cloth, in world space. Update it every frame like the colliders; call
+// ClothInstance::wake() after switching it on for a sleeping cloth (a cloth in wind never sleeps).
+struct WindField {
+    vec3 velocity = vec3(0.0f);    // mean wind (m/s)
+    float turbulence = 0.0f;       // gust amplitude per axis (m/s); 0 skips the noise
+    float turbulenceScale = 1.0f;  // gust size (m)
+    float turbulenceRate = 0.5f;   // how fast gusts change while carried along by the wind (1/s)
+    float drag = 1.0f;             // drag coefficient, along the triangle normal
+    float lift = 0.6f;             // lift coefficient, across the relative flow
+    float airDensity = 1.2f;       // kg/m^3
+    float areaDensity = 0.2f;      // cloth mass per rest area (kg/m^2), lumped to the vertices
+
+    bool active() const { return velocity != vec3(0.0f) || turbulence > 0.0f; }
+};
+
+// Aerodynamics stage of one cloth: per-vertex lumped mass and the scratch rows of the passes.
+// build() once per topology, apply() once per substep; apply() allocates nothing.
+class ClothAero {
+public:
+    // `particleOf` maps build-order vertices to particles (empty = identity); `rest` is the rest
+    // state in particle order (null = current positions). Grid cloths pass their w x h size,
+    // anything else 0 x 0 and is driven by `triangles`.
+    void build(int numParticles, int gridW, int gridH, const std::vector<int>& particleOf,
+               const std::vector<int>& triangles, const vec3* rest, const ParticleStore& P);
+
+    // Add h seconds of aerodynamic acceleration to the velocities of the free, awake particles
+    // (w > 0). No vertex is sped past the air around it in one substep.
+    void apply(const WindField& wind, ParticleStore& P, float h);
+
+    unsigned version = ~0u; // ClothInstance::topologyVersion of the last build()
+
+private:
+    void stage(const WindField& wind, const ParticleStore& P);
+    void gusts(const WindField& wind);
+    void gridForces(const WindField& wind);
+    void meshForces(const WindField& wind);
+    void accumulate(ParticleStore& P, float h);
+
+    int n = 0, gridW = 0, gridH = 0;
+    float time = 0.0f;                // seconds of wind applied, drives the turbulence
+    std::vector<int> particle;        // particle of each staged vertex (grid order on grids)
+    std::vector<float> x, y, z;       // staged positions
+    std::vector<float> rx, ry, rz;    // staged velocities relative to the air
+    std::vector<float> invMass;       // per staged vertex, 1 / lumped rest area (areaDensity applied in apply())
+    std::vector<vec3> lattice;        // turbulence values around the cloth, refreshed every apply()
+
+    // Grids: two triangles per cell in (gridW + 1) x (gridH + 1) rows with a zero border, so the
+    // vertex pass reads its six neighbours without bounds checks
+    std::vector<float> f0x, f0y, f0z, f1x, f1y, f1z;
+
+    // Meshes: force per triangle and the triangles around each vertex (CSR)
+    std::vector<int> tris;
+    std::vector<float> ftx, fty, ftz;
+    std::vector<int> vertTriOffsets, vertTris;
+};
@@ -0,0 +1,9 @@
+// build_scratch.cpp - Per-thread temporary buffers for cloth (re)builds
+
+#include "build_scratch.h"
+
+BuildScratch& buildScratch() {
+    // Per thread: ClothWorld steps instances in parallel and a step may rebuild its sleep tiles
+    thread_local BuildScratch scratch;
+    return scratch;
+}
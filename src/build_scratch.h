@@ -0,0 +1,39 @@
+// build_scratch.h - Per-thread temporary buffers for cloth (re)builds
+//
+// buildScene(), optimizeLayout(), the geodesic passes and the sleep tiles need temporaries of
+// particle or edge count. They borrow them from here instead of allocating, so rebuilding a
+// cloth at a size the thread has built before (respawn, 'R' reset) never touches the heap.
+// The buffers grow to the largest cloth built on the thread and are not shrunk.
+
+#pragma once
+
+#include "cloth_types.h"
+#include "geodesic.h"
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+struct BuildScratch {
+    std::vector<vec3> rest;           // buildScene(): rest positions handed to buildGrid()
+    std::vector<int> pinned;          // buildScene(): pinned grid vertices
+    std::vector<int> order, newOf;    // optimizeLayout(): permutation and its inverse
+    std::vector<uint64_t> keys;       // mortonOrder(): (code, index) sort keys
+    std::vector<float> floats;        // permuteParticles() / GeodesicField::remap() staging
+    std::vector<int> ints;
+    std::vector<unsigned char> bytes;
+    std::vector<vec3> vecs;
+    std::vector<int> cursor;          // GeodesicField adjacency fill
+    std::vector<int> sources;         // single-source geodesic passes
+    std::vector<int> bestA;           // K nearest attachments per particle (emitTethers(), retetherRegion())
+    std::vector<float> bestD;
+    std::vector<int> border;          // retetherRegion(): vertices around the region
+    std::vector<GeodesicField::RegionSeed> seeds; // retetherRegion(): their known attachment distances
+    GeodesicField single;             // per-attachment field for K > 1 tethers
+    std::vector<std::pair<int, int>> tilePairs, tileEdges; // buildSleepTiles()
+    std::vector<uint64_t> edgeKeys;   // buildMesh(): (i, j) of every triangle side
+    std::vector<std::pair<uint64_t, int>> hinges; // buildMesh(): triangle side and its opposite corner
+};
+
+// The calling thread's scratch. Borrowers must not call anything that borrows the same buffer.
+BuildScratch& buildScratch();
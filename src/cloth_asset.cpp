@@ -0,0 +1,328 @@
+// cloth_asset.cpp - Baked, memory-mapped cloth assets
+
+#include "cloth_asset.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const uint32_t kByteOrderTag = 0x01020304;
+static const uint64_t kAlign = 16;
+
+static uint64_t alignUp(uint64_t v) { return (v + kAlign - 1) & ~(kAlign - 1); }
+
+// ---------------------------------------------------------
+// Bake
+// ---------------------------------------------------------
+
+namespace {
+
+struct PendingSection {
+    uint32_t id;
+    uint32_t elemSize;
+    uint64_t count;
+    const void* data;
+};
+
+template <typename T>
+PendingSection sectionOf(ClothAssetSectionId id, const T* data, size_t count) {
+    return {id, (uint32_t)sizeof(T), (uint64_t)count, data};
+}
+
+template <typename T>
+PendingSection sectionOf(ClothAssetSectionId id, const std::vector<T>& v) {
+    return sectionOf(id, v.data(), v.size());
+}
+
+} // namespace
+
+bool bakeClothAsset(const ClothInstance& cloth, const char* path) {
+    const ParticleStore& P = cloth.P;
+    const GeodesicField& geo = cloth.geodesic;
+    const size_t geoCount = (geo.size() == (int)P.size()) ? (size_t)geo.size() : 0;
+
+    const PendingSection pending[] = {
+        sectionOf(ASSET_POS_X, P.x),
+        sectionOf(ASSET_POS_Y, P.y),
+        sectionOf(ASSET_POS_Z, P.z),
+        sectionOf(ASSET_INV_MASS, P.w),
+        sectionOf(ASSET_PINNED, P.pinned),
+        sectionOf(ASSET_EDGES, cloth.localConstraints),
+        sectionOf(ASSET_COLOR_OFFSETS, cloth.localColorOffsets),
+        sectionOf(ASSET_TRIANGLES, cloth.triangles),
+        sectionOf(ASSET_LRA, cloth.lraConstraints),
+        sectionOf(ASSET_LRA_OF_PARTICLE, cloth.lraOfParticle),
+        sectionOf(ASSET_ATTACHMENTS, cloth.attachmentIndices),
+        sectionOf(ASSET_SOURCE_TO_PARTICLE, cloth.sourceToParticle),
+        sectionOf(ASSET_GEO_REST, geo.restData(), geoCount),
+        sectionOf(ASSET_GEO_ANCHOR, geo.anchorData(), geoCount),
+        sectionOf(ASSET_GEO_DIST, geo.distanceData(), geoCount),
+    };
+    const uint32_t numSections = sizeof(pending) / sizeof(pending[0]);
+
+    ClothAssetHeader header = {};
+    memcpy(header.magic, "LRAC", 4);
+    header.version = kClothAssetVersion;
+    header.byteOrder = kByteOrderTag;
+    header.sectionCount = numSections;
+    header.gridW = cloth.gridW;
+    header.gridH = cloth.gridH;
+    header.tethersPerParticle = cloth.tethersPerParticle;
+
+    std::vector<ClothAssetSection> table(numSections);
+    uint64_t offset = alignUp(sizeof(ClothAssetHeader) + numSections * sizeof(ClothAssetSection));
+    for (uint32_t k = 0; k < numSections; ++k) {
+        table[k] = {pending[k].id, pending[k].elemSize, offset, pending[k].count};
+        offset = alignUp(offset + pending[k].elemSize * pending[k].count);
+    }
+    header.fileSize = offset;
+
+    FILE* f = fopen(path, "wb");
+    if (!f) return false;
+    static const uint8_t zeros[kAlign] = {};
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1 &&
+              fwrite(table.data(), sizeof(ClothAssetSection), numSections, f) == numSections;
+    uint64_t written = sizeof(header) + numSections * sizeof(ClothAssetSection);
+    for (uint32_t k = 0; ok && k < numSections; ++k) {
+        ok = fwrite(zeros, 1, table[k].offset - written, f) == table[k].offset - written;
+        size_t bytes = (size_t)(pending[k].elemSize * pending[k].count);
+        ok = ok && (bytes == 0 || fwrite(pending[k].data, 1, bytes, f) == bytes);
+        written = table[k].offset + bytes;
+    }
+    ok = ok && fwrite(zeros, 1, header.fileSize - written, f) == header.fileSize - written;
+    return (fclose(f) == 0) && ok;
+}
+
+// ---------------------------------------------------------
+// Load
+// ---------------------------------------------------------
+
+bool ClothAsset::open(const char* path) {
+    close();
+
+#if defined(_WIN32)
+    HANDLE fh = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (fh == INVALID_HANDLE_VALUE) {
+        printf("%s: cannot open\n", path);
+        return false;
+    }
+    LARGE_INTEGER size;
+    GetFileSizeEx(fh, &size);
+    HANDLE mh = size.QuadPart ? CreateFileMappingA(fh, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+    const void* view = mh ? MapViewOfFile(mh, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!view) {
+        if (mh) CloseHandle(mh);
+        CloseHandle(fh);
+        printf("%s: cannot map\n", path);
+        return false;
+    }
+    file = fh;
+    mapping = mh;
+    base = static_cast<const uint8_t*>(view);
+    bytes = (size_t)size.QuadPart;
+#else
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) {
+        printf("%s: cannot open\n", path);
+        return false;
+    }
+    struct stat st;
+    void* view = (fstat(fd, &st) == 0 && st.st_size > 0)
+               ? mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+    ::close(fd); // the mapping keeps the file alive
+    if (view == MAP_FAILED) {
+        printf("%s: cannot map\n", path);
+        return false;
+    }
+    base = static_cast<const uint8_t*>(view);
+    bytes = (size_t)st.st_size;
+#endif
+
+    if (!validate(path)) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void ClothAsset::close() {
+    if (!base) return;
+#if defined(_WIN32)
+    UnmapViewOfFile(base);
+    CloseHandle((HANDLE)mapping);
+    CloseHandle((HANDLE)file);
+    file = mapping = nullptr;
+#else
+    munmap(const_cast<uint8_t*>(base), bytes);
+#endif
+    base = nullptr;
+    bytes = 0;
+}
+
+bool ClothAsset::validate(const char* path) const {
+    if (bytes < sizeof(ClothAssetHeader)) {
+        printf("%s: truncated header\n", path);
+        return false;
+    }
+    const ClothAssetHeader& h = header();
+    if (memcmp(h.magic, "LRAC", 4) != 0) {
+        printf("%s: not a cloth asset\n", path);
+        return false;
+    }
+    if (h.byteOrder != kByteOrderTag || h.version != kClothAssetVersion) {
+        printf("%s: version %u (byte order %08x), expected %u; re-bake it\n", path, h.version, h.byteOrder, kClothAssetVersion);
+        return false;
+    }
+    if (h.fileSize != bytes || sizeof(ClothAssetHeader) + h.sectionCount * sizeof(ClothAssetSection) > bytes) {
+        printf("%s: size mismatch\n", path);
+        return false;
+    }
+    const ClothAssetSection* table = reinterpret_cast<const ClothAssetSection*>(base + sizeof(ClothAssetHeader));
+    for (uint32_t k = 0; k < h.sectionCount; ++k) {
+        const ClothAssetSection& s = table[k];
+        if (s.offset % kAlign != 0 || s.offset > bytes || s.elemSize == 0 || s.count > (bytes - s.offset) / s.elemSize) {
+            printf("%s: section %u out of bounds\n", path, s.id);
+            return false;
+        }
+    }
+
+    // Cross-check what instantiate() relies on
+    size_t n = 0, c = 0;
+    section<float>(ASSET_POS_X, n);
+    for (ClothAssetSectionId id : {ASSET_POS_Y, ASSET_POS_Z, ASSET_INV_MASS}) {
+        if (!section<float>(id, c) || c != n) {
+            printf("%s: particle sections disagree\n", path);
+            return false;
+        }
+    }
+    if (!section<unsigned char>(ASSET_PINNED, c) || c != n || !section<int>(ASSET_LRA_OF_PARTICLE, c) || c != n ||
+        !section<LocalConstraint>(ASSET_EDGES, c) || !section<LRAConstraint>(ASSET_LRA, c)) {
+        printf("%s: missing or mis-sized sections\n", path);
+        return false;
+    }
+    if (!validIndices()) {
+        printf("%s: index out of range\n", path);
+        return false;
+    }
+    return true;
+}
+
+// Every particle, constraint and tether index the solver follows without checks. Sizes are
+// already validated.
+bool ClothAsset::validIndices() const {
+    size_t n = 0, count = 0, numEdges = 0, numTethers = 0;
+    section<float>(ASSET_POS_X, n);
+    auto particle = [n](int i) { return i >= 0 && (size_t)i < n; };
+
+    const LocalConstraint* edges = section<LocalConstraint>(ASSET_EDGES, numEdges);
+    for (size_t k = 0; k < numEdges; ++k) {
+        if (!particle(edges[k].i) || !particle(edges[k].j) || !(edges[k].restLen > 0.0f)) return false;
+    }
+    const int* offsets = section<int>(ASSET_COLOR_OFFSETS, count);
+    for (size_t k = 0; k < count; ++k) {
+        if (offsets[k] < (k ? offsets[k - 1] : 0) || (size_t)offsets[k] > numEdges) return false;
+    }
+    if (count && (offsets[0] != 0 || (size_t)offsets[count - 1] != numEdges)) return false;
+
+    const int* tris = section<int>(ASSET_TRIANGLES, count);
+    if (count % 3 != 0) return false;
+    for (size_t k = 0; k < count; ++k) {
+        if (!particle(tris[k])) return false;
+    }
+
+    const int K = std::max(1, (int)header().tethersPerParticle);
+    const LRAConstraint* tethers = section<LRAConstraint>(ASSET_LRA, numTethers);
+    if (numTethers % K != 0) return false;
+    for (size_t k = 0; k < numTethers; ++k) {
+        if (!particle(tethers[k].particleIdx) || !particle(tethers[k].attachmentIdx)) return false;
+    }
+    const int* lraOf = section<int>(ASSET_LRA_OF_PARTICLE, count);
+    for (size_t k = 0; k < count; ++k) {
+        if (lraOf[k] != -1 && (lraOf[k] < 0 || (size_t)lraOf[k] + K > numTethers)) return false;
+    }
+
+    const int* attachments = section<int>(ASSET_ATTACHMENTS, count);
+    for (size_t k = 0; k < count; ++k) {
+        if (!particle(attachments[k])) return false;
+    }
+    const int* order = section<int>(ASSET_SOURCE_TO_PARTICLE, count);
+    if (count && count != n) return false;
+    for (size_t k = 0; k < count; ++k) {
+        if (!particle(order[k])) return false;
+    }
+    const int* anchor = section<int>(ASSET_GEO_ANCHOR, count);
+    for (size_t k = 0; k < count; ++k) {
+        if (anchor[k] != -1 && !particle(anchor[k])) return false;
+    }
+    return true;
+}
+
+const ClothAssetSection* ClothAsset::find(uint32_t id, size_t elemSize) const {
+    if (!base) return nullptr;
+    const ClothAssetSection* table = reinterpret_cast<const ClothAssetSection*>(base + sizeof(ClothAssetHeader));
+    for (uint32_t k = 0; k < header().sectionCount; ++k) {
+        if (table[k].id == id) return table[k].elemSize == elemSize ? &table[k] : nullptr;
+    }
+    return nullptr;
+}
+
+template <typename T>
+static void copySection(const ClothAsset& asset, ClothAssetSectionId id, std::vector<T>& out) {
+    size_t count = 0;
+    const T* data = asset.section<T>(id, count);
+    out.assign(data, data + count);
+}
+
+void ClothAsset::instantiate(ClothInstance& cloth) const {
+    ParticleStore& P = cloth.P;
+    copySection(*this, ASSET_POS_X, P.x);
+    copySection(*this, ASSET_POS_Y, P.y);
+    copySection(*this, ASSET_POS_Z, P.z);
+    copySection(*this, ASSET_INV_MASS, P.w);
+    copySection(*this, ASSET_PINNED, P.pinned);
+    P.px = P.x;
+    P.py = P.y;
+    P.pz = P.z;
+    P.vx.assign(P.size(), 0.0f);
+    P.vy.assign(P.size(), 0.0f);
+    P.vz.assign(P.size(), 0.0f);
+
+    copySection(*this, ASSET_EDGES, cloth.localConstraints);
+    copySection(*this, ASSET_COLOR_OFFSETS, cloth.localColorOffsets);
+    copySection(*this, ASSET_TRIANGLES, cloth.triangles);
+    copySection(*this, ASSET_LRA, cloth.lraConstraints);
+    copySection(*this, ASSET_LRA_OF_PARTICLE, cloth.lraOfParticle);
+    copySection(*this, ASSET_ATTACHMENTS, cloth.attachmentIndices);
+    cloth.skin.clear();
+    cloth.sleep.clear();
+    cloth.local.clear();
+    copySection(*this, ASSET_SOURCE_TO_PARTICLE, cloth.sourceToParticle);
+    cloth.gridW = header().gridW;
+    cloth.gridH = header().gridH;
+    cloth.tethersPerParticle = std::max(1, (int)header().tethersPerParticle);
+    cloth.tornEdges = 0;
+
+    // Geodesic result only; adjacency is built on the first pin change
+    size_t geoCount = 0, anchorCount = 0, distCount = 0;
+    const vec3* rest = section<vec3>(ASSET_GEO_REST, geoCount);
+    const int* anchor = section<int>(ASSET_GEO_ANCHOR, anchorCount);
+    const float* dist = section<float>(ASSET_GEO_DIST, distCount);
+    if (rest && anchor && dist && geoCount == P.size() && anchorCount == geoCount && distCount == geoCount) {
+        cloth.geodesic.restore(rest, anchor, dist, (int)geoCount);
+    } else {
+        cloth.geodesic.build(P, cloth.localConstraints, cloth.triangles);
+        cloth.geodesic.compute(cloth.attachmentIndices);
+    }
+    ++cloth.topologyVersion;
+}
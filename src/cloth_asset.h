@@ -0,0 +1,96 @@
+// cloth_asset.h - Baked, memory-mapped cloth assets
+//
+// bakeClothAsset() writes everything buildScene() derives (particles, colour-ordered local
+// constraints, triangles, LRA constraints, the geodesic field and the layout permutation) to a
+// versioned binary file of 16-byte aligned sections. ClothAsset maps the file read-only and hands
+// out typed views straight into the mapping, with every index range-checked once by open().
+// instantiate() fills a ClothInstance with one bulk copy per section and no geodesic pass,
+// colouring or layout pass. Each instance owns its copy, since pins, compliance and tearing edit
+// the constraints; only the mapping itself (and the page cache behind it) is shared.
+//
+// File layout: ClothAssetHeader, ClothAssetSection[sectionCount], section payloads.
+// Little-endian; a file written on another byte order or by another version is rejected.
+
+#pragma once
+
+#include "simulation.h"
+
+#include <cstddef>
+#include <cstdint>
+
+static const uint32_t kClothAssetVersion = 3; // 2: tethersPerParticle, 3: edge compliance
+
+enum ClothAssetSectionId : uint32_t {
+    ASSET_POS_X = 1, ASSET_POS_Y, ASSET_POS_Z, // float, rest positions
+    ASSET_INV_MASS,                            // float
+    ASSET_PINNED,                              // uint8
+    ASSET_EDGES,                               // LocalConstraint, grouped by colour
+    ASSET_COLOR_OFFSETS,                       // int
+    ASSET_TRIANGLES,                           // int, 3 per triangle
+    ASSET_LRA,                                 // LRAConstraint
+    ASSET_LRA_OF_PARTICLE,                     // int
+    ASSET_ATTACHMENTS,                         // int
+    ASSET_SOURCE_TO_PARTICLE,                  // int (empty when no layout pass ran)
+    ASSET_GEO_REST,                            // vec3
+    ASSET_GEO_ANCHOR,                          // int
+    ASSET_GEO_DIST,                            // float
+};
+
+struct ClothAssetHeader {
+    char magic[4];          // "LRAC"
+    uint32_t version;       // kClothAssetVersion
+    uint32_t byteOrder;     // 0x01020304 as written
+    uint32_t sectionCount;
+    int32_t gridW, gridH;   // 0 for non-grid meshes
+    int32_t tethersPerParticle;
+    uint32_t reserved;
+    uint64_t fileSize;
+};
+
+struct ClothAssetSection {
+    uint32_t id;
+    uint32_t elemSize;      // bytes per element, checked against the reader's types
+    uint64_t offset;        // from the start of the file, 16-byte aligned
+    uint64_t count;
+};
+
+// Write `cloth` in its current state (normally straight after buildScene()). Returns false on I/O error.
+bool bakeClothAsset(const ClothInstance& cloth, const char* path);
+
+class ClothAsset {
+public:
+    ClothAsset() = default;
+    ~ClothAsset() { close(); }
+    ClothAsset(const ClothAsset&) = delete;
+    ClothAsset& operator=(const ClothAsset&) = delete;
+
+    // Map and validate `path`; prints the reason and returns false if it is not a usable asset
+    bool open(const char* path);
+    void close();
+    bool isOpen() const { return base != nullptr; }
+
+    const ClothAssetHeader& header() const { return *reinterpret_cast<const ClothAssetHeader*>(base); }
+
+    // View of section `id` inside the mapping; nullptr / 0 if absent
+    template <typename T>
+    const T* section(ClothAssetSectionId id, size_t& count) const {
+        const ClothAssetSection* s = find(id, sizeof(T));
+        count = s ? (size_t)s->count : 0;
+        return s ? reinterpret_cast<const T*>(base + s->offset) : nullptr;
+    }
+
+    // Replace `cloth` with a fresh copy of the baked state (zero velocity)
+    void instantiate(ClothInstance& cloth) const;
+
+private:
+    const ClothAssetSection* find(uint32_t id, size_t elemSize) const;
+    bool validate(const char* path) const;
+    bool validIndices() const;
+
+    const uint8_t* base = nullptr;
+    size_t bytes = 0;
+#if defined(_WIN32)
+    void* file = nullptr;
+    void* mapping = nullptr;
+#endif
+};
@@ -0,0 +1,28 @@
+// cloth_commands.cpp - Batched runtime edits of one cloth, applied at step boundaries
+
+#include "cloth_commands.h"
+
+void CommandQueue::push(const ClothCommand& c) {
+    std::lock_guard<std::mutex> lock(mutex);
+    queued.push_back(c);
+    if (c.editsCloth()) hasEdits.store(true, std::memory_order_release);
+    hasPending.store(true, std::memory_order_release);
+}
+
+const std::vector<ClothCommand>& CommandQueue::take() {
+    batch.clear();
+    if (!pending()) return batch; // the common case: no lock per step
+    std::lock_guard<std::mutex> lock(mutex);
+    batch.swap(queued);
+    hasEdits.store(false, std::memory_order_release);
+    hasPending.store(false, std::memory_order_release);
+    return batch;
+}
+
+void CommandQueue::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    queued.clear();
+    batch.clear();
+    hasEdits.store(false, std::memory_order_release);
+    hasPending.store(false, std::memory_order_release);
+}
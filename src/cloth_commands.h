@@ -0,0 +1,94 @@
+// cloth_commands.h - Batched runtime edits of one cloth, applied at step boundaries
+//
+// Gameplay code on any thread push()es parameter changes, pins, impulses, teleports and wind into the
+// cloth's queue; ClothInstance::simulate() takes the whole batch at the start of the next step and
+// applies it in push order. The queue's mutex is only held for a push or a buffer swap, never
+// across the solver, so producers do not wait on a step in progress.
+
+#pragma once
+
+#include "cloth_types.h"
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+// Fields of SolverParams (simulation.h) a SET_PARAM command can change
+enum SolverParam {
+    PARAM_SOLVER_MODE = 0,
+    PARAM_ITERATIONS,
+    PARAM_ITERATION_MODE,
+    PARAM_ITERATION_TOLERANCE,
+    PARAM_MAX_ITERATIONS,
+    PARAM_SUBSTEPS,
+    PARAM_USE_LRA,
+    PARAM_LRA_SLACK,
+    PARAM_LRA_SIMD,
+    PARAM_SLEEP,
+    PARAM_SLEEP_VELOCITY,
+    PARAM_SLEEP_STEPS,
+    PARAM_SELF_COLLISION,
+    PARAM_COLLISION_THICKNESS,
+    PARAM_JACOBI_RELAXATION,
+    PARAM_TEAR_STRAIN,
+    PARAM_COUNT
+};
+
+struct ClothCommand {
+    enum Type {
+        SET_PARAM,  // param = value (integer and flag fields are rounded / tested against 0)
+        PIN,        // pin source vertex `vertex` where it currently is
+        UNPIN,      // release it
+        IMPULSE,    // add velocity `v` to source vertex `vertex`, or to every free particle if -1
+        TELEPORT,   // move the whole cloth (and its skinned anchor targets) by `v`, keeping velocities
+        WIND,       // mean wind velocity = `v` (ClothInstance::wind)
+        COMPLIANCE, // every edge's XPBD compliance = value (ClothInstance::setCompliance())
+        TETHERS,    // `vertex` LRA tethers per particle (ClothInstance::setTethersPerParticle())
+    };
+    Type type;
+    SolverParam param;
+    int vertex;
+    float value;
+    vec3 v;
+
+    // Acts on particles or constraints, not only on settings (SET_PARAM, WIND)
+    bool editsCloth() const { return type != SET_PARAM && type != WIND; }
+};
+
+// Multi-producer, single-consumer. Vertices are build-order (source) indices, which stay valid
+// across optimizeLayout(); see ClothInstance::particleOf().
+class CommandQueue {
+public:
+    CommandQueue() = default;
+    // A copied cloth starts with an empty queue of its own
+    CommandQueue(const CommandQueue&) {}
+    CommandQueue& operator=(const CommandQueue&) { return *this; }
+
+    void push(const ClothCommand& c);
+
+    void setParam(SolverParam p, float value) { push({ClothCommand::SET_PARAM, p, -1, value, vec3(0.0f)}); }
+    void pin(int vertex) { push({ClothCommand::PIN, PARAM_COUNT, vertex, 0.0f, vec3(0.0f)}); }
+    void unpin(int vertex) { push({ClothCommand::UNPIN, PARAM_COUNT, vertex, 0.0f, vec3(0.0f)}); }
+    void impulse(int vertex, const vec3& dv) { push({ClothCommand::IMPULSE, PARAM_COUNT, vertex, 0.0f, dv}); }
+    void teleport(const vec3& offset) { push({ClothCommand::TELEPORT, PARAM_COUNT, -1, 0.0f, offset}); }
+    void setWind(const vec3& velocity) { push({ClothCommand::WIND, PARAM_COUNT, -1, 0.0f, velocity}); }
+    void setCompliance(float compliance) { push({ClothCommand::COMPLIANCE, PARAM_COUNT, -1, compliance, vec3(0.0f)}); }
+    void setTethers(int K) { push({ClothCommand::TETHERS, PARAM_COUNT, K, 0.0f, vec3(0.0f)}); }
+
+    // Consumer: everything pushed so far, in push order, valid until the next take(). The two
+    // buffers swap roles and keep their capacity, so a steady command rate never allocates.
+    const std::vector<ClothCommand>& take();
+
+    bool pending() const { return hasPending.load(std::memory_order_acquire); }
+    // Some pending command editsCloth(): a cloth whose state lives elsewhere (GpuClothSolver)
+    // has to be downloaded before the batch is applied and uploaded after
+    bool pendingEdits() const { return hasEdits.load(std::memory_order_acquire); }
+    void clear();
+
+private:
+    std::mutex mutex;
+    std::vector<ClothCommand> queued; // producers append here under `mutex`
+    std::vector<ClothCommand> batch;  // consumer side, from the last take()
+    std::atomic<bool> hasPending{false};
+    std::atomic<bool> hasEdits{false};
+};
@@ -0,0 +1,190 @@
+// cloth_grid.h - Solver specialized at compile time for W x H rectangle cloths
+//
+// Edges are implied by grid coordinates (right and down neighbour, rest length `spacing`), so no
+// LocalConstraint records are stored or loaded, and the iteration count is a template argument the
+// compiler can unroll. LRA tethers are kept per particle and use the same kernels as
+// ClothInstance. Sweeps follow the same four colour batches as buildScene(), so results
+// match ClothInstance's Gauss-Seidel path. Arbitrary meshes keep using ClothInstance.
+
+#pragma once
+
+#include "simulation.h"
+#include "lra_simd.h"
+#include "profiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+template <int W, int H, int Iters>
+class ClothGrid {
+public:
+    static_assert(W >= 2 && H >= 2 && Iters >= 1, "ClothGrid needs at least 2 x 2 particles and one iteration");
+    static constexpr int N = W * H;
+
+    static constexpr int idx(int x, int y) { return y * W + x; }
+
+    // Particles in grid order (idx(x, y)); only x/y/z, px/py/pz, vx/vy/vz and w are used
+    ParticleStore P;
+
+    // LRA tethers in grid indices, ascending by particle, tethersPerParticle consecutive per particle
+    std::vector<LRAConstraint> tethers;
+    int tethersPerParticle = 1;
+
+    // Only substeps, useLRA, lraSlack and lraSimd apply; assign() copies the cloth's. Edges are
+    // always rigid (compliance 0).
+    SolverParams params;
+
+    // Copy state and LRA tethers from a cloth built by buildScene(W, H), in whatever particle
+    // order optimizeLayout() left it. Returns false if the grid size does not match.
+    bool assign(const ClothInstance& cloth);
+
+    // Write positions / velocities back to the cloth last passed to assign()
+    void store(ClothInstance& cloth) const;
+
+    // One fixed step of dt: params.substeps substeps of Iters iterations (params.iterations is ignored)
+    void simulate();
+
+private:
+    void integrate(float h);
+    void projectEdges();
+    void projectTethers();
+    void updateVelocities(float h, float damping);
+
+    std::vector<int> particleOfGrid;
+};
+
+// ---------------------------------------------------------
+// Implementation
+// ---------------------------------------------------------
+
+template <int W, int H, int Iters>
+bool ClothGrid<W, H, Iters>::assign(const ClothInstance& cloth) {
+    if (cloth.gridW != W || cloth.gridH != H || (int)cloth.P.size() != N) return false;
+
+    particleOfGrid.resize(N);
+    std::vector<int> gridOfParticle(N);
+    for (int k = 0; k < N; ++k) {
+        particleOfGrid[k] = cloth.particleOf(k);
+        gridOfParticle[particleOfGrid[k]] = k;
+    }
+
+    P.resize(N);
+    tethers.clear();
+    tethersPerParticle = cloth.tethersPerParticle;
+    params = cloth.params;
+    for (int k = 0; k < N; ++k) {
+        P.set(k, cloth.P.get(particleOfGrid[k]));
+        int c = cloth.lraOfParticle.empty() ? -1 : cloth.lraOfParticle[particleOfGrid[k]];
+        for (int t = 0; c != -1 && t < tethersPerParticle; ++t) {
+            const LRAConstraint& lra = cloth.lraConstraints[c + t];
+            tethers.push_back({k, gridOfParticle[lra.attachmentIdx], lra.maxDist});
+        }
+    }
+    return true;
+}
+
+template <int W, int H, int Iters>
+void ClothGrid<W, H, Iters>::store(ClothInstance& cloth) const {
+    for (int k = 0; k < N; ++k) cloth.P.set(particleOfGrid[k], P.get(k));
+}
+
+template <int W, int H, int Iters>
+void ClothGrid<W, H, Iters>::simulate() {
+    const int substeps = std::max(1, params.substeps);
+    const float h = dt / substeps;
+    const float damping = (substeps == 1) ? 0.99f : std::pow(0.99f, 1.0f / substeps);
+    for (int s = 0; s < substeps; ++s) {
+        integrate(h);
+        for (int iter = 0; iter < Iters; ++iter) {
+            projectEdges();
+            if (params.useLRA) projectTethers();
+        }
+        updateVelocities(h, damping);
+    }
+}
+
+template <int W, int H, int Iters>
+void ClothGrid<W, H, Iters>::integrate(float h) {
+    LRA_PROFILE_SCOPE(PHASE_INTEGRATE);
+    float* X = P.x.data();   float* Y = P.y.data();   float* Z = P.z.data();
+    float* PX = P.px.data(); float* PY = P.py.data(); float* PZ = P.pz.data();
+    float* VX = P.vx.data(); float* VY = P.vy.data(); float* VZ = P.vz.data();
+    const float* Wt = P.w.data();
+
+    for (int i = 0; i < N; ++i) {
+        if (Wt[i] == 0.0f) continue; // pinned
+        VX[i] += g.x * h; VY[i] += g.y * h; VZ[i] += g.z * h;
+        PX[i] = X[i];     PY[i] = Y[i];     PZ[i] = Z[i];
+        X[i] += VX[i] * h; Y[i] += VY[i] * h; Z[i] += VZ[i] * h;
+    }
+}
+
+// projectLocal() on `count` independent edges (a + k * stride, b + k * stride) with the rest
+// length folded in. A degenerate edge or two pinned ends give a zero correction.
+static inline void projectGridEdges(float* X, float* Y, float* Z, const float* Wt,
+                                    int a, int b, int stride, int count, float restLen) {
+    for (int k = 0; k < count; ++k) {
+        const int i = a + k * stride, j = b + k * stride;
+        float dx = X[i] - X[j];
+        float dy = Y[i] - Y[j];
+        float dz = Z[i] - Z[j];
+        float dist = std::sqrt(dx * dx + dy * dy + dz * dz);
+        float wSum = Wt[i] + Wt[j];
+
+        float s = (dist >= 1e-6f && wSum >= 1e-6f) ? -(dist - restLen) / (dist * wSum) : 0.0f;
+        float s1 =  s * Wt[i];
+        float s2 = -s * Wt[j];
+        X[i] += dx * s1; Y[i] += dy * s1; Z[i] += dz * s1;
+        X[j] += dx * s2; Y[j] += dy * s2; Z[j] += dz * s2;
+    }
+}
+
+template <int W, int H, int Iters>
+void ClothGrid<W, H, Iters>::projectEdges() {
+    LRA_PROFILE_SCOPE(PHASE_LOCAL);
+    float* X = P.x.data(); float* Y = P.y.data(); float* Z = P.z.data();
+    const float* Wt = P.w.data();
+
+    // Horizontal even / odd x, then vertical even / odd y (the buildScene() colour batches).
+    // Each row of a batch is one strided run of independent edges.
+    for (int parity = 0; parity < 2; ++parity) {
+        for (int y = 0; y < H; ++y) {
+            projectGridEdges(X, Y, Z, Wt, idx(parity, y), idx(parity + 1, y), 2, (W - parity) / 2, spacing);
+        }
+    }
+    for (int parity = 0; parity < 2; ++parity) {
+        for (int y = parity; y + 1 < H; y += 2) {
+            projectGridEdges(X, Y, Z, Wt, idx(0, y), idx(0, y + 1), 1, W, spacing);
+        }
+    }
+}
+
+template <int W, int H, int Iters>
+void ClothGrid<W, H, Iters>::projectTethers() {
+    LRA_PROFILE_SCOPE(PHASE_LRA);
+    if (params.lraSimd && tethersPerParticle == 1) {
+        projectLRASimd(P, tethers.data(), (int)tethers.size(), params.lraSlack);
+    } else if (params.lraSimd) {
+        projectLRATethersSimd(P, tethers.data(), (int)tethers.size() / tethersPerParticle, tethersPerParticle, params.lraSlack);
+    } else {
+        for (const auto& c : tethers) projectLRA(P, c, params.lraSlack);
+    }
+}
+
+template <int W, int H, int Iters>
+void ClothGrid<W, H, Iters>::updateVelocities(float h, float damping) {
+    LRA_PROFILE_SCOPE(PHASE_VELOCITY);
+    const float* X = P.x.data();   const float* Y = P.y.data();   const float* Z = P.z.data();
+    const float* PX = P.px.data(); const float* PY = P.py.data(); const float* PZ = P.pz.data();
+    float* VX = P.vx.data(); float* VY = P.vy.data(); float* VZ = P.vz.data();
+    const float* Wt = P.w.data();
+
+    const float invH = 1.0f / h;
+    for (int i = 0; i < N; ++i) {
+        if (Wt[i] == 0.0f) continue;
+        VX[i] = (X[i] - PX[i]) * invH * damping;
+        VY[i] = (Y[i] - PY[i]) * invH * damping;
+        VZ[i] = (Z[i] - PZ[i]) * invH * damping;
+    }
+}
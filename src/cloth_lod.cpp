@@ -0,0 +1,210 @@
+// cloth_lod.cpp - Coarser proxies of one grid cloth, picked per instance by screen size
+
+#include "cloth_lod.h"
+
+#include <algorithm>
+#include <cmath>
+
+float g_lodCellPixels = 8.0f;
+
+// update() only leaves the current level once the screen size is this far past its threshold
+static const float kLodHysteresis = 1.25f;
+
+// Position-only solver iterations after a level switch
+static const int kLodRelaxIterations = 20;
+
+// ---------------------------------------------------------
+// Grid sampling
+// ---------------------------------------------------------
+
+namespace {
+
+// Bilinear footprint of grid coordinate (u, v) on a cloth: four particles and their weights
+struct GridSample {
+    int i[4];
+    float w[4];
+};
+
+GridSample sampleGrid(const ClothInstance& c, float u, float v) {
+    int x0 = std::min((int)u, c.gridW - 2), y0 = std::min((int)v, c.gridH - 2);
+    float fx = u - x0, fy = v - y0;
+    GridSample s;
+    s.i[0] = c.particleOf(c.idx(x0, y0));
+    s.i[1] = c.particleOf(c.idx(x0 + 1, y0));
+    s.i[2] = c.particleOf(c.idx(x0, y0 + 1));
+    s.i[3] = c.particleOf(c.idx(x0 + 1, y0 + 1));
+    s.w[0] = (1.0f - fx) * (1.0f - fy);
+    s.w[1] = fx * (1.0f - fy);
+    s.w[2] = (1.0f - fx) * fy;
+    s.w[3] = fx * fy;
+    return s;
+}
+
+float blend(const std::vector<float>& a, const GridSample& s) {
+    return a[s.i[0]] * s.w[0] + a[s.i[1]] * s.w[1] + a[s.i[2]] * s.w[2] + a[s.i[3]] * s.w[3];
+}
+
+// Grid coordinate of vertex x of an n-wide grid on an m-wide one spanning the same cloth
+float scaleCoord(int x, int n, int m) { return (float)x * (m - 1) / (n - 1); }
+
+// Bind every pin of a coarse level to the bone of the nearest source pin that mapped onto it
+// (pinOf: coarse grid vertex, source attachment). Its bind pose is that pin's, shifted by the
+// rest offset between the two, so the coarse anchor follows the same bone transform.
+void bindCoarseSkin(ClothInstance& level, const ClothInstance& source, const std::vector<vec3>& coarse,
+                    const std::vector<std::pair<int, int>>& pinOf) {
+    const vec3* rest = source.geodesic.restData();
+    const AttachmentSkin& fine = source.skin;
+    std::vector<int> gridOf(level.P.size());
+    for (int g = 0; g < (int)gridOf.size(); ++g) gridOf[level.particleOf(g)] = g;
+
+    level.skin.clear();
+    for (int a : level.attachmentIndices) {
+        const int g = gridOf[a];
+        int best = -1;
+        float bestD2 = INFINITY;
+        for (const auto& p : pinOf) {
+            const vec3 d = coarse[g] - rest[source.attachmentIndices[p.second]];
+            if (p.first == g && dot(d, d) < bestD2) {
+                best = p.second;
+                bestD2 = dot(d, d);
+            }
+        }
+        if (best == -1) {
+            level.skin.push(-1, level.P.x[a], level.P.y[a], level.P.z[a]);
+            continue;
+        }
+        const vec3 off = coarse[g] - rest[source.attachmentIndices[best]];
+        level.skin.push(fine.bone[best], fine.bindX[best] + off.x, fine.bindY[best] + off.y, fine.bindZ[best] + off.z);
+    }
+}
+
+} // namespace
+
+// ---------------------------------------------------------
+// ClothLOD
+// ---------------------------------------------------------
+
+void ClothLOD::build(const ClothInstance& source, int maxLevels) {
+    levels.clear();
+    active = 0;
+    levels.emplace_back(new ClothInstance(source));
+
+    const int W = source.gridW, H = source.gridH;
+    const vec3* rest = source.geodesic.restData();
+
+    // Grid vertex of every particle, to place the pins
+    std::vector<int> gridOf(source.P.size());
+    for (int i = 0; i < (int)gridOf.size(); ++i) gridOf[source.particleOf(i)] = i;
+
+    int w = W, h = H;
+    while ((int)levels.size() < maxLevels) {
+        w = w / 2 + 1; // ceil(cells / 2) cells
+        h = h / 2 + 1;
+        if (w < kMinGrid || h < kMinGrid) break;
+
+        std::vector<vec3> coarse(w * h);
+        for (int y = 0; y < h; ++y) {
+            for (int x = 0; x < w; ++x) {
+                GridSample s = sampleGrid(source, scaleCoord(x, w, W), scaleCoord(y, h, H));
+                vec3 p(0.0f);
+                for (int k = 0; k < 4; ++k) p += rest[s.i[k]] * s.w[k];
+                coarse[y * w + x] = p;
+            }
+        }
+
+        std::vector<int> pinned;
+        std::vector<std::pair<int, int>> pinOf;
+        for (int k = 0; k < (int)source.attachmentIndices.size(); ++k) {
+            int g = gridOf[source.attachmentIndices[k]];
+            int x = (int)std::lround(scaleCoord(g % W, W, w));
+            int y = (int)std::lround(scaleCoord(g / W, H, h));
+            pinned.push_back(y * w + x);
+            pinOf.push_back({y * w + x, k});
+        }
+        std::sort(pinned.begin(), pinned.end());
+        pinned.erase(std::unique(pinned.begin(), pinned.end()), pinned.end());
+
+        ClothInstance* level = new ClothInstance();
+        levels.emplace_back(level);
+        level->params = source.params;
+        level->buildGrid(w, h, coarse, pinned);
+        if (level->tethersPerParticle != source.tethersPerParticle) level->setTethersPerParticle(source.tethersPerParticle);
+        // A grid edge's share of the sheet stiffness does not depend on the spacing, so coarse
+        // edges take the source's compliance as it is
+        if (!source.localConstraints.empty()) level->setCompliance(source.localConstraints[0].compliance);
+        if (!source.skin.empty()) bindCoarseSkin(*level, source, coarse, pinOf);
+    }
+}
+
+void ClothLOD::setLevel(int k) {
+    if (k == active || k < 0 || k >= numLevels()) return;
+    ClothInstance& from = current();
+    ClothInstance& to = *levels[k];
+
+    // Pending edits land on the state being transferred; settings carry over as they are
+    from.applyCommands();
+    to.params = from.params;
+    if (!from.localConstraints.empty() && !to.localConstraints.empty() &&
+        to.localConstraints[0].compliance != from.localConstraints[0].compliance) {
+        to.setCompliance(from.localConstraints[0].compliance);
+    }
+
+    // Sleeping tiles hold w = 0 and stale velocities; the transferred state is all in motion
+    from.wake();
+    to.wake();
+
+    const ParticleStore& S = from.P;
+    ParticleStore& D = to.P;
+    for (int y = 0; y < to.gridH; ++y) {
+        for (int x = 0; x < to.gridW; ++x) {
+            GridSample s = sampleGrid(from, scaleCoord(x, to.gridW, from.gridW), scaleCoord(y, to.gridH, from.gridH));
+            int i = to.particleOf(to.idx(x, y));
+            D.x[i] = blend(S.x, s);   D.y[i] = blend(S.y, s);   D.z[i] = blend(S.z, s);
+            D.px[i] = blend(S.px, s); D.py[i] = blend(S.py, s); D.pz[i] = blend(S.pz, s);
+            D.vx[i] = blend(S.vx, s); D.vy[i] = blend(S.vy, s); D.vz[i] = blend(S.vz, s);
+        }
+    }
+
+    to.colliders = from.colliders;
+    to.wind = from.wind;
+
+    // Resampling moves particles off the new level's constraint manifold (a coarse edge spans
+    // several stretched fine ones and vice versa); settle positions first, so the difference
+    // does not turn into velocity on the next step
+    to.relax(kLodRelaxIterations);
+
+    // Skinned anchors would otherwise sweep back to the targets of the last time this level ran
+    AttachmentSkin& skin = to.skin;
+    for (size_t a = 0; a < skin.size(); ++a) {
+        int i = to.attachmentIndices[a];
+        skin.x[a] = D.x[i];
+        skin.y[a] = D.y[i];
+        skin.z[a] = D.z[i];
+    }
+    skin.moved = false;
+
+    active = k;
+}
+
+int ClothLOD::levelFor(float screenSize) const {
+    for (int k = numLevels() - 1; k > 0; --k) {
+        const ClothInstance& c = *levels[k];
+        float cells = (float)(std::max(c.gridW, c.gridH) - 1);
+        if (screenSize <= g_lodCellPixels * cells) return k;
+    }
+    return 0;
+}
+
+bool ClothLOD::update(float screenSize) {
+    // The current level is kept while it is still the right pick for a slightly larger or smaller cloth
+    int finer = levelFor(screenSize * kLodHysteresis);
+    int coarser = levelFor(screenSize / kLodHysteresis);
+    if (active >= finer && active <= coarser) return false;
+    setLevel(levelFor(screenSize));
+    return true;
+}
+
+float ClothLOD::screenSize(float worldSize, float distance, float fovY, int viewportHeight) {
+    if (distance <= 0.0f) return (float)viewportHeight;
+    return worldSize / (2.0f * distance * std::tan(0.5f * fovY)) * viewportHeight;
+}
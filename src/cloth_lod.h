@@ -0,0 +1,61 @@
+// cloth_lod.h - Coarser proxies of one grid cloth, picked per instance by screen size
+//
+// Distant cloths do not need the full particle grid. A ClothLOD resamples the source cloth's rest
+// grid into progressively coarser grids, each a complete ClothInstance with its own edges, colour
+// batches and LRA tethers recomputed on the coarse mesh, so inextensibility holds at every level.
+// Only the active level is simulated; a switch carries positions and velocities across.
+
+#pragma once
+
+#include "simulation.h"
+
+#include <memory>
+#include <vector>
+
+extern float g_lodCellPixels; // Coarsest level whose cloth cells stay at most this many pixels on screen
+
+class ClothLOD {
+public:
+    // Levels stop once a side would drop below this many particles
+    static const int kMinGrid = 4;
+
+    // Level 0 is a copy of `source`, level k halves the cell count of level k - 1 per side.
+    // `source` must be a grid cloth (buildScene(), buildGrid() or a grid asset); levels sample the
+    // rest state its geodesic field recorded. Pins map to the nearest coarse vertex and the tether
+    // count carries over. Skinned pins keep their bones there: bind `source` before build() and
+    // skinAttachments() on current() drives whichever level is active.
+    void build(const ClothInstance& source, int maxLevels = 4);
+    void clear() { levels.clear(); active = 0; }
+
+    int numLevels() const { return (int)levels.size(); }
+    int activeLevel() const { return active; }
+    ClothInstance& level(int k) { return *levels[k]; }
+    const ClothInstance& level(int k) const { return *levels[k]; }
+    ClothInstance& current() { return *levels[active]; }
+    const ClothInstance& current() const { return *levels[active]; }
+
+    // Make level k active. Its particles are resampled bilinearly (in grid coordinates) from the
+    // current level's positions, previous positions and velocities and it takes over the
+    // colliders and params (commands still queued on the old level are applied first, so push
+    // them to current()); skinned anchors keep the transferred pose as their target until the next
+    // skinAttachments().
+    void setLevel(int k);
+
+    // Level for a cloth whose larger side spans `screenSize` pixels: the coarsest one whose cells
+    // are no larger than g_lodCellPixels, level 0 if none.
+    int levelFor(float screenSize) const;
+
+    // Pick the level for `screenSize` with some hysteresis so a cloth hovering at a threshold does
+    // not switch every frame. Returns true if the level changed.
+    bool update(float screenSize);
+
+    void simulate() { current().simulate(); }
+
+    // Pixels spanned by an object `worldSize` across at `distance` in front of a perspective
+    // camera with vertical field of view `fovY` (radians) and a viewport `viewportHeight` tall
+    static float screenSize(float worldSize, float distance, float fovY, int viewportHeight);
+
+private:
+    std::vector<std::unique_ptr<ClothInstance>> levels;
+    int active = 0;
+};
@@ -0,0 +1,81 @@
+// cloth_types.h - Particle storage and constraint records shared by the solver modules
+
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+
+using glm::vec3;
+
+// ---------------------------------------------------------
+// Data Structures
+// ---------------------------------------------------------
+
+// AoS view of a single particle (conversion layer; the solver works on ParticleStore)
+struct Particle {
+    vec3 p;         // position
+    vec3 old_p;     // previous position (for Verlet)
+    vec3 v;         // velocity
+    float w;        // inverse mass (0 = infinite mass/pinned)
+    bool pinned = false;
+};
+
+// Structure-of-arrays particle storage used by the solver hot loops.
+// projectLocal / projectLRA only stream x/y/z and w instead of whole Particle records.
+struct ParticleStore {
+    std::vector<float> x, y, z;       // position
+    std::vector<float> px, py, pz;    // previous position (for Verlet)
+    std::vector<float> vx, vy, vz;    // velocity
+    std::vector<float> w;             // inverse mass (0 = infinite mass/pinned)
+    std::vector<unsigned char> pinned;
+
+    size_t size() const { return x.size(); }
+    bool empty() const { return x.empty(); }
+    void resize(size_t n);
+    void clear() { resize(0); }
+
+    vec3 position(int i) const { return vec3(x[i], y[i], z[i]); }
+    void setPosition(int i, const vec3& p) { x[i] = p.x; y[i] = p.y; z[i] = p.z; }
+
+    Particle get(int i) const;
+    void set(int i, const Particle& p);
+
+    // Copy all positions into a packed vec3 array (for rendering)
+    void gatherPositions(std::vector<vec3>& out) const;
+};
+
+// Skinned anchors, parallel to ClothInstance::attachmentIndices (see bindAttachments()).
+// Streamed once per frame by skinAttachments(), so kept as flat arrays like ParticleStore.
+struct AttachmentSkin {
+    std::vector<int> bone;                  // palette entry driving the anchor, -1 = static
+    std::vector<float> bindX, bindY, bindZ; // bind-pose position
+    std::vector<float> x, y, z;             // target of the last skinAttachments()
+    bool moved = false;                     // targets not yet reached by simulate()
+
+    size_t size() const { return bone.size(); }
+    bool empty() const { return bone.empty(); }
+    void clear();
+    void push(int b, float px, float py, float pz);
+    void erase(size_t k);
+};
+
+// Distance constraint (Local). Compliance is the XPBD inverse stiffness in m/N: 0 keeps the edge
+// rigid (plain PBD), larger values let it stretch under load independently of the iteration count.
+struct LocalConstraint {
+    int i, j;
+    float restLen;
+    float compliance = 0.0f;
+};
+
+// Long Range Attachment Constraint (Global)
+struct LRAConstraint {
+    int particleIdx;
+    int attachmentIdx; // Index of the pinned particle used as anchor
+    float maxDist;     // Initial geodesic (or euclidean in flat case) distance
+};
+
+// Stretch of the local edges relative to their rest length (0 = no stretch).
+struct StretchStats {
+    float maxStrain;  // max over edges of (len / restLen - 1)
+    float meanStrain; // mean over edges of |len / restLen - 1|
+};
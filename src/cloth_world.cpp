@@ -0,0 +1,58 @@
+// cloth_world.cpp - Many independent cloth instances stepped in parallel
+
+#include "cloth_world.h"
+
+ClothInstance& ClothWorld::spawn() {
+    if (pool.empty()) {
+        instances.emplace_back(new ClothInstance());
+    } else {
+        instances.push_back(std::move(pool.back()));
+        pool.pop_back();
+        // A respawned cloth starts like a new one, not with its last owner's settings
+        instances.back()->params = SolverParams();
+        instances.back()->commands.clear();
+        instances.back()->wind = WindField();
+        instances.back()->onCommands = nullptr;
+        instances.back()->colliders.clear();
+        instances.back()->lastSolve = ClothInstance::SolveStats();
+    }
+    return *instances.back();
+}
+
+void ClothWorld::despawn(ClothInstance& cloth) {
+    for (size_t k = 0; k < instances.size(); ++k) {
+        if (instances[k].get() != &cloth) continue;
+        pool.push_back(std::move(instances[k]));
+        instances.erase(instances.begin() + k);
+        return;
+    }
+}
+
+void ClothWorld::reserve(int count, int w, int h) {
+    instances.reserve(instances.size() + pool.size() + count);
+    pool.reserve(pool.size() + count);
+    for (int k = 0; k < count; ++k) {
+        pool.emplace_back(new ClothInstance());
+        pool.back()->buildScene(w, h);
+    }
+}
+
+ClothLOD& ClothWorld::spawnLOD() {
+    lods.emplace_back(new ClothLOD());
+    return *lods.back();
+}
+
+void ClothWorld::step() {
+    // Instances share no data, so each one is an independent task;
+    // idle workers steal whole cloths from busy ones.
+    TaskGroup group;
+    for (auto& inst : instances) {
+        ClothInstance* cloth = inst.get();
+        threads.submit(group, [cloth] { cloth->simulate(); });
+    }
+    for (auto& lod : lods) {
+        ClothInstance* cloth = &lod->current();
+        threads.submit(group, [cloth] { cloth->simulate(); });
+    }
+    threads.wait(group);
+}
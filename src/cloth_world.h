@@ -0,0 +1,51 @@
+// cloth_world.h - Many independent cloth instances stepped in parallel
+
+#pragma once
+
+#include "simulation.h"
+#include "cloth_lod.h"
+#include "thread_pool.h"
+
+#include <memory>
+#include <vector>
+
+// Owns a set of ClothInstance objects and steps them once per frame. Each instance is one task
+// on the work-stealing pool, so frame cost scales with core count rather than instance count.
+class ClothWorld {
+public:
+    explicit ClothWorld(ThreadPool& threads = solverPool()) : threads(threads) {}
+
+    // New instance with default params; call buildScene() on it before stepping. Taken from the
+    // pool when it has one, storage sized by its last build.
+    ClothInstance& spawn();
+
+    // Remove an instance from the world and keep it, with all its storage, for a later spawn()
+    void despawn(ClothInstance& cloth);
+
+    // Pre-build `count` pooled w x h cloths (and size this thread's build scratch), so spawning
+    // and building up to `count` cloths of that size or smaller never touches the heap
+    void reserve(int count, int w = clothW, int h = clothH);
+    size_t pooled() const { return pool.size(); }
+
+    // New empty LOD set; build() it from a source cloth before stepping. Only its active level
+    // is stepped, so crowds of distant LOD cloths cost what their coarse levels cost.
+    ClothLOD& spawnLOD();
+
+    void clear() { instances.clear(); lods.clear(); }  // destroys; despawn() to keep storage
+
+    size_t size() const { return instances.size(); }
+    ClothInstance& operator[](size_t i) { return *instances[i]; }
+    const ClothInstance& operator[](size_t i) const { return *instances[i]; }
+
+    size_t lodCount() const { return lods.size(); }
+    ClothLOD& lod(size_t i) { return *lods[i]; }
+    const ClothLOD& lod(size_t i) const { return *lods[i]; }
+
+    void step();
+
+private:
+    ThreadPool& threads;
+    std::vector<std::unique_ptr<ClothInstance>> instances;
+    std::vector<std::unique_ptr<ClothInstance>> pool; // despawned / reserved, storage kept
+    std::vector<std::unique_ptr<ClothLOD>> lods;
+};
@@ -0,0 +1,164 @@
+// collision.cpp - Body colliders and spatial-hash self-collision for the cloth constraint loop
+
+#include "collision.h"
+
+#include <algorithm>
+
+// Self-collision pairs are gathered once per substep out to this multiple of the thickness, so
+// particles closing in during the substep's iterations are already listed
+static const float kSearchScale = 1.5f;
+
+// ---------------------------------------------------------
+// Spatial Hash
+// ---------------------------------------------------------
+
+void SpatialHash::build(const float* x, const float* y, const float* z, int n, float cellSize) {
+    unsigned size = 64;
+    while (size < 4u * (unsigned)n) size <<= 1;
+    mask = size - 1;
+    invCell = 1.0f / cellSize;
+
+    // Sized once per particle count; assign() / resize() reuse the storage afterwards
+    start.assign(size + 1, 0);
+    entries.resize(n);
+    cells.resize(n);
+    bucketOf.resize(n);
+
+    // Count, inclusive prefix sum (start[b] = end of bucket b), then fill every bucket back to
+    // front so start[b] ends up at its first entry and entries stay in particle order
+    for (int i = 0; i < n; ++i) {
+        const unsigned b = bucket(cellCoord(x[i]), cellCoord(y[i]), cellCoord(z[i]));
+        bucketOf[i] = b;
+        ++start[b];
+    }
+    for (unsigned b = 1; b < size; ++b) start[b] += start[b - 1];
+    for (int i = n - 1; i >= 0; --i) {
+        const int e = --start[bucketOf[i]];
+        entries[e] = i;
+        cells[e] = {cellCoord(x[i]), cellCoord(y[i]), cellCoord(z[i])};
+    }
+    start[size] = n;
+}
+
+// ---------------------------------------------------------
+// Cloth Collision Stage
+// ---------------------------------------------------------
+
+namespace {
+
+bool overlaps(const vec3& lo, const vec3& hi, const vec3& bmin, const vec3& bmax) {
+    return lo.x <= bmax.x && hi.x >= bmin.x && lo.y <= bmax.y && hi.y >= bmin.y && lo.z <= bmax.z && hi.z >= bmin.z;
+}
+
+// Push (x, y, z) out to the surface of a sphere of radius r around c
+inline void pushOut(float& x, float& y, float& z, float cx, float cy, float cz, float r) {
+    const float dx = x - cx, dy = y - cy, dz = z - cz;
+    const float d2 = dx * dx + dy * dy + dz * dz;
+    if (d2 >= r * r || d2 < 1e-12f) return;
+    const float s = r / std::sqrt(d2);
+    x = cx + dx * s;
+    y = cy + dy * s;
+    z = cz + dz * s;
+}
+
+} // namespace
+
+void ClothCollision::begin(const ParticleStore& P, const ColliderSet& bodies, float thickness_, bool self, const vec3* rest) {
+    thickness = thickness_;
+    selfCollide = self;
+    nearSpheres.clear();
+    nearCapsules.clear();
+
+    const int n = (int)P.size();
+    if (n == 0) return;
+    const float* X = P.x.data(); const float* Y = P.y.data(); const float* Z = P.z.data();
+
+    if (!bodies.empty()) {
+        vec3 lo(X[0], Y[0], Z[0]), hi = lo;
+        for (int i = 1; i < n; ++i) {
+            lo.x = std::min(lo.x, X[i]); lo.y = std::min(lo.y, Y[i]); lo.z = std::min(lo.z, Z[i]);
+            hi.x = std::max(hi.x, X[i]); hi.y = std::max(hi.y, Y[i]); hi.z = std::max(hi.z, Z[i]);
+        }
+        lo -= vec3(thickness);
+        hi += vec3(thickness);
+
+        // reserve() is a no-op once the lists have held every collider
+        nearSpheres.reserve(bodies.spheres.size());
+        nearCapsules.reserve(bodies.capsules.size());
+        for (const auto& s : bodies.spheres) {
+            if (overlaps(lo, hi, s.center - vec3(s.radius), s.center + vec3(s.radius))) nearSpheres.push_back(s);
+        }
+        for (const auto& c : bodies.capsules) {
+            vec3 cmin = glm::min(c.a, c.b) - vec3(c.radius), cmax = glm::max(c.a, c.b) + vec3(c.radius);
+            if (overlaps(lo, hi, cmin, cmax)) nearCapsules.push_back(c);
+        }
+    }
+
+    if (!selfCollide) return;
+    const float search = kSearchScale * thickness, search2 = search * search, t2 = thickness * thickness;
+    hash.build(X, Y, Z, n, search);
+    pairStart.resize(n + 1);
+    pairs.resize((size_t)n * kPairsPerParticle);
+    int numPairs = 0;
+    for (int i = 0; i < n; ++i) {
+        pairStart[i] = numPairs;
+        hash.query(X[i], Y[i], Z[i], [&](int j) {
+            if (j <= i || numPairs == (int)pairs.size()) return;
+            const float dx = X[i] - X[j], dy = Y[i] - Y[j], dz = Z[i] - Z[j];
+            if (dx * dx + dy * dy + dz * dz >= search2) return;
+            if (rest) {
+                const vec3 r = rest[i] - rest[j];
+                if (glm::dot(r, r) < t2) return;
+            }
+            pairs[numPairs++] = j;
+        });
+    }
+    pairStart[n] = numPairs;
+}
+
+void ClothCollision::project(ParticleStore& P) const {
+    const int n = (int)P.size();
+    float* X = P.x.data(); float* Y = P.y.data(); float* Z = P.z.data();
+    const float* W = P.w.data();
+    const float t = thickness, t2 = thickness * thickness;
+    const SphereCollider* spheres = nearSpheres.data();
+    const CapsuleCollider* capsules = nearCapsules.data();
+    const int numSpheres = (int)nearSpheres.size(), numCapsules = (int)nearCapsules.size();
+
+    for (int i = 0; i < n; ++i) {
+        const float wi = W[i];
+
+        // (A) Bodies: pinned and sleeping particles (w = 0) stay where they are
+        if (wi > 0.0f) {
+            for (int k = 0; k < numSpheres; ++k) {
+                const SphereCollider& s = spheres[k];
+                pushOut(X[i], Y[i], Z[i], s.center.x, s.center.y, s.center.z, s.radius + t);
+            }
+            for (int k = 0; k < numCapsules; ++k) {
+                // Sphere around the closest point of the segment
+                const CapsuleCollider& c = capsules[k];
+                const vec3 ab = c.b - c.a;
+                const float len2 = glm::dot(ab, ab);
+                float u = (len2 > 0.0f) ? ((X[i] - c.a.x) * ab.x + (Y[i] - c.a.y) * ab.y + (Z[i] - c.a.z) * ab.z) / len2 : 0.0f;
+                u = std::min(1.0f, std::max(0.0f, u));
+                const vec3 q = c.a + ab * u;
+                pushOut(X[i], Y[i], Z[i], q.x, q.y, q.z, c.radius + t);
+            }
+        }
+
+        // (B) Self: each pair once, from its lower index
+        if (!selfCollide) continue;
+        for (int k = pairStart[i]; k < pairStart[i + 1]; ++k) {
+            const int j = pairs[k];
+            const float wSum = wi + W[j];
+            if (wSum == 0.0f) continue;
+            const float dx = X[i] - X[j], dy = Y[i] - Y[j], dz = Z[i] - Z[j];
+            const float d2 = dx * dx + dy * dy + dz * dz;
+            if (d2 >= t2 || d2 < 1e-12f) continue;
+            const float d = std::sqrt(d2);
+            const float s = (t - d) / (d * wSum);
+            X[i] += dx * s * wi;   Y[i] += dy * s * wi;   Z[i] += dz * s * wi;
+            X[j] -= dx * s * W[j]; Y[j] -= dy * s * W[j]; Z[j] -= dz * s * W[j];
+        }
+    }
+}
@@ -0,0 +1,112 @@
+// collision.h - Body colliders and spatial-hash self-collision for the cloth constraint loop
+//
+// ClothInstance runs the stage inside every solver iteration, right after the LRA pass: tethers
+// only ever pull inward and collisions only push out along a surface normal, so giving collisions
+// the last word each iteration keeps the cloth out of the body without the two fighting.
+
+#pragma once
+
+#include "cloth_types.h"
+
+#include <cmath>
+#include <vector>
+
+// World-space body shapes one cloth collides with. Update them every frame (like the skinning
+// palette); a particle is kept params.collisionThickness outside each of them.
+struct SphereCollider {
+    vec3 center;
+    float radius;
+};
+
+struct CapsuleCollider {
+    vec3 a, b;       // segment end points
+    float radius;
+};
+
+struct ColliderSet {
+    std::vector<SphereCollider> spheres;
+    std::vector<CapsuleCollider> capsules;
+
+    bool empty() const { return spheres.empty() && capsules.empty(); }
+    void clear() { spheres.clear(); capsules.clear(); }
+};
+
+// Counting-sort hash grid over particle positions: a table of 4n+ buckets, each a range of
+// `entries`. build() is O(n) and allocates nothing once sized for the particle count.
+class SpatialHash {
+public:
+    void build(const float* x, const float* y, const float* z, int n, float cellSize);
+
+    // Calls f(j) once for every particle in the 27 cells around p. Buckets are shared by
+    // colliding cells, so entries are matched against the exact cell they were hashed from.
+    // (Wrapped rows scan from bucket 0 up to the first bucket past the row.)
+    template <class F>
+    void query(float px, float py, float pz, F&& f) const {
+        const int cx = cellCoord(px), cy = cellCoord(py), cz = cellCoord(pz);
+        for (int z = cz - 1; z <= cz + 1; ++z) {
+            for (int y = cy - 1; y <= cy + 1; ++y) {
+                // The row's three cells are consecutive buckets unless they wrap around the table
+                const unsigned b = bucket(cx - 1, y, z);
+                const int e0 = start[b];
+                const int e1 = (b + 3 <= mask + 1) ? start[b + 3] : (int)entries.size();
+                for (int e = e0; e < e1; ++e) {
+                    const Cell& c = cells[e];
+                    if (c.y == y && c.z == z && c.x >= cx - 1 && c.x <= cx + 1) f(entries[e]);
+                }
+                if (b + 3 > mask + 1) {
+                    for (int e = 0; e < start[(b + 3) & mask]; ++e) {
+                        const Cell& c = cells[e];
+                        if (c.y == y && c.z == z && c.x >= cx - 1 && c.x <= cx + 1) f(entries[e]);
+                    }
+                }
+            }
+        }
+    }
+
+private:
+    int cellCoord(float v) const { return (int)std::floor(v * invCell); }
+    // Cells of one x row land in consecutive buckets, so a query touches 9 cache lines, not 27
+    unsigned bucket(int cx, int cy, int cz) const {
+        return (((unsigned)cy * 19349663u ^ (unsigned)cz * 83492791u) + (unsigned)cx) & mask;
+    }
+
+    struct Cell {
+        int x, y, z;
+    };
+
+    std::vector<int> start;         // bucket b holds entries[start[b], start[b + 1])
+    std::vector<int> entries;       // particle indices sorted by bucket
+    std::vector<Cell> cells;        // cell of each entry
+    std::vector<unsigned> bucketOf; // per particle, from build()
+    float invCell = 0.0f;
+    unsigned mask = 0;
+};
+
+// Collision stage of one cloth. begin() once per substep on the predicted positions, then
+// project() once per solver iteration; neither allocates after the first substep.
+class ClothCollision {
+public:
+    // Self-collision candidates kept per particle; a cloth crumpled tighter than this loses
+    // its farthest-indexed pairs for the substep rather than growing the list
+    static const int kPairsPerParticle = 16;
+
+    // Broadphase, O(n + colliders): gather the colliders whose bounds overlap the cloth's and, with
+    // `self`, hash the particles and list every pair within 1.5x the thickness. Pairs that
+    // were already closer than the thickness in the rest state `rest` (particle order, may be
+    // null) are left to the edges.
+    void begin(const ParticleStore& P, const ColliderSet& bodies, float thickness, bool self, const vec3* rest);
+
+    // One fused pass over the particles: push each out of the nearby colliders, then apart from
+    // its listed neighbours closer than the thickness
+    void project(ParticleStore& P) const;
+
+    bool active() const { return selfCollide || !nearSpheres.empty() || !nearCapsules.empty(); }
+
+private:
+    SpatialHash hash;
+    std::vector<SphereCollider> nearSpheres;
+    std::vector<CapsuleCollider> nearCapsules;
+    std::vector<int> pairStart, pairs; // candidates j > i of particle i in pairs[pairStart[i], pairStart[i + 1])
+    float thickness = 0.0f;
+    bool selfCollide = false;
+};
@@ -0,0 +1,191 @@
+// compact_constraints.cpp - Packed resident storage for a cloth's constraints
+
+#include "compact_constraints.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+
+// ---------------------------------------------------------
+// Encoding helpers
+// ---------------------------------------------------------
+
+static void putVarint(std::vector<uint8_t>& out, uint32_t v) {
+    while (v >= 0x80) {
+        out.push_back(uint8_t(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(uint8_t(v));
+}
+
+static uint32_t getVarint(const uint8_t*& p) {
+    uint32_t v = 0;
+    for (int shift = 0;; shift += 7) {
+        uint8_t b = *p++;
+        v |= uint32_t(b & 0x7f) << shift;
+        if (!(b & 0x80)) return v;
+    }
+}
+
+static uint32_t zigzag(int v) { return (uint32_t(v) << 1) ^ uint32_t(v >> 31); }
+static int unzigzag(uint32_t v) { return int(v >> 1) ^ -int(v & 1); }
+
+// IEEE 754 binary16, round to nearest; rest lengths are positive and well inside its range
+static uint16_t floatToHalf(float f) {
+    uint32_t x;
+    memcpy(&x, &f, 4);
+    uint32_t sign = (x >> 16) & 0x8000;
+    int exp = int((x >> 23) & 0xff) - 127 + 15;
+    uint32_t mant = x & 0x7fffff;
+    if (exp <= 0) return uint16_t(sign); // flush tiny values
+    if (exp >= 31) return uint16_t(sign | 0x7c00);
+    uint32_t h = sign | (uint32_t(exp) << 10) | (mant >> 13);
+    if (mant & 0x1000) ++h; // carries into the exponent correctly
+    return uint16_t(h);
+}
+
+static float halfToFloat(uint16_t h) {
+    uint32_t sign = uint32_t(h & 0x8000) << 16;
+    uint32_t exp = (h >> 10) & 0x1f;
+    uint32_t mant = h & 0x3ff;
+    uint32_t x = (exp == 0) ? sign : (exp == 31) ? (sign | 0x7f800000 | (mant << 13))
+                                                 : (sign | ((exp - 15 + 127) << 23) | (mant << 13));
+    float f;
+    memcpy(&f, &x, 4);
+    return f;
+}
+
+// ---------------------------------------------------------
+// Pack / unpack
+// ---------------------------------------------------------
+
+size_t CompactConstraints::memoryBytes() const {
+    return sizeof(*this) + colorOffsets.size() * sizeof(int) + edgeStream.size() + restTable.size() * sizeof(float) +
+           restIndex.size() + restHalf.size() * sizeof(uint16_t) + complianceTable.size() * sizeof(float) +
+           complianceIndex.size() + complianceFull.size() * sizeof(float) + groups.size() * sizeof(AnchorGroup) +
+           tetherStream.size() + tetherDist.size() * sizeof(uint16_t);
+}
+
+size_t constraintMemoryBytes(const ClothInstance& cloth) {
+    return cloth.localConstraints.size() * sizeof(LocalConstraint) + cloth.localColorOffsets.size() * sizeof(int) +
+           cloth.lraConstraints.size() * sizeof(LRAConstraint) + cloth.lraOfParticle.size() * sizeof(int);
+}
+
+CompactConstraints compactConstraints(const ClothInstance& cloth) {
+    CompactConstraints cc;
+    cc.numParticles = (int)cloth.P.size();
+    cc.numEdges = (int)cloth.localConstraints.size();
+    cc.colorOffsets = cloth.localColorOffsets;
+
+    // Rest-length table: sort, then merge runs within the tolerance of the run's first value
+    std::vector<float> lengths;
+    lengths.reserve(cloth.localConstraints.size());
+    for (const auto& c : cloth.localConstraints) lengths.push_back(c.restLen);
+    std::sort(lengths.begin(), lengths.end());
+    for (float v : lengths) {
+        if (cc.restTable.empty() || v - cc.restTable.back() > CompactConstraints::kRestTolerance * cc.restTable.back()) {
+            cc.restTable.push_back(v);
+        }
+    }
+    const bool indexed = cc.restTable.size() <= 256;
+    if (!indexed) cc.restTable.clear();
+
+    int prevI = 0;
+    for (const auto& c : cloth.localConstraints) {
+        putVarint(cc.edgeStream, zigzag(c.i - prevI));
+        putVarint(cc.edgeStream, zigzag(c.j - c.i));
+        prevI = c.i;
+        if (indexed) {
+            // Entry whose run contains restLen: the last one <= restLen
+            auto it = std::upper_bound(cc.restTable.begin(), cc.restTable.end(), c.restLen);
+            cc.restIndex.push_back(uint8_t(std::max<std::ptrdiff_t>(0, it - cc.restTable.begin() - 1)));
+        } else {
+            cc.restHalf.push_back(floatToHalf(c.restLen));
+        }
+    }
+
+    // Compliance table, exact values
+    for (const auto& c : cloth.localConstraints) cc.complianceTable.push_back(c.compliance);
+    std::sort(cc.complianceTable.begin(), cc.complianceTable.end());
+    cc.complianceTable.erase(std::unique(cc.complianceTable.begin(), cc.complianceTable.end()), cc.complianceTable.end());
+    if (cc.complianceTable.size() > 256) {
+        cc.complianceTable.clear();
+        for (const auto& c : cloth.localConstraints) cc.complianceFull.push_back(c.compliance);
+    } else if (cc.complianceTable.size() > 1) {
+        for (const auto& c : cloth.localConstraints) {
+            auto it = std::lower_bound(cc.complianceTable.begin(), cc.complianceTable.end(), c.compliance);
+            cc.complianceIndex.push_back(uint8_t(it - cc.complianceTable.begin()));
+        }
+    }
+
+    // Tethers by anchor, then particle
+    std::vector<LRAConstraint> lra = cloth.lraConstraints;
+    std::sort(lra.begin(), lra.end(), [](const LRAConstraint& a, const LRAConstraint& b) {
+        return a.attachmentIdx < b.attachmentIdx || (a.attachmentIdx == b.attachmentIdx && a.particleIdx < b.particleIdx);
+    });
+    cc.numTethers = (int)lra.size();
+    cc.tethersPerParticle = cloth.tethersPerParticle;
+    for (size_t k = 0; k < lra.size();) {
+        size_t end = k;
+        float scale = 0.0f;
+        while (end < lra.size() && lra[end].attachmentIdx == lra[k].attachmentIdx) {
+            scale = std::max(scale, lra[end].maxDist);
+            ++end;
+        }
+        cc.groups.push_back({lra[k].attachmentIdx, int(end - k), scale});
+
+        int prev = 0;
+        for (size_t t = k; t < end; ++t) {
+            putVarint(cc.tetherStream, uint32_t(lra[t].particleIdx - prev));
+            prev = lra[t].particleIdx;
+            float q = scale > 0.0f ? lra[t].maxDist / scale * 65535.0f : 0.0f;
+            cc.tetherDist.push_back(uint16_t(std::min(65535.0f, std::round(q))));
+        }
+        k = end;
+    }
+    return cc;
+}
+
+void expandConstraints(const CompactConstraints& cc, ClothInstance& cloth) {
+    cloth.localConstraints.resize(cc.numEdges);
+    cloth.localColorOffsets = cc.colorOffsets;
+
+    const uint8_t* p = cc.edgeStream.data();
+    int i = 0;
+    for (int k = 0; k < cc.numEdges; ++k) {
+        i += unzigzag(getVarint(p));
+        int j = i + unzigzag(getVarint(p));
+        float rest = cc.restIndex.empty() ? halfToFloat(cc.restHalf[k]) : cc.restTable[cc.restIndex[k]];
+        float compliance = !cc.complianceFull.empty()  ? cc.complianceFull[k]
+                         : !cc.complianceIndex.empty() ? cc.complianceTable[cc.complianceIndex[k]]
+                         : cc.complianceTable.empty()  ? 0.0f : cc.complianceTable[0];
+        cloth.localConstraints[k] = {i, j, rest, compliance};
+    }
+
+    cloth.lraConstraints.clear();
+    cloth.lraConstraints.reserve(cc.numTethers);
+    cloth.lraOfParticle.assign(cc.numParticles, -1);
+    p = cc.tetherStream.data();
+    int t = 0;
+    for (const auto& g : cc.groups) {
+        int particle = 0;
+        for (int k = 0; k < g.count; ++k, ++t) {
+            particle += (int)getVarint(p);
+            cloth.lraOfParticle[particle] = (int)cloth.lraConstraints.size();
+            cloth.lraConstraints.push_back({particle, g.anchor, cc.tetherDist[t] / 65535.0f * g.maxDistScale});
+        }
+    }
+
+    // K > 1: back to K consecutive tethers per particle, nearest first
+    cloth.tethersPerParticle = cc.tethersPerParticle;
+    if (cc.tethersPerParticle > 1) {
+        std::stable_sort(cloth.lraConstraints.begin(), cloth.lraConstraints.end(), [](const LRAConstraint& a, const LRAConstraint& b) {
+            return a.particleIdx < b.particleIdx || (a.particleIdx == b.particleIdx && a.maxDist < b.maxDist);
+        });
+        for (int k = 0; k < (int)cloth.lraConstraints.size(); k += cc.tethersPerParticle) {
+            cloth.lraOfParticle[cloth.lraConstraints[k].particleIdx] = k;
+        }
+    }
+    ++cloth.topologyVersion;
+}
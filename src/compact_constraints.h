@@ -0,0 +1,57 @@
+// compact_constraints.h - Packed resident storage for a cloth's constraints
+//
+// Edges are delta-coded (varint of the step in i, zigzag varint of j - i) and their rest lengths
+// point into a deduplicated table: one byte per edge for up to 256 distinct lengths, a half
+// float otherwise. Compliances are deduplicated exactly, and cost no per-edge bytes while every
+// edge shares one value. LRA tethers are grouped per anchor, so the anchor index is stored once
+// per group and each tether costs a delta-coded particle index plus a 16-bit fraction of the
+// group's longest tether. Grid cloths come out about 5x smaller (~3 bytes per constraint).
+
+#pragma once
+
+#include "simulation.h"
+
+#include <cstdint>
+#include <vector>
+
+struct CompactConstraints {
+    int numParticles = 0;
+
+    // Local constraints, colour batches kept in order
+    std::vector<int> colorOffsets;       // same meaning as ClothInstance::localColorOffsets
+    std::vector<uint8_t> edgeStream;     // per edge: varint(i - previous i, zigzag), varint(j - i, zigzag)
+    std::vector<float> restTable;        // distinct rest lengths (merged within kRestTolerance)
+    std::vector<uint8_t> restIndex;      // per edge, when restTable.size() <= 256
+    std::vector<uint16_t> restHalf;      // per edge half float, otherwise
+    std::vector<float> complianceTable;  // distinct compliances; a single entry applies to every edge
+    std::vector<uint8_t> complianceIndex; // per edge, when 2..256 distinct values
+    std::vector<float> complianceFull;   // per edge, beyond 256 distinct values
+    int numEdges = 0;
+
+    // LRA tethers grouped per anchor, ascending particle index inside a group
+    struct AnchorGroup {
+        int anchor;
+        int count;
+        float maxDistScale; // longest tether of the group; q / 65535 * scale is the tether length
+    };
+    std::vector<AnchorGroup> groups;
+    std::vector<uint8_t> tetherStream;   // per tether: varint(particle - previous particle in group)
+    std::vector<uint16_t> tetherDist;    // per tether
+    int numTethers = 0;
+    int tethersPerParticle = 1;          // ClothInstance::tethersPerParticle
+
+    // Rest lengths closer than this (relative) share a table entry
+    static constexpr float kRestTolerance = 1e-5f;
+
+    size_t memoryBytes() const;
+};
+
+// Pack cloth.localConstraints / localColorOffsets / lraConstraints
+CompactConstraints compactConstraints(const ClothInstance& cloth);
+
+// Unpack into cloth.localConstraints, localColorOffsets, lraConstraints and lraOfParticle.
+// Particle state, triangles and attachments are left alone.
+void expandConstraints(const CompactConstraints& cc, ClothInstance& cloth);
+
+// Bytes held by the solver-format constraint arrays of `cloth` (for comparison)
+size_t constraintMemoryBytes(const ClothInstance& cloth);
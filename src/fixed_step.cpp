@@ -0,0 +1,56 @@
+// fixed_step.cpp - Accumulator-based fixed-timestep driver with render interpolation
+
+#include "fixed_step.h"
+
+#include <algorithm>
+
+void FixedStepDriver::snapshot(const ClothInstance& cloth) {
+    prevX = cloth.P.x;
+    prevY = cloth.P.y;
+    prevZ = cloth.P.z;
+}
+
+void FixedStepDriver::reset(const ClothInstance& cloth) {
+    accumulator = 0.0f;
+    snapshot(cloth);
+}
+
+int FixedStepDriver::advance(ClothInstance& cloth, float frameTime) {
+    if (prevX.size() != cloth.P.size()) snapshot(cloth);
+
+    return advance(frameTime, [&]() {
+        snapshot(cloth);
+        cloth.simulate();
+    });
+}
+
+int FixedStepDriver::advance(float frameTime, const std::function<void()>& step) {
+    accumulator += std::max(0.0f, frameTime);
+    int steps = 0;
+    while (accumulator >= dt) {
+        if (steps == maxStepsPerFrame) {
+            accumulator = 0.0f; // fell too far behind: slow down instead of spiralling
+            break;
+        }
+        if (onStep) onStep();
+        step();
+        accumulator -= dt;
+        ++steps;
+    }
+    return steps;
+}
+
+void FixedStepDriver::interpolate(const ClothInstance& cloth, std::vector<vec3>& out) const {
+    const ParticleStore& P = cloth.P;
+    out.resize(P.size());
+    if (prevX.size() != P.size()) {
+        P.gatherPositions(out);
+        return;
+    }
+    const float a = alpha();
+    for (size_t i = 0; i < P.size(); ++i) {
+        out[i] = vec3(prevX[i] + (P.x[i] - prevX[i]) * a,
+                      prevY[i] + (P.y[i] - prevY[i]) * a,
+                      prevZ[i] + (P.z[i] - prevZ[i]) * a);
+    }
+}
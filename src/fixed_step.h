@@ -0,0 +1,43 @@
+// fixed_step.h - Accumulator-based fixed-timestep driver with render interpolation
+//
+// Wall-clock frame time is accumulated and consumed in whole simulation steps of `dt`, so the cloth
+// runs at the same speed on a 60 Hz or a 144 Hz display. The renderer blends the last two step
+// states by the leftover fraction of a step.
+
+#pragma once
+
+#include "simulation.h"
+
+#include <functional>
+#include <vector>
+
+class FixedStepDriver {
+public:
+    // At most this many steps per frame; excess time is dropped rather than spiralling
+    int maxStepsPerFrame = 4;
+
+    // Called before every fixed step, e.g. to sample an animation and skin the attachments
+    std::function<void()> onStep;
+
+    // Consume `frameTime` seconds of wall-clock time. Returns the number of steps taken.
+    int advance(ClothInstance& cloth, float frameTime);
+
+    // Same accounting for a solver that keeps its own step history (e.g. GpuClothSolver):
+    // calls `step` once per fixed step
+    int advance(float frameTime, const std::function<void()>& step);
+
+    // Discard accumulated time and history (after a reset / rebuild)
+    void reset(const ClothInstance& cloth);
+
+    // Blend factor between the previous and the current step, in [0, 1)
+    float alpha() const { return accumulator / dt; }
+
+    // Positions blended between the last two steps by alpha()
+    void interpolate(const ClothInstance& cloth, std::vector<vec3>& out) const;
+
+private:
+    void snapshot(const ClothInstance& cloth);
+
+    float accumulator = 0.0f;
+    std::vector<float> prevX, prevY, prevZ;
+};
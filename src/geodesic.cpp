@@ -0,0 +1,378 @@
+// geodesic.cpp - Nearest-attachment field over the cloth surface (multi-source Dijkstra / fast marching)
+
+#include "geodesic.h"
+#include "build_scratch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+using glm::length;
+using glm::dot;
+using glm::cross;
+
+static const float kInf = 1e30f;
+
+void GeodesicField::build(const ParticleStore& P, const std::vector<LocalConstraint>& edges, const std::vector<int>& triangles) {
+    const int n = (int)P.size();
+    rest.resize(n);
+    for (int i = 0; i < n; ++i) rest[i] = P.position(i);
+
+    buildAdjacency(edges, triangles);
+
+    anchor.assign(n, -1);
+    dist.assign(n, kInf);
+    touched.assign(n, 0);
+    closed.assign(n, 0);
+    epoch = 0;
+}
+
+void GeodesicField::restore(const vec3* restPositions, const int* anchors, const float* distances, int n) {
+    rest.assign(restPositions, restPositions + n);
+    anchor.assign(anchors, anchors + n);
+    dist.assign(distances, distances + n);
+    edgeStart.clear(); edgeNbr.clear(); edgeLen.clear();
+    triStart.clear(); triOther.clear();
+    touched.assign(n, 0);
+    closed.assign(n, 0);
+    epoch = 0;
+}
+
+void GeodesicField::remap(const std::vector<int>& newIndexOf, const std::vector<LocalConstraint>& edges, const std::vector<int>& triangles) {
+    const int n = (int)rest.size();
+    BuildScratch& scratch = buildScratch();
+    std::vector<vec3>& r = scratch.vecs;
+    std::vector<int>& a = scratch.ints;
+    std::vector<float>& d = scratch.floats;
+    r.resize(n);
+    a.resize(n);
+    d.resize(n);
+    for (int i = 0; i < n; ++i) {
+        int k = newIndexOf[i];
+        r[k] = rest[i];
+        a[k] = anchor[i] == -1 ? -1 : newIndexOf[anchor[i]];
+        d[k] = dist[i];
+    }
+    std::copy(r.begin(), r.end(), rest.begin());
+    std::copy(a.begin(), a.end(), anchor.begin());
+    std::copy(d.begin(), d.end(), dist.begin());
+    buildAdjacency(edges, triangles);
+}
+
+void GeodesicField::buildAdjacency(const std::vector<LocalConstraint>& edges, const std::vector<int>& triangles) {
+    const int n = (int)rest.size();
+
+    // Edges (both directions)
+    edgeStart.assign(n + 1, 0);
+    for (const auto& c : edges) { edgeStart[c.i + 1]++; edgeStart[c.j + 1]++; }
+    for (int i = 0; i < n; ++i) edgeStart[i + 1] += edgeStart[i];
+    edgeNbr.resize(edgeStart[n]);
+    edgeLen.resize(edgeStart[n]);
+    std::vector<int>& cursor = buildScratch().cursor;
+    cursor.assign(edgeStart.begin(), edgeStart.end() - 1);
+    for (const auto& c : edges) {
+        float d = length(rest[c.i] - rest[c.j]);
+        edgeNbr[cursor[c.i]] = c.j; edgeLen[cursor[c.i]++] = d;
+        edgeNbr[cursor[c.j]] = c.i; edgeLen[cursor[c.j]++] = d;
+    }
+
+    // Triangles incident to each vertex, stored as the pair of opposite corners
+    triStart.assign(n + 1, 0);
+    for (int t = 0; t + 2 < (int)triangles.size(); t += 3) {
+        for (int k = 0; k < 3; ++k) triStart[triangles[t + k] + 1]++;
+    }
+    for (int i = 0; i < n; ++i) triStart[i + 1] += triStart[i];
+    triOther.resize(2 * triStart[n]);
+    cursor.assign(triStart.begin(), triStart.end() - 1);
+    for (int t = 0; t + 2 < (int)triangles.size(); t += 3) {
+        for (int k = 0; k < 3; ++k) {
+            int v = triangles[t + k];
+            int slot = cursor[v]++;
+            triOther[2 * slot]     = triangles[t + (k + 1) % 3];
+            triOther[2 * slot + 1] = triangles[t + (k + 2) % 3];
+        }
+    }
+}
+
+void GeodesicField::beginPass(bool grow, std::vector<int>* changed) {
+    ++epoch;
+    growing = grow;
+    changedOut = changed;
+    heap.clear();
+}
+
+void GeodesicField::compute(const std::vector<int>& sources) {
+    std::fill(anchor.begin(), anchor.end(), -1);
+    std::fill(dist.begin(), dist.end(), kInf);
+
+    beginPass(true, nullptr);
+    for (int s : sources) relax(s, 0.0f, s);
+    propagate();
+}
+
+void GeodesicField::addSource(int s, std::vector<int>& changed) {
+    // New minimum = min(old field, field of s): grow from s through every vertex it improves
+    beginPass(true, &changed);
+    relax(s, 0.0f, s);
+    propagate();
+}
+
+void GeodesicField::removeSource(int s, std::vector<int>& changed) {
+    beginPass(false, &changed);
+
+    // The region owned by s is connected through its shortest-path tree; flood it and reset it.
+    std::vector<int> region;
+    region.push_back(s);
+    touched[s] = epoch;
+    for (size_t r = 0; r < region.size(); ++r) {
+        const int u = region[r];
+        auto visit = [&](int v) {
+            if (v != -1 && anchor[v] == s && touched[v] != epoch) {
+                touched[v] = epoch;
+                region.push_back(v);
+            }
+        };
+        for (int k = edgeStart[u]; k < edgeStart[u + 1]; ++k) visit(edgeNbr[k]);
+        for (int k = 2 * triStart[u]; k < 2 * triStart[u + 1]; ++k) visit(triOther[k]);
+    }
+    refill(region, &changed);
+}
+
+void GeodesicField::removeEdges(const std::vector<LocalConstraint>& edges, const std::vector<int>& triangles,
+                                std::vector<int>& changed) {
+    beginPass(false, &changed);
+
+    // Seeds: the far end of every cut edge and the corners of every cut triangle, which may have
+    // been reached through them. Sources (distance 0) never depend on anything.
+    std::vector<int> region;
+    auto seed = [&](int v) {
+        if (anchor[v] != -1 && dist[v] > 0.0f && touched[v] != epoch) {
+            touched[v] = epoch;
+            region.push_back(v);
+        }
+    };
+    for (const LocalConstraint& c : edges) {
+        cutEdge(c.i, c.j);
+        if (dist[c.i] >= dist[c.j]) seed(c.i);
+        if (dist[c.j] >= dist[c.i]) seed(c.j);
+    }
+    for (size_t t = 0; t + 2 < triangles.size(); t += 3) {
+        cutTriangle(triangles[t], triangles[t + 1], triangles[t + 2]);
+        for (int k = 0; k < 3; ++k) seed(triangles[t + k]);
+    }
+
+    // Everything downstream of a seed (farther, same anchor) may have had its shortest path
+    // through it. A superset of the affected vertices, bounded by the cut's shadow.
+    for (size_t r = 0; r < region.size(); ++r) {
+        const int u = region[r];
+        auto visit = [&](int v) {
+            if (v != -1 && touched[v] != epoch && anchor[v] == anchor[u] && dist[v] > dist[u]) {
+                touched[v] = epoch;
+                region.push_back(v);
+            }
+        };
+        for (int k = edgeStart[u]; k < edgeStart[u + 1]; ++k) {
+            if (edgeLen[k] < kInf) visit(edgeNbr[k]);
+        }
+        for (int k = 2 * triStart[u]; k < 2 * triStart[u + 1]; ++k) visit(triOther[k]);
+    }
+    refill(region, &changed);
+}
+
+void GeodesicField::growRegion(std::vector<int>& region, const std::function<bool(int, int)>& follow,
+                               std::vector<int>& border) {
+    beginPass(false, nullptr);
+    size_t kept = 0;
+    for (int v : region) {
+        if (touched[v] == epoch) continue;
+        touched[v] = epoch;
+        region[kept++] = v;
+    }
+    region.resize(kept);
+
+    for (size_t r = 0; r < region.size(); ++r) {
+        const int u = region[r];
+        auto visit = [&](int v) {
+            if (v != -1 && touched[v] != epoch && follow(u, v)) {
+                touched[v] = epoch;
+                region.push_back(v);
+            }
+        };
+        for (int k = edgeStart[u]; k < edgeStart[u + 1]; ++k) {
+            if (edgeLen[k] < kInf) visit(edgeNbr[k]);
+        }
+        for (int k = 2 * triStart[u]; k < 2 * triStart[u + 1]; ++k) visit(triOther[k]);
+    }
+
+    // `closed` marks the border in this pass
+    border.clear();
+    for (int u : region) {
+        auto visit = [&](int v) {
+            if (v != -1 && touched[v] != epoch && closed[v] != epoch) {
+                closed[v] = epoch;
+                border.push_back(v);
+            }
+        };
+        for (int k = edgeStart[u]; k < edgeStart[u + 1]; ++k) {
+            if (edgeLen[k] < kInf) visit(edgeNbr[k]);
+        }
+        for (int k = 2 * triStart[u]; k < 2 * triStart[u + 1]; ++k) visit(triOther[k]);
+    }
+}
+
+void GeodesicField::regionPasses(const std::vector<int>& region, const std::vector<int>& border,
+                                 const std::vector<RegionSeed>& seeds, const std::function<void(int)>& visit) {
+    savedAnchor.clear();
+    savedDist.clear();
+    for (const std::vector<int>* set : {&region, &border}) {
+        for (int v : *set) {
+            savedAnchor.push_back(anchor[v]);
+            savedDist.push_back(dist[v]);
+        }
+    }
+
+    for (size_t b = 0; b < seeds.size();) {
+        const int s = seeds[b].source;
+        size_t e = b;
+        while (e < seeds.size() && seeds[e].source == s) ++e;
+
+        for (int v : border) {
+            anchor[v] = -1;
+            dist[v] = kInf;
+        }
+        for (size_t k = b; k < e; ++k) {
+            anchor[seeds[k].v] = s;
+            dist[seeds[k].v] = seeds[k].d;
+        }
+        beginPass(false, nullptr);
+        for (int v : region) touched[v] = epoch;
+        refill(region, nullptr);
+        visit(s);
+        b = e;
+    }
+
+    size_t k = 0;
+    for (const std::vector<int>* set : {&region, &border}) {
+        for (int v : *set) {
+            anchor[v] = savedAnchor[k];
+            dist[v] = savedDist[k++];
+        }
+    }
+}
+
+// Reset `region` (touched in this pass) and propagate into it from its fixed border only
+void GeodesicField::refill(const std::vector<int>& region, std::vector<int>* changed) {
+    for (int v : region) {
+        anchor[v] = -1;
+        dist[v] = kInf;
+        if (changed) changed->push_back(v);
+    }
+
+    for (int w : region) {
+        for (int k = edgeStart[w]; k < edgeStart[w + 1]; ++k) {
+            int n = edgeNbr[k];
+            if (!isOpen(n) && anchor[n] != -1) relax(w, dist[n] + edgeLen[k], anchor[n]);
+        }
+        for (int k = triStart[w]; k < triStart[w + 1]; ++k) {
+            int u = triOther[2 * k], v = triOther[2 * k + 1];
+            if (u == -1 || isOpen(u) || isOpen(v) || anchor[u] == -1 || anchor[u] != anchor[v]) continue;
+            relax(w, triangleUpdate(u, v, w), anchor[u]);
+        }
+    }
+    propagate();
+}
+
+// Cut edges stay in the CSR with infinite length, so nothing relaxes across them
+void GeodesicField::cutEdge(int a, int b) {
+    for (int k = edgeStart[a]; k < edgeStart[a + 1]; ++k) {
+        if (edgeNbr[k] == b) edgeLen[k] = kInf;
+    }
+    for (int k = edgeStart[b]; k < edgeStart[b + 1]; ++k) {
+        if (edgeNbr[k] == a) edgeLen[k] = kInf;
+    }
+}
+
+void GeodesicField::cutTriangle(int a, int b, int c) {
+    const int corners[3] = {a, b, c};
+    for (int m = 0; m < 3; ++m) {
+        const int v = corners[m], p = corners[(m + 1) % 3], q = corners[(m + 2) % 3];
+        for (int k = triStart[v]; k < triStart[v + 1]; ++k) {
+            int& u = triOther[2 * k];
+            int& w = triOther[2 * k + 1];
+            if ((u == p && w == q) || (u == q && w == p)) {
+                u = w = -1;
+                break;
+            }
+        }
+    }
+}
+
+void GeodesicField::relax(int v, float d, int a) {
+    if (closed[v] == epoch || d >= dist[v]) return;
+    if (touched[v] != epoch) {
+        if (!growing) return;
+        touched[v] = epoch;
+        if (changedOut) changedOut->push_back(v);
+    }
+    dist[v] = d;
+    anchor[v] = a;
+    heap.push_back({d, v});
+    std::push_heap(heap.begin(), heap.end(), std::greater<HeapEntry>());
+}
+
+// Distance at `c` from the virtual point source implied by the known distances at `a` and `b`,
+// unfolded into the triangle's plane. Returns kInf if the straight ray does not cross edge ab
+// (the edge updates cover that case).
+float GeodesicField::triangleUpdate(int a, int b, int c) const {
+    const vec3 ab = rest[b] - rest[a];
+    const vec3 ac = rest[c] - rest[a];
+    const float len = length(ab);
+    if (len < 1e-9f) return kInf;
+
+    // c in the 2D frame with a at the origin and b on +x
+    const float cx = dot(ac, ab) / len;
+    const float cy = length(cross(ab, ac)) / len;
+    if (cy < 1e-9f) return kInf;
+
+    // Source on the opposite side of ab
+    const float da = dist[a], db = dist[b];
+    const float sx = (da * da - db * db + len * len) / (2.0f * len);
+    // Rays through a vertex (collinear source, t at an end of ab) are common on regular
+    // grids, so both tests get a small relative tolerance.
+    const float tol = 1e-4f * len;
+    const float sy2 = da * da - sx * sx;
+    if (sy2 < -tol * tol) return kInf;
+    const float sy = -std::sqrt(std::max(0.0f, sy2));
+
+    // Where the ray s -> c crosses y = 0
+    const float t = sx + (cx - sx) * (-sy) / (cy - sy);
+    if (t < -tol || t > len + tol) return kInf;
+
+    return std::sqrt((cx - sx) * (cx - sx) + (cy - sy) * (cy - sy));
+}
+
+void GeodesicField::propagate() {
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), std::greater<HeapEntry>());
+        HeapEntry e = heap.back();
+        heap.pop_back();
+        const int u = e.v;
+        if (closed[u] == epoch || e.d > dist[u]) continue; // stale entry
+        closed[u] = epoch;
+        const int a = anchor[u];
+
+        for (int k = edgeStart[u]; k < edgeStart[u + 1]; ++k) {
+            relax(edgeNbr[k], dist[u] + edgeLen[k], a);
+        }
+
+        // Fast-marching update of the third corner of triangles with two settled corners
+        // that were reached from the same attachment.
+        for (int k = triStart[u]; k < triStart[u + 1]; ++k) {
+            int v = triOther[2 * k], w = triOther[2 * k + 1];
+            if (v == -1) continue;
+            if (isOpen(v)) std::swap(v, w);
+            if (isOpen(v) || closed[w] == epoch || anchor[v] != a) continue;
+            relax(w, triangleUpdate(u, v, w), a);
+        }
+    }
+}
@@ -0,0 +1,122 @@
+// geodesic.h - Nearest-attachment field over the cloth surface (multi-source Dijkstra / fast marching)
+//
+// Every particle gets the attachment that is closest along the mesh and the geodesic distance to it,
+// which becomes the LRA tether length. Distances are propagated from all attachments at once in
+// O(E log V). Along edges this is plain Dijkstra; where triangles are available each triangle also
+// performs a fast-marching style planar-unfolding update, so straight lines across a flat patch are
+// measured exactly instead of as a zig-zag of edges.
+//
+// Pins can be added or removed afterwards without a full pass: adding a source only re-propagates
+// through the vertices it gets closer to, removing one only re-fills the region it used to own.
+// Edges cut out of the mesh (tearing) likewise only re-fill the vertices downstream of the cut,
+// and per-source passes restricted to such a region re-rank the K nearest sources behind it.
+
+#pragma once
+
+#include "cloth_types.h"
+
+#include <functional>
+#include <vector>
+
+class GeodesicField {
+public:
+    // Known distance from `source` to vertex `v`, seeding a regionPasses() pass
+    struct RegionSeed {
+        int source;
+        int v;
+        float d;
+        bool operator<(const RegionSeed& o) const { return source < o.source; }
+    };
+
+    // Snapshot the rest configuration and build vertex -> edge / triangle adjacency.
+    // `triangles` holds 3 particle indices per triangle and may be empty.
+    void build(const ParticleStore& P, const std::vector<LocalConstraint>& edges, const std::vector<int>& triangles);
+
+    // Full multi-source pass from `sources`; replaces any previous result
+    void compute(const std::vector<int>& sources);
+
+    // Bounded updates after compute(). `changed` receives every vertex whose anchor or
+    // distance may have changed (the new pin itself included).
+    void addSource(int s, std::vector<int>& changed);
+    void removeSource(int s, std::vector<int>& changed);
+
+    // Drop edges and triangles (3 corners each) from the adjacency and re-fill every vertex whose
+    // shortest path may have crossed them. Vertices left with no path to a source get anchor -1.
+    // Needs the adjacency (setTopology() after restore()).
+    void removeEdges(const std::vector<LocalConstraint>& edges, const std::vector<int>& triangles, std::vector<int>& changed);
+
+    // Grow `region` (duplicates are dropped) by every neighbour v of a region vertex u, across
+    // live edges and triangles, for which follow(u, v) holds, until it is closed under that.
+    // `border` receives the neighbours left outside it.
+    void growRegion(std::vector<int>& region, const std::function<bool(int, int)>& follow, std::vector<int>& border);
+
+    // Single-source passes confined to `region`, one per source in `seeds` (sorted by source, on
+    // `border` vertices only): the region is re-filled from that source's seeds, then visit(s)
+    // reads anchorOf() / distanceOf() of the region vertices. Paths through border vertices
+    // without a seed for the source are not seen, so distances are upper bounds. The field's
+    // own result is restored afterwards.
+    void regionPasses(const std::vector<int>& region, const std::vector<int>& border,
+                      const std::vector<RegionSeed>& seeds, const std::function<void(int)>& visit);
+
+    // Renumber vertices after a layout change (newIndexOf[old] = new) and rebuild adjacency
+    // from the already remapped topology. Rest positions and the current result are kept.
+    void remap(const std::vector<int>& newIndexOf, const std::vector<LocalConstraint>& edges, const std::vector<int>& triangles);
+
+    // Adopt a previously computed field (e.g. from a baked asset) instead of build() + compute().
+    // Adjacency is not built; call setTopology() before the first addSource / removeSource.
+    void restore(const vec3* restPositions, const int* anchors, const float* distances, int n);
+    bool hasTopology() const { return !edgeStart.empty(); }
+    void setTopology(const std::vector<LocalConstraint>& edges, const std::vector<int>& triangles) {
+        buildAdjacency(edges, triangles);
+    }
+
+    // Raw arrays for serialization, size() entries each
+    const vec3*  restData() const { return rest.data(); }
+    const int*   anchorData() const { return anchor.data(); }
+    const float* distanceData() const { return dist.data(); }
+
+    int   anchorOf(int i) const { return anchor[i]; }   // -1 if not connected to any source
+    float distanceOf(int i) const { return dist[i]; }
+    int   size() const { return (int)rest.size(); }
+
+private:
+    struct HeapEntry {
+        float d;
+        int v;
+        bool operator>(const HeapEntry& o) const { return d > o.d; }
+    };
+
+    void buildAdjacency(const std::vector<LocalConstraint>& edges, const std::vector<int>& triangles);
+    void beginPass(bool grow, std::vector<int>* changed);
+    void refill(const std::vector<int>& region, std::vector<int>* changed);
+    void cutEdge(int a, int b);
+    void cutTriangle(int a, int b, int c);
+    bool isOpen(int v) const { return touched[v] == epoch && closed[v] != epoch; }
+    void relax(int v, float d, int a);
+    void propagate();
+    float triangleUpdate(int a, int b, int c) const;
+
+    std::vector<vec3> rest;
+
+    // CSR adjacency
+    std::vector<int> edgeStart, edgeNbr;
+    std::vector<float> edgeLen;
+    std::vector<int> triStart, triOther; // per incident triangle: the two other corners (pairs), -1 once cut
+
+    // Result
+    std::vector<int> anchor;
+    std::vector<float> dist;
+
+    // Pass state. A vertex is open once touched in the current epoch and until it is closed
+    // (settled); everything else is fixed. Growing passes may touch any vertex they improve,
+    // non-growing passes only update vertices opened up front.
+    std::vector<unsigned> touched, closed;
+    unsigned epoch = 0;
+    bool growing = true;
+    std::vector<int>* changedOut = nullptr;
+    std::vector<HeapEntry> heap;
+
+    // regionPasses(): the result it overwrites, region then border
+    std::vector<int> savedAnchor;
+    std::vector<float> savedDist;
+};
@@ -0,0 +1,387 @@
+// gl_compute.cpp - GL 4.3 compute-shader backend for ClothInstance::simulate()
+
+#include "gl_compute.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <string>
+
+static const int kGroupSize = 256;
+
+// One source, one entry point per KERNEL_* define. Positions carry the inverse mass in w.
+static const char* kKernelSource = R"GLSL(
+layout(local_size_x = 256) in;
+
+struct Edge   { int i; int j; float restLen; float compliance; };
+struct Tether { int p; int a; float maxDist; int pad; };
+struct Anchor { vec3 target; int i; };
+
+layout(std430, binding = 0) buffer Pos          { vec4 x[]; };
+layout(std430, binding = 1) buffer Prev         { vec4 px[]; };
+layout(std430, binding = 2) buffer Vel          { vec4 v[]; };
+layout(std430, binding = 3) readonly buffer Edges   { Edge edges[]; };
+layout(std430, binding = 4) readonly buffer Tethers { Tether tethers[]; };
+layout(std430, binding = 5) buffer StepStart    { vec4 x0[]; };
+layout(std430, binding = 6) buffer Render       { vec4 render[]; };
+layout(std430, binding = 7) readonly buffer VertTriOffsets { int vtOffset[]; };
+layout(std430, binding = 8) readonly buffer VertTris       { int vtTri[]; };
+layout(std430, binding = 9) readonly buffer Tris           { int tri[]; };
+layout(std430, binding = 10) readonly buffer Anchors        { Anchor anchors[]; };
+layout(std430, binding = 11) buffer Lambda         { float lambda[]; };
+
+uniform int uCount;
+uniform int uOffset;
+uniform float uH;
+uniform float uDamping;
+uniform vec3 uGravity;
+uniform float uSlack;
+uniform float uAlpha;
+uniform int uTethers;
+
+void main() {
+    int k = int(gl_GlobalInvocationID.x);
+    if (k >= uCount) return;
+
+#if defined(KERNEL_INTEGRATE)
+    vec4 p = x[k];
+    if (p.w == 0.0) return; // pinned
+    vec3 vel = v[k].xyz + uGravity * uH;
+    v[k].xyz = vel;
+    px[k] = p;
+    x[k].xyz = p.xyz + vel * uH;
+
+#elif defined(KERNEL_LOCAL)
+    // One colour batch: no two edges share a particle. XPBD as projectEdge(), uAlpha = 1 / h^2
+    Edge e = edges[uOffset + k];
+    vec4 pi = x[e.i], pj = x[e.j];
+    vec3 d = pi.xyz - pj.xyz;
+    float dist = length(d);
+    float wSum = pi.w + pj.w;
+    if (dist < 1e-6 || wSum < 1e-6) return;
+    // Rigid edges are plain PBD and keep no multiplier, as on the CPU
+    float dl = -(dist - e.restLen) / wSum;
+    if (e.compliance > 0.0) {
+        float a = e.compliance * uAlpha;
+        dl = -(dist - e.restLen + a * lambda[uOffset + k]) / (wSum + a);
+        lambda[uOffset + k] += dl;
+    }
+    float s = dl / dist;
+    x[e.i].xyz = pi.xyz + d * (s * pi.w);
+    x[e.j].xyz = pj.xyz - d * (s * pj.w);
+
+#elif defined(KERNEL_CLEAR)
+    lambda[k] = 0.0;
+
+#elif defined(KERNEL_LRA)
+    // One invocation per tethered particle, applying its uTethers tethers in order. Only that
+    // particle moves; anchors are pinned and never written.
+    int p = tethers[k * uTethers].p;
+    vec3 pos = x[p].xyz;
+    for (int q = k * uTethers; q < (k + 1) * uTethers; ++q) {
+        Tether t = tethers[q];
+        vec3 a = x[t.a].xyz;
+        vec3 d = pos - a;
+        float dist = length(d);
+        float limit = t.maxDist * uSlack;
+        if (dist > limit && dist >= 1e-6) pos = a + d * (limit / dist);
+    }
+    x[p].xyz = pos;
+
+#elif defined(KERNEL_ANCHORS)
+    // Skinned anchor: uAlpha = 1 / remaining substeps of the way to its target, as sweepAnchors()
+    Anchor an = anchors[k];
+    vec3 p = x[an.i].xyz;
+    vec3 d = (an.target - p) * uAlpha;
+    px[an.i].xyz = p;
+    x[an.i].xyz = p + d;
+    v[an.i].xyz = d / uH;
+
+#elif defined(KERNEL_VELOCITY)
+    vec4 p = x[k];
+    if (p.w == 0.0) return;
+    v[k].xyz = (p.xyz - px[k].xyz) * (uDamping / uH);
+
+#elif defined(KERNEL_BLEND)
+    render[k] = vec4(mix(x0[k].xyz, x[k].xyz, uAlpha), 1.0);
+
+#elif defined(KERNEL_NORMALS)
+    // Area-weighted normal over the incident triangles; normals follow the n positions
+    vec3 n = vec3(0.0);
+    for (int q = vtOffset[k]; q < vtOffset[k + 1]; ++q) {
+        int t = vtTri[q] * 3;
+        vec3 a = render[tri[t]].xyz, b = render[tri[t + 1]].xyz, c = render[tri[t + 2]].xyz;
+        n += cross(b - a, c - a);
+    }
+    float len = length(n);
+    render[uCount + k] = vec4(len > 0.0 ? n / len : n, 0.0);
+#endif
+}
+)GLSL";
+
+static GLuint compileKernel(const char* define) {
+    std::string header = std::string("#version 430\n#define ") + define + "\n";
+    const char* sources[2] = {header.c_str(), kKernelSource};
+
+    GLuint shader = glx.CreateShader(GL_COMPUTE_SHADER);
+    glx.ShaderSource(shader, 2, sources, nullptr);
+    glx.CompileShader(shader);
+
+    GLint ok = 0;
+    glx.GetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+    if (!ok) {
+        char log[2048];
+        glx.GetShaderInfoLog(shader, sizeof(log), nullptr, log);
+        printf("GPU solver: %s failed to compile:\n%s\n", define, log);
+        glx.DeleteShader(shader);
+        return 0;
+    }
+
+    GLuint program = glx.CreateProgram();
+    glx.AttachShader(program, shader);
+    glx.LinkProgram(program);
+    glx.DeleteShader(shader);
+    glx.GetProgramiv(program, GL_LINK_STATUS, &ok);
+    if (!ok) {
+        char log[2048];
+        glx.GetProgramInfoLog(program, sizeof(log), nullptr, log);
+        printf("GPU solver: %s failed to link:\n%s\n", define, log);
+        glx.DeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+bool GpuClothSolver::buildKernels() {
+    static const char* defines[K_COUNT] = {
+        "KERNEL_INTEGRATE", "KERNEL_LOCAL", "KERNEL_LRA", "KERNEL_VELOCITY", "KERNEL_BLEND", "KERNEL_NORMALS",
+        "KERNEL_ANCHORS", "KERNEL_CLEAR"
+    };
+    for (int k = 0; k < K_COUNT; ++k) {
+        Kernel& kn = kernels[k];
+        kn.program = compileKernel(defines[k]);
+        if (!kn.program) return false;
+        // Uniforms a kernel does not use are optimized out and report -1
+        kn.count = glx.GetUniformLocation(kn.program, "uCount");
+        kn.offset = glx.GetUniformLocation(kn.program, "uOffset");
+        kn.h = glx.GetUniformLocation(kn.program, "uH");
+        kn.damping = glx.GetUniformLocation(kn.program, "uDamping");
+        kn.gravity = glx.GetUniformLocation(kn.program, "uGravity");
+        kn.slack = glx.GetUniformLocation(kn.program, "uSlack");
+        kn.alpha = glx.GetUniformLocation(kn.program, "uAlpha");
+        kn.tethers = glx.GetUniformLocation(kn.program, "uTethers");
+    }
+    glx.GenBuffers(BUF_COUNT, buffers);
+    return true;
+}
+
+static void uploadBuffer(GLuint buffer, size_t bytes, const void* data) {
+    glx.BindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+    // Empty SSBOs cannot be bound, so every buffer gets at least one element
+    glx.BufferData(GL_SHADER_STORAGE_BUFFER, std::max<size_t>(bytes, 16), data, GL_DYNAMIC_DRAW);
+}
+
+bool GpuClothSolver::upload(const ClothInstance& cloth) {
+    if (failed) return false;
+    if (!built) {
+        built = true;
+        if (!buildKernels()) {
+            failed = true;
+            release();
+            return false;
+        }
+    }
+
+    const ParticleStore& P = cloth.P;
+    const int n = (int)P.size();
+    numParticles = n;
+    params = cloth.params;
+
+    std::vector<float> pos(n * 4), prev(n * 4), vel(n * 4, 0.0f);
+    for (int i = 0; i < n; ++i) {
+        pos[i * 4 + 0] = P.x[i];  pos[i * 4 + 1] = P.y[i];  pos[i * 4 + 2] = P.z[i];  pos[i * 4 + 3] = P.w[i];
+        prev[i * 4 + 0] = P.px[i]; prev[i * 4 + 1] = P.py[i]; prev[i * 4 + 2] = P.pz[i]; prev[i * 4 + 3] = P.w[i];
+        vel[i * 4 + 0] = P.vx[i]; vel[i * 4 + 1] = P.vy[i]; vel[i * 4 + 2] = P.vz[i];
+    }
+    uploadBuffer(buffers[BUF_POS], pos.size() * sizeof(float), pos.data());
+    uploadBuffer(buffers[BUF_PREV], prev.size() * sizeof(float), prev.data());
+    uploadBuffer(buffers[BUF_VEL], vel.size() * sizeof(float), vel.data());
+    uploadBuffer(buffers[BUF_STEP_START], pos.size() * sizeof(float), pos.data());
+    uploadBuffer(buffers[BUF_RENDER], pos.size() * 2 * sizeof(float), nullptr);
+
+    // Edges keep the colour grouping; one dispatch per colour
+    struct GpuEdge { int i, j; float restLen; float compliance; };
+    std::vector<GpuEdge> edges;
+    edges.reserve(cloth.localConstraints.size());
+    compliant = false;
+    for (const auto& c : cloth.localConstraints) {
+        edges.push_back({c.i, c.j, c.restLen, c.compliance});
+        compliant |= c.compliance > 0.0f;
+    }
+    uploadBuffer(buffers[BUF_EDGES], edges.size() * sizeof(GpuEdge), edges.data());
+    std::vector<float> lambda(edges.size(), 0.0f);
+    uploadBuffer(buffers[BUF_LAMBDA], lambda.size() * sizeof(float), lambda.data());
+    colorOffsets = cloth.localColorOffsets;
+    if (colorOffsets.size() < 2) colorOffsets = {0, (int)edges.size()};
+
+    struct GpuTether { int p, a; float maxDist; int pad; };
+    std::vector<GpuTether> tethers;
+    tethers.reserve(cloth.lraConstraints.size());
+    for (const auto& c : cloth.lraConstraints) tethers.push_back({c.particleIdx, c.attachmentIdx, c.maxDist, 0});
+    uploadBuffer(buffers[BUF_TETHERS], tethers.size() * sizeof(GpuTether), tethers.data());
+    numTethers = (int)tethers.size();
+    tethersPerParticle = cloth.tethersPerParticle;
+
+    // Vertex -> incident triangles (CSR) for the normals gather
+    const int numTris = (int)cloth.triangles.size() / 3;
+    std::vector<int> vtOffset(n + 1, 0), vtTri(numTris * 3);
+    for (int v : cloth.triangles) ++vtOffset[v + 1];
+    for (int i = 0; i < n; ++i) vtOffset[i + 1] += vtOffset[i];
+    std::vector<int> fill(vtOffset.begin(), vtOffset.end() - 1);
+    for (int t = 0; t < numTris * 3; ++t) vtTri[fill[cloth.triangles[t]]++] = t / 3;
+    uploadBuffer(buffers[BUF_VERT_TRI_OFFSETS], vtOffset.size() * sizeof(int), vtOffset.data());
+    uploadBuffer(buffers[BUF_VERT_TRIS], vtTri.size() * sizeof(int), vtTri.data());
+    uploadBuffer(buffers[BUF_TRIS], cloth.triangles.size() * sizeof(int), cloth.triangles.data());
+    uploadBuffer(buffers[BUF_ANCHORS], 0, nullptr);
+    numAnchors = 0;
+    glx.BindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    for (int b = 0; b < BUF_COUNT; ++b) glx.BindBufferBase(GL_SHADER_STORAGE_BUFFER, b, buffers[b]);
+    uploadedVersion = cloth.topologyVersion;
+    return true;
+}
+
+void GpuClothSolver::moveAnchors(const ClothInstance& cloth) {
+    if (!built || failed || !cloth.skin.moved) return;
+    struct GpuAnchor { float x, y, z; int i; };
+    std::vector<GpuAnchor> anchors(cloth.skin.size());
+    for (size_t k = 0; k < anchors.size(); ++k) {
+        anchors[k] = {cloth.skin.x[k], cloth.skin.y[k], cloth.skin.z[k], cloth.attachmentIndices[k]};
+    }
+    // The indexed binding refers to the buffer object, so it survives re-specifying the store
+    uploadBuffer(buffers[BUF_ANCHORS], anchors.size() * sizeof(GpuAnchor), anchors.data());
+    glx.BindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    numAnchors = (int)anchors.size();
+}
+
+void GpuClothSolver::download(ClothInstance& cloth) const {
+    if (!built || failed || numParticles != (int)cloth.P.size()) return;
+    const int n = numParticles;
+    std::vector<float> pos(n * 4), prev(n * 4), vel(n * 4);
+
+    glx.MemBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    glx.BindBuffer(GL_SHADER_STORAGE_BUFFER, buffers[BUF_POS]);
+    glx.GetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, pos.size() * sizeof(float), pos.data());
+    glx.BindBuffer(GL_SHADER_STORAGE_BUFFER, buffers[BUF_PREV]);
+    glx.GetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, prev.size() * sizeof(float), prev.data());
+    glx.BindBuffer(GL_SHADER_STORAGE_BUFFER, buffers[BUF_VEL]);
+    glx.GetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, vel.size() * sizeof(float), vel.data());
+    glx.BindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    ParticleStore& P = cloth.P;
+    for (int i = 0; i < n; ++i) {
+        P.x[i] = pos[i * 4 + 0];  P.y[i] = pos[i * 4 + 1];  P.z[i] = pos[i * 4 + 2];
+        P.px[i] = prev[i * 4 + 0]; P.py[i] = prev[i * 4 + 1]; P.pz[i] = prev[i * 4 + 2];
+        P.vx[i] = vel[i * 4 + 0]; P.vy[i] = vel[i * 4 + 1]; P.vz[i] = vel[i * 4 + 2];
+    }
+}
+
+void GpuClothSolver::dispatch(const Kernel& k, int count) {
+    if (count <= 0) return;
+    glx.Uniform1i(k.count, count);
+    glx.DispatchCompute((count + kGroupSize - 1) / kGroupSize, 1, 1);
+    glx.MemBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+void GpuClothSolver::step() {
+    if (!built || failed || numParticles == 0) return;
+
+    // Start-of-step snapshot for present(); the CPU path keeps this in FixedStepDriver
+    const size_t posBytes = size_t(numParticles) * 4 * sizeof(float);
+    glx.BindBuffer(GL_COPY_READ_BUFFER, buffers[BUF_POS]);
+    glx.BindBuffer(GL_COPY_WRITE_BUFFER, buffers[BUF_STEP_START]);
+    glx.CopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, posBytes);
+    glx.BindBuffer(GL_COPY_READ_BUFFER, 0);
+    glx.BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    const int substeps = std::max(1, params.substeps);
+    const float h = dt / substeps;
+    const float damping = (substeps == 1) ? 0.99f : std::pow(0.99f, 1.0f / substeps);
+
+    for (int s = 0; s < substeps; ++s) {
+        if (numAnchors > 0) {
+            const Kernel& anchors = kernels[K_ANCHORS];
+            glx.UseProgram(anchors.program);
+            glx.Uniform1f(anchors.h, h);
+            glx.Uniform1f(anchors.alpha, 1.0f / (substeps - s));
+            dispatch(anchors, numAnchors);
+        }
+
+        const Kernel& integrate = kernels[K_INTEGRATE];
+        glx.UseProgram(integrate.program);
+        glx.Uniform1f(integrate.h, h);
+        glx.Uniform3f(integrate.gravity, g.x, g.y, g.z);
+        dispatch(integrate, numParticles);
+
+        // XPBD multipliers start from zero every substep; rigid edges never read them
+        if (compliant) {
+            glx.UseProgram(kernels[K_CLEAR].program);
+            dispatch(kernels[K_CLEAR], (int)colorOffsets.back());
+        }
+
+        for (int iter = 0; iter < params.iterations; ++iter) {
+            // Colours run in sequence (Gauss-Seidel across batches), edges of a colour in parallel
+            const Kernel& local = kernels[K_LOCAL];
+            glx.UseProgram(local.program);
+            glx.Uniform1f(local.alpha, 1.0f / (h * h));
+            for (size_t c = 0; c + 1 < colorOffsets.size(); ++c) {
+                glx.Uniform1i(local.offset, colorOffsets[c]);
+                dispatch(local, colorOffsets[c + 1] - colorOffsets[c]);
+            }
+
+            if (params.useLRA) {
+                const Kernel& lra = kernels[K_LRA];
+                glx.UseProgram(lra.program);
+                glx.Uniform1f(lra.slack, params.lraSlack);
+                glx.Uniform1i(lra.tethers, tethersPerParticle);
+                dispatch(lra, numTethers / tethersPerParticle);
+            }
+        }
+
+        const Kernel& velocity = kernels[K_VELOCITY];
+        glx.UseProgram(velocity.program);
+        glx.Uniform1f(velocity.h, h);
+        glx.Uniform1f(velocity.damping, damping);
+        dispatch(velocity, numParticles);
+    }
+    numAnchors = 0; // targets reached
+    glx.UseProgram(0);
+}
+
+void GpuClothSolver::present(float alpha) {
+    if (!built || failed || numParticles == 0) return;
+
+    const Kernel& blend = kernels[K_BLEND];
+    glx.UseProgram(blend.program);
+    glx.Uniform1f(blend.alpha, alpha);
+    dispatch(blend, numParticles);
+
+    glx.UseProgram(kernels[K_NORMALS].program);
+    dispatch(kernels[K_NORMALS], numParticles);
+    glx.UseProgram(0);
+
+    // The renderer sources renderBuffer() as a vertex array next
+    glx.MemBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+}
+
+void GpuClothSolver::release() {
+    for (auto& k : kernels) {
+        if (k.program) glx.DeleteProgram(k.program);
+        k = Kernel();
+    }
+    if (buffers[0]) glx.DeleteBuffers(BUF_COUNT, buffers);
+    std::fill(buffers, buffers + BUF_COUNT, 0u);
+    built = false;
+    numParticles = numTethers = numAnchors = 0;
+    uploadedVersion = ~0u;
+}
@@ -0,0 +1,80 @@
+// gl_compute.h - GL 4.3 compute-shader backend for ClothInstance::simulate()
+//
+// Particle state lives in shader storage buffers for the whole session: prediction, per-colour
+// local constraint batches, the (fully parallel) LRA pass and the velocity update run as
+// dispatches, and the interpolated positions + normals for display are written to a buffer the
+// renderer draws from directly. Nothing is read back unless download() is called.
+
+#pragma once
+
+#include "gl_platform.h"
+#include "simulation.h"
+
+#include <vector>
+
+class GpuClothSolver {
+public:
+    // Needs a current GL 4.3 context and loadGLExtensions()
+    static bool supported() { return glx.hasCompute; }
+
+    // Copy the cloth (state + topology) and its params to the GPU. Compiles the kernels on first
+    // use. Returns false if they fail to build.
+    bool upload(const ClothInstance& cloth);
+
+    // Copy positions / velocities back into `cloth` (before editing it on the CPU)
+    void download(ClothInstance& cloth) const;
+
+    // Send the skinned anchor targets of the last ClothInstance::skinAttachments(); the next
+    // step() sweeps the anchors to them across its substeps, like simulate()
+    void moveAnchors(const ClothInstance& cloth);
+
+    // One fixed step of dt: params.substeps substeps of params.iterations iterations each, like
+    // simulate(). Only substeps, iterations, useLRA and lraSlack apply; edges always run in colour
+    // batches with the XPBD update whatever solverMode says.
+    void step();
+
+    // Settings of the following steps, e.g. the cloth's params after ClothInstance::applyCommands()
+    // (queued pins, impulses and teleports act on the CPU copy: download() first, upload() after;
+    // see CommandQueue::pendingEdits())
+    void setParams(const SolverParams& p) { params = p; }
+
+    // Blend the last two steps by `alpha` and compute normals into renderBuffer()
+    void present(float alpha);
+
+    // n positions followed by n normals, vec4 each
+    GLuint renderBuffer() const { return buffers[BUF_RENDER]; }
+
+    // topologyVersion of the cloth last uploaded (~0u before the first upload)
+    unsigned version() const { return uploadedVersion; }
+
+    void release();
+
+private:
+    enum Buffer {
+        BUF_POS, BUF_PREV, BUF_VEL, BUF_EDGES, BUF_TETHERS, BUF_STEP_START, BUF_RENDER,
+        BUF_VERT_TRI_OFFSETS, BUF_VERT_TRIS, BUF_TRIS, BUF_ANCHORS, BUF_LAMBDA, BUF_COUNT
+    };
+    enum KernelId { K_INTEGRATE, K_LOCAL, K_LRA, K_VELOCITY, K_BLEND, K_NORMALS, K_ANCHORS, K_CLEAR, K_COUNT };
+
+    struct Kernel {
+        GLuint program = 0;
+        GLint count = -1, offset = -1, h = -1, damping = -1, gravity = -1, slack = -1, alpha = -1, tethers = -1;
+    };
+
+    bool buildKernels();
+    void dispatch(const Kernel& k, int count);
+
+    Kernel kernels[K_COUNT];
+    GLuint buffers[BUF_COUNT] = {};
+    bool built = false;
+    bool failed = false;
+
+    int numParticles = 0;
+    int numTethers = 0;
+    int numAnchors = 0; // pending skinned anchor targets for the next step()
+    int tethersPerParticle = 1;
+    bool compliant = false; // some edge has XPBD compliance: clear the multipliers every substep
+    SolverParams params;
+    std::vector<int> colorOffsets;
+    unsigned uploadedVersion = ~0u;
+};
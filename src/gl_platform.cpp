@@ -0,0 +1,101 @@
+// gl_platform.cpp - Runtime loading of the GL entry points used by the renderer
+
+#include "gl_platform.h"
+
+#include <cstdio>
+#include <cstring>
+
+GLExt glx;
+
+bool glVersionAtLeast(int major, int minor) {
+    const char* v = (const char*)glGetString(GL_VERSION);
+    int ma = 0, mi = 0;
+    if (!v || sscanf(v, "%d.%d", &ma, &mi) != 2) return false;
+    return ma > major || (ma == major && mi >= minor);
+}
+
+bool hasGLExtension(const char* name) {
+    const char* ext = (const char*)glGetString(GL_EXTENSIONS);
+    if (!ext) return false;
+    const size_t len = strlen(name);
+    for (const char* p = strstr(ext, name); p; p = strstr(p + len, name)) {
+        if ((p == ext || p[-1] == ' ') && (p[len] == ' ' || p[len] == '\0')) return true;
+    }
+    return false;
+}
+
+#if defined(__APPLE__) || defined(MACOSX)
+
+void loadGLExtensions() {
+    // OpenGL.framework links the 2.1 core directly; no 4.x in the legacy context
+    glx.GenBuffers = glGenBuffers;
+    glx.DeleteBuffers = glDeleteBuffers;
+    glx.BindBuffer = glBindBuffer;
+    glx.BufferData = (void (APIENTRY*)(GLenum, lraGLsizeiptr, const void*, GLenum))glBufferData;
+    glx.BufferSubData = (void (APIENTRY*)(GLenum, lraGLintptr, lraGLsizeiptr, const void*))glBufferSubData;
+    glx.GetBufferSubData = (void (APIENTRY*)(GLenum, lraGLintptr, lraGLsizeiptr, void*))glGetBufferSubData;
+    glx.hasBuffers = true;
+    glx.hasBufferStorage = false;
+    glx.hasCompute = false;
+}
+
+#else
+
+template <typename F>
+static void load(F& f, const char* name) {
+    f = reinterpret_cast<F>(glutGetProcAddress(name));
+}
+
+void loadGLExtensions() {
+    load(glx.GenBuffers, "glGenBuffers");
+    load(glx.DeleteBuffers, "glDeleteBuffers");
+    load(glx.BindBuffer, "glBindBuffer");
+    load(glx.BufferData, "glBufferData");
+    load(glx.BufferSubData, "glBufferSubData");
+    load(glx.GetBufferSubData, "glGetBufferSubData");
+    glx.hasBuffers = glVersionAtLeast(1, 5) && glx.GenBuffers && glx.DeleteBuffers && glx.BindBuffer &&
+                     glx.BufferData && glx.BufferSubData;
+
+    // glXGetProcAddress returns non-null for any name, so check version / extension first
+    if (glVersionAtLeast(4, 4) || hasGLExtension("GL_ARB_buffer_storage")) {
+        load(glx.BufferStorage, "glBufferStorage");
+        load(glx.MapBufferRange, "glMapBufferRange");
+        load(glx.FenceSync, "glFenceSync");
+        load(glx.ClientWaitSync, "glClientWaitSync");
+        load(glx.DeleteSync, "glDeleteSync");
+        glx.hasBufferStorage = glx.hasBuffers && glx.BufferStorage && glx.MapBufferRange &&
+                               glx.FenceSync && glx.ClientWaitSync && glx.DeleteSync;
+    }
+
+    if (glVersionAtLeast(4, 3) || hasGLExtension("GL_ARB_compute_shader")) {
+        load(glx.CreateShader, "glCreateShader");
+        load(glx.ShaderSource, "glShaderSource");
+        load(glx.CompileShader, "glCompileShader");
+        load(glx.GetShaderiv, "glGetShaderiv");
+        load(glx.GetShaderInfoLog, "glGetShaderInfoLog");
+        load(glx.DeleteShader, "glDeleteShader");
+        load(glx.CreateProgram, "glCreateProgram");
+        load(glx.AttachShader, "glAttachShader");
+        load(glx.LinkProgram, "glLinkProgram");
+        load(glx.GetProgramiv, "glGetProgramiv");
+        load(glx.GetProgramInfoLog, "glGetProgramInfoLog");
+        load(glx.DeleteProgram, "glDeleteProgram");
+        load(glx.UseProgram, "glUseProgram");
+        load(glx.GetUniformLocation, "glGetUniformLocation");
+        load(glx.Uniform1i, "glUniform1i");
+        load(glx.Uniform1f, "glUniform1f");
+        load(glx.Uniform3f, "glUniform3f");
+        load(glx.BindBufferBase, "glBindBufferBase");
+        load(glx.CopyBufferSubData, "glCopyBufferSubData");
+        load(glx.DispatchCompute, "glDispatchCompute");
+        load(glx.MemBarrier, "glMemoryBarrier");
+        glx.hasCompute = glx.hasBuffers && glx.GetBufferSubData && glx.CreateShader && glx.ShaderSource &&
+                         glx.CompileShader && glx.GetShaderiv && glx.GetShaderInfoLog && glx.DeleteShader &&
+                         glx.CreateProgram && glx.AttachShader && glx.LinkProgram && glx.GetProgramiv &&
+                         glx.GetProgramInfoLog && glx.DeleteProgram && glx.UseProgram && glx.GetUniformLocation &&
+                         glx.Uniform1i && glx.Uniform1f && glx.Uniform3f && glx.BindBufferBase &&
+                         glx.CopyBufferSubData && glx.DispatchCompute && glx.MemBarrier;
+    }
+}
+
+#endif
@@ -0,0 +1,118 @@
+// gl_platform.h - GL/GLUT headers per platform plus the post-1.1 entry points used by the renderer and GPU solver
+//
+// Windows' opengl32 only exports GL 1.1, so everything newer is fetched at runtime through
+// glutGetProcAddress (freeglut). Apple's GLUT has no glutGetProcAddress, but OpenGL.framework
+// exports the GL 2.1 core directly; GL 4.x paths are simply reported as unavailable there.
+
+#pragma once
+
+#if defined(WIN32)
+#pragma warning(disable:4996)
+#include <GL/freeglut.h>
+#elif defined(__APPLE__) || defined(MACOSX)
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+#define GL_SILENCE_DEPRECATION
+#include <GLUT/glut.h>
+#else
+#include <GL/freeglut.h>
+#endif
+
+#include <cstddef>
+
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+
+// Tokens missing from GL 1.1 headers
+#ifndef GL_ARRAY_BUFFER
+#define GL_ARRAY_BUFFER                 0x8892
+#define GL_ELEMENT_ARRAY_BUFFER         0x8893
+#define GL_STREAM_DRAW                  0x88E0
+#define GL_STATIC_DRAW                  0x88E4
+#define GL_DYNAMIC_DRAW                 0x88E8
+#endif
+#ifndef GL_MAP_WRITE_BIT
+#define GL_MAP_WRITE_BIT                0x0002
+#endif
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT           0x0040
+#define GL_MAP_COHERENT_BIT             0x0080
+#endif
+#ifndef GL_COMPUTE_SHADER
+#define GL_COMPUTE_SHADER               0x91B9
+#define GL_SHADER_STORAGE_BUFFER        0x90D2
+#define GL_SHADER_STORAGE_BARRIER_BIT   0x00002000
+#define GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT 0x00000001
+#define GL_BUFFER_UPDATE_BARRIER_BIT    0x00000200
+#endif
+#ifndef GL_COMPILE_STATUS
+#define GL_COMPILE_STATUS               0x8B81
+#define GL_LINK_STATUS                  0x8B82
+#define GL_INFO_LOG_LENGTH              0x8B84
+#endif
+#ifndef GL_COPY_READ_BUFFER
+#define GL_COPY_READ_BUFFER             0x8F36
+#define GL_COPY_WRITE_BUFFER            0x8F37
+#endif
+#ifndef GL_SYNC_GPU_COMMANDS_COMPLETE
+#define GL_SYNC_GPU_COMMANDS_COMPLETE   0x9117
+#define GL_SYNC_FLUSH_COMMANDS_BIT      0x00000001
+#define GL_TIMEOUT_EXPIRED              0x911B
+#define GL_WAIT_FAILED                  0x911D
+#endif
+
+typedef ptrdiff_t lraGLsizeiptr;
+typedef ptrdiff_t lraGLintptr;
+typedef struct __GLsync* lraGLsync;
+
+// Entry points above GL 1.1, loaded by loadGLExtensions()
+struct GLExt {
+    void (APIENTRY* GenBuffers)(GLsizei, GLuint*) = nullptr;
+    void (APIENTRY* DeleteBuffers)(GLsizei, const GLuint*) = nullptr;
+    void (APIENTRY* BindBuffer)(GLenum, GLuint) = nullptr;
+    void (APIENTRY* BufferData)(GLenum, lraGLsizeiptr, const void*, GLenum) = nullptr;
+    void (APIENTRY* BufferSubData)(GLenum, lraGLintptr, lraGLsizeiptr, const void*) = nullptr;
+    void (APIENTRY* GetBufferSubData)(GLenum, lraGLintptr, lraGLsizeiptr, void*) = nullptr;
+
+    // GL 4.4 / ARB_buffer_storage + GL 3.2 sync objects (persistent mapping)
+    void (APIENTRY* BufferStorage)(GLenum, lraGLsizeiptr, const void*, GLbitfield) = nullptr;
+    void* (APIENTRY* MapBufferRange)(GLenum, lraGLintptr, lraGLsizeiptr, GLbitfield) = nullptr;
+    lraGLsync (APIENTRY* FenceSync)(GLenum, GLbitfield) = nullptr;
+    GLenum (APIENTRY* ClientWaitSync)(lraGLsync, GLbitfield, unsigned long long) = nullptr;
+    void (APIENTRY* DeleteSync)(lraGLsync) = nullptr;
+
+    // GL 4.3 compute shaders + shader storage buffers
+    GLuint (APIENTRY* CreateShader)(GLenum) = nullptr;
+    void (APIENTRY* ShaderSource)(GLuint, GLsizei, const char* const*, const GLint*) = nullptr;
+    void (APIENTRY* CompileShader)(GLuint) = nullptr;
+    void (APIENTRY* GetShaderiv)(GLuint, GLenum, GLint*) = nullptr;
+    void (APIENTRY* GetShaderInfoLog)(GLuint, GLsizei, GLsizei*, char*) = nullptr;
+    void (APIENTRY* DeleteShader)(GLuint) = nullptr;
+    GLuint (APIENTRY* CreateProgram)() = nullptr;
+    void (APIENTRY* AttachShader)(GLuint, GLuint) = nullptr;
+    void (APIENTRY* LinkProgram)(GLuint) = nullptr;
+    void (APIENTRY* GetProgramiv)(GLuint, GLenum, GLint*) = nullptr;
+    void (APIENTRY* GetProgramInfoLog)(GLuint, GLsizei, GLsizei*, char*) = nullptr;
+    void (APIENTRY* DeleteProgram)(GLuint) = nullptr;
+    void (APIENTRY* UseProgram)(GLuint) = nullptr;
+    GLint (APIENTRY* GetUniformLocation)(GLuint, const char*) = nullptr;
+    void (APIENTRY* Uniform1i)(GLint, GLint) = nullptr;
+    void (APIENTRY* Uniform1f)(GLint, GLfloat) = nullptr;
+    void (APIENTRY* Uniform3f)(GLint, GLfloat, GLfloat, GLfloat) = nullptr;
+    void (APIENTRY* BindBufferBase)(GLenum, GLuint, GLuint) = nullptr;
+    void (APIENTRY* CopyBufferSubData)(GLenum, GLenum, lraGLintptr, lraGLintptr, lraGLsizeiptr) = nullptr;
+    void (APIENTRY* DispatchCompute)(GLuint, GLuint, GLuint) = nullptr;
+    void (APIENTRY* MemBarrier)(GLbitfield) = nullptr; // glMemoryBarrier (MemoryBarrier is a winnt.h macro)
+
+    bool hasBuffers = false;        // GL 1.5 vertex/index buffer objects
+    bool hasBufferStorage = false;  // persistent, coherent mapping
+    bool hasCompute = false;        // compute shaders + SSBOs
+};
+
+extern GLExt glx;
+
+// Call once with a current context
+void loadGLExtensions();
+
+bool glVersionAtLeast(int major, int minor);
+bool hasGLExtension(const char* name);
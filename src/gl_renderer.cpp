@@ -0,0 +1,265 @@
+// gl_renderer.cpp - Cloth renderer on persistent vertex / index buffers
+
+#include "gl_renderer.h"
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+// Buffer offsets are passed to the gl*Pointer / glDrawElements calls as pointers
+static const char* bufferOffset(size_t bytes) { return reinterpret_cast<const char*>(uintptr_t(bytes)); }
+
+const char* ClothRenderer::pathName() const {
+    switch (path) {
+    case PATH_PERSISTENT:     return "persistent-mapped";
+    case PATH_BUFFER_OBJECTS: return "buffer-objects";
+    default:                  return "client-arrays";
+    }
+}
+
+void ClothRenderer::init() {
+    if (glx.hasBufferStorage) path = PATH_PERSISTENT;
+    else if (glx.hasBuffers) path = PATH_BUFFER_OBJECTS;
+    else path = PATH_CLIENT_ARRAYS;
+
+    if (path != PATH_CLIENT_ARRAYS) {
+        glx.GenBuffers(1, &indexBuffer);
+        glx.GenBuffers(1, &colorBuffer);
+    }
+    initialized = true;
+    printf("Renderer: %s\n", pathName());
+}
+
+void ClothRenderer::release() {
+    if (path != PATH_CLIENT_ARRAYS && initialized) {
+        for (auto& f : fences) {
+            if (f) glx.DeleteSync(f);
+            f = nullptr;
+        }
+        GLuint buffers[3] = {indexBuffer, colorBuffer, streamBuffer};
+        glx.DeleteBuffers(3, buffers);
+    }
+    indexBuffer = colorBuffer = streamBuffer = 0;
+    mapped = nullptr;
+    streamVertices = 0;
+    initialized = false;
+    version = ~0u;
+}
+
+void ClothRenderer::rebuildTopology(const ClothTopology& topology) {
+    indices.clear();
+    indices.reserve(topology.edges.size() + topology.triangles.size() + topology.tethers.size());
+    indices.insert(indices.end(), topology.edges.begin(), topology.edges.end());
+    edgeCount = (GLsizei)indices.size();
+    indices.insert(indices.end(), topology.triangles.begin(), topology.triangles.end());
+    triCount = (GLsizei)indices.size() - edgeCount;
+    indices.insert(indices.end(), topology.tethers.begin(), topology.tethers.end());
+    lraCount = (GLsizei)indices.size() - edgeCount - triCount;
+
+    const int n = topology.numParticles();
+    colors.resize(n * 3);
+    for (int i = 0; i < n; ++i) {
+        bool pinned = topology.pinned[i] != 0;
+        colors[i * 3 + 0] = pinned ? 1.0f : 0.2f; // Red for attachments
+        colors[i * 3 + 1] = pinned ? 0.2f : 0.4f; // Blue for free
+        colors[i * 3 + 2] = pinned ? 0.2f : 1.0f;
+    }
+
+    if (path != PATH_CLIENT_ARRAYS) {
+        glx.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+        glx.BufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+        glx.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        glx.BindBuffer(GL_ARRAY_BUFFER, colorBuffer);
+        glx.BufferData(GL_ARRAY_BUFFER, colors.size() * sizeof(float), colors.data(), GL_STATIC_DRAW);
+        glx.BindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    version = topology.version;
+}
+
+const ClothTopology& ClothRenderer::snapshot(const ClothInstance& cloth) {
+    if (own.version != cloth.topologyVersion) cloth.copyTopology(own);
+    return own;
+}
+
+void ClothRenderer::reserveStream(int numVertices) {
+    if (numVertices == streamVertices) return;
+    streamVertices = numVertices;
+    slotBytes = size_t(numVertices) * 2 * sizeof(vec3); // positions, then normals
+
+    if (path == PATH_CLIENT_ARRAYS) {
+        clientStream.resize(slotBytes);
+        return;
+    }
+    if (path == PATH_BUFFER_OBJECTS) {
+        if (!streamBuffer) glx.GenBuffers(1, &streamBuffer);
+        return; // sized by orphaning every frame
+    }
+
+    // Immutable storage cannot be resized: drain the ring and start a new buffer
+    for (auto& f : fences) {
+        if (f) {
+            glx.ClientWaitSync(f, GL_SYNC_FLUSH_COMMANDS_BIT, ~0ull);
+            glx.DeleteSync(f);
+            f = nullptr;
+        }
+    }
+    if (streamBuffer) glx.DeleteBuffers(1, &streamBuffer);
+    glx.GenBuffers(1, &streamBuffer);
+    glx.BindBuffer(GL_ARRAY_BUFFER, streamBuffer);
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glx.BufferStorage(GL_ARRAY_BUFFER, slotBytes * kSlots, nullptr, flags);
+    mapped = (char*)glx.MapBufferRange(GL_ARRAY_BUFFER, 0, slotBytes * kSlots, flags);
+    glx.BindBuffer(GL_ARRAY_BUFFER, 0);
+    slot = 0;
+
+    if (!mapped) {
+        // Driver refused the mapping; fall back for the rest of the session
+        glx.DeleteBuffers(1, &streamBuffer);
+        streamBuffer = 0;
+        path = PATH_BUFFER_OBJECTS;
+        streamVertices = 0;
+        reserveStream(numVertices);
+        printf("Renderer: persistent mapping failed, using %s\n", pathName());
+    }
+}
+
+void ClothRenderer::computeNormals(const ClothTopology& topology, const std::vector<vec3>& pos) {
+    // Area-weighted vertex normals
+    const std::vector<int>& tris = topology.triangles;
+    normals.assign(pos.size(), vec3(0.0f));
+    for (size_t t = 0; t + 2 < tris.size(); t += 3) {
+        int a = tris[t], b = tris[t + 1], c = tris[t + 2];
+        vec3 n = glm::cross(pos[b] - pos[a], pos[c] - pos[a]);
+        normals[a] += n;
+        normals[b] += n;
+        normals[c] += n;
+    }
+    for (auto& n : normals) {
+        float len = glm::length(n);
+        if (len > 0.0f) n /= len;
+    }
+}
+
+const char* ClothRenderer::stream(const std::vector<vec3>& pos) {
+    const size_t posBytes = pos.size() * sizeof(vec3);
+    const size_t bytes = shaded ? posBytes * 2 : posBytes;
+
+    if (path == PATH_CLIENT_ARRAYS) {
+        memcpy(clientStream.data(), pos.data(), posBytes);
+        if (shaded) memcpy(clientStream.data() + posBytes, normals.data(), posBytes);
+        return clientStream.data();
+    }
+
+    glx.BindBuffer(GL_ARRAY_BUFFER, streamBuffer);
+    if (path == PATH_BUFFER_OBJECTS) {
+        // Orphan so the driver hands out fresh storage instead of stalling on the last frame
+        glx.BufferData(GL_ARRAY_BUFFER, slotBytes, nullptr, GL_STREAM_DRAW);
+        glx.BufferSubData(GL_ARRAY_BUFFER, 0, posBytes, pos.data());
+        if (shaded) glx.BufferSubData(GL_ARRAY_BUFFER, posBytes, posBytes, normals.data());
+        return bufferOffset(0);
+    }
+
+    // Wait until the GPU has finished reading this slot (kSlots frames ago)
+    slot = (slot + 1) % kSlots;
+    if (lraGLsync f = fences[slot]) {
+        while (glx.ClientWaitSync(f, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull) == GL_TIMEOUT_EXPIRED) {}
+        glx.DeleteSync(f);
+        fences[slot] = nullptr;
+    }
+    char* dst = mapped + slot * slotBytes;
+    memcpy(dst, pos.data(), posBytes);
+    if (shaded) memcpy(dst + posBytes, normals.data(), bytes - posBytes);
+    return bufferOffset(slot * slotBytes);
+}
+
+void ClothRenderer::draw(const ClothTopology& topology, const std::vector<vec3>& pos, bool drawLRA) {
+    if (!initialized) init();
+    if (version != topology.version) rebuildTopology(topology);
+    if (pos.empty() || (int)pos.size() != topology.numParticles()) return;
+    reserveStream((int)pos.size());
+
+    if (shaded) computeNormals(topology, pos);
+    const char* base = stream(pos);
+    submit((int)pos.size(), base, base + pos.size() * sizeof(vec3), 0, drawLRA);
+    if (path == PATH_PERSISTENT) fences[slot] = glx.FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void ClothRenderer::drawResident(const ClothTopology& topology, GLuint vertexBuffer, bool drawLRA) {
+    if (!initialized) init();
+    if (!glx.hasBuffers) return;
+    if (version != topology.version) rebuildTopology(topology);
+    const int n = topology.numParticles();
+    if (n == 0) return;
+
+    glx.BindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    submit(n, bufferOffset(0), bufferOffset(size_t(n) * 4 * sizeof(float)), 4 * sizeof(float), drawLRA);
+}
+
+void ClothRenderer::draw(const ClothInstance& cloth, const std::vector<vec3>& pos, bool drawLRA) {
+    draw(snapshot(cloth), pos, drawLRA);
+}
+
+void ClothRenderer::drawResident(const ClothInstance& cloth, GLuint vertexBuffer, bool drawLRA) {
+    drawResident(snapshot(cloth), vertexBuffer, drawLRA);
+}
+
+// Expects the position / normal source buffer (or 0 for client arrays) bound to GL_ARRAY_BUFFER
+void ClothRenderer::submit(int numVertices, const char* posBase, const char* normalBase, GLsizei stride, bool drawLRA) {
+    const bool buffers = path != PATH_CLIENT_ARRAYS;
+    const char* idx = buffers ? bufferOffset(0) : (const char*)indices.data();
+    if (buffers) glx.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, stride, posBase);
+
+    if (shaded) {
+        // Lit mesh; the light is fixed relative to the world
+        static const GLfloat lightDir[4] = {0.3f, 0.8f, 0.6f, 0.0f};
+        glEnable(GL_LIGHTING);
+        glEnable(GL_LIGHT0);
+        glLightfv(GL_LIGHT0, GL_POSITION, lightDir);
+        glLightModeli(GL_LIGHT_MODEL_TWO_SIDE, GL_TRUE);
+        glEnable(GL_COLOR_MATERIAL);
+        glEnableClientState(GL_NORMAL_ARRAY);
+        glNormalPointer(GL_FLOAT, stride, normalBase);
+
+        glColor3f(0.7f, 0.7f, 0.85f);
+        glEnable(GL_POLYGON_OFFSET_FILL);
+        glPolygonOffset(1.0f, 1.0f);
+        glDrawElements(GL_TRIANGLES, triCount, GL_UNSIGNED_INT, idx + edgeCount * sizeof(GLuint));
+        glDisable(GL_POLYGON_OFFSET_FILL);
+
+        glDisableClientState(GL_NORMAL_ARRAY);
+        glDisable(GL_COLOR_MATERIAL);
+        glDisable(GL_LIGHTING);
+    } else {
+        // Cloth lines
+        glColor3f(0.8f, 0.8f, 0.9f);
+        glDrawElements(GL_LINES, edgeCount, GL_UNSIGNED_INT, idx);
+    }
+
+    // Points, coloured by pin state
+    if (buffers) glx.BindBuffer(GL_ARRAY_BUFFER, colorBuffer);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glColorPointer(3, GL_FLOAT, 0, buffers ? bufferOffset(0) : (const char*)colors.data());
+    glPointSize(3.0f);
+    glDrawArrays(GL_POINTS, 0, (GLsizei)numVertices);
+    glDisableClientState(GL_COLOR_ARRAY);
+
+    // LRA lines (faint green) to visualize attachments
+    if (drawLRA && lraCount) {
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glColor4f(0.2f, 1.0f, 0.2f, 0.15f);
+        glDrawElements(GL_LINES, lraCount, GL_UNSIGNED_INT, idx + (edgeCount + triCount) * sizeof(GLuint));
+        glDisable(GL_BLEND);
+    }
+
+    glDisableClientState(GL_VERTEX_ARRAY);
+    if (buffers) {
+        glx.BindBuffer(GL_ARRAY_BUFFER, 0);
+        glx.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    }
+}
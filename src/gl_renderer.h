@@ -0,0 +1,71 @@
+// gl_renderer.h - Cloth renderer on persistent vertex / index buffers
+//
+// Edge, triangle and LRA index lists live in one static index buffer, rebuilt only when the
+// topology's version changes. The topology is either a ClothTopology snapshot (e.g. the one in a
+// SimulationThread frame, safe while another thread changes the cloth) or the cloth itself. Each frame only the particle positions (and, when shaded,
+// per-vertex normals) are streamed: into a 3-slot persistently mapped ring on GL 4.4 /
+// ARB_buffer_storage, by orphaning a buffer object on GL 1.5, or from client arrays otherwise.
+
+#pragma once
+
+#include "gl_platform.h"
+#include "simulation.h"
+
+#include <vector>
+
+class ClothRenderer {
+public:
+    enum Path { PATH_CLIENT_ARRAYS, PATH_BUFFER_OBJECTS, PATH_PERSISTENT };
+
+    // Lit triangle mesh instead of the constraint wireframe
+    bool shaded = false;
+
+    // `pos` holds one position per particle of `topology` (e.g. ClothFrame::interpolate output).
+    // Needs a current context and loadGLExtensions().
+    void draw(const ClothTopology& topology, const std::vector<vec3>& pos, bool drawLRA);
+
+    // Same, sourcing n positions then n normals (vec4 each) from a buffer already on the GPU,
+    // e.g. GpuClothSolver::renderBuffer(). Nothing is streamed.
+    void drawResident(const ClothTopology& topology, GLuint vertexBuffer, bool drawLRA);
+
+    // Drawing straight from a cloth owned by the calling thread (snapshotted on topology changes)
+    void draw(const ClothInstance& cloth, const std::vector<vec3>& pos, bool drawLRA);
+    void drawResident(const ClothInstance& cloth, GLuint vertexBuffer, bool drawLRA);
+
+    // Free GL objects; the next draw() starts over
+    void release();
+
+    const char* pathName() const;
+
+private:
+    static const int kSlots = 3;
+
+    void init();
+    void rebuildTopology(const ClothTopology& topology);
+    const ClothTopology& snapshot(const ClothInstance& cloth);
+    void reserveStream(int numVertices);
+    const char* stream(const std::vector<vec3>& pos); // base for the attribute pointers
+    void computeNormals(const ClothTopology& topology, const std::vector<vec3>& pos);
+    void submit(int numVertices, const char* posBase, const char* normalBase, GLsizei stride, bool drawLRA);
+
+    bool initialized = false;
+    Path path = PATH_CLIENT_ARRAYS;
+    unsigned version = ~0u;
+    ClothTopology own; // snapshot for the ClothInstance overloads
+
+    // Static data, also the source for the client-array path
+    std::vector<GLuint> indices; // edges | triangles | LRA pairs
+    std::vector<float> colors;   // per particle, pinned vs free
+    GLsizei edgeCount = 0, triCount = 0, lraCount = 0;
+    GLuint indexBuffer = 0, colorBuffer = 0;
+
+    // Streamed per frame: positions followed by normals
+    GLuint streamBuffer = 0;
+    int streamVertices = 0;
+    size_t slotBytes = 0;
+    char* mapped = nullptr;
+    int slot = 0;
+    lraGLsync fences[kSlots] = {};
+    std::vector<vec3> normals;
+    std::vector<char> clientStream; // same layout as one slot, for PATH_CLIENT_ARRAYS
+};
@@ -0,0 +1,62 @@
+// layout.cpp - Cache-friendly particle ordering (Morton / Z-order curve)
+
+#include "layout.h"
+#include "build_scratch.h"
+
+#include <algorithm>
+#include <cstdint>
+
+// Spread the low 10 bits of v so there are two zero bits between each
+static uint32_t expandBits(uint32_t v) {
+    v &= 0x3ff;
+    v = (v | (v << 16)) & 0x030000ff;
+    v = (v | (v << 8))  & 0x0300f00f;
+    v = (v | (v << 4))  & 0x030c30c3;
+    v = (v | (v << 2))  & 0x09249249;
+    return v;
+}
+
+void mortonOrder(const ParticleStore& P, std::vector<int>& order) {
+    const int n = (int)P.size();
+    order.resize(n);
+    if (n == 0) return;
+
+    vec3 lo = P.position(0), hi = lo;
+    for (int i = 1; i < n; ++i) {
+        vec3 p = P.position(i);
+        lo = vec3(std::min(lo.x, p.x), std::min(lo.y, p.y), std::min(lo.z, p.z));
+        hi = vec3(std::max(hi.x, p.x), std::max(hi.y, p.y), std::max(hi.z, p.z));
+    }
+    // Uniform scale keeps the curve isotropic for thin (flat) cloths
+    float extent = std::max(hi.x - lo.x, std::max(hi.y - lo.y, hi.z - lo.z));
+    float scale = extent > 0.0f ? 1023.0f / extent : 0.0f;
+
+    // (code, index) keys: an unstable sort on them is the stable sort by code, without
+    // std::stable_sort's temporary buffer
+    std::vector<uint64_t>& keys = buildScratch().keys;
+    keys.resize(n);
+    for (int i = 0; i < n; ++i) {
+        vec3 q = (P.position(i) - lo) * scale;
+        uint32_t code = (expandBits((uint32_t)q.x) << 2) | (expandBits((uint32_t)q.y) << 1) | expandBits((uint32_t)q.z);
+        keys[i] = ((uint64_t)code << 32) | (uint32_t)i;
+    }
+    std::sort(keys.begin(), keys.end());
+    for (int k = 0; k < n; ++k) order[k] = (int)(keys[k] & 0xffffffffu);
+}
+
+// Gather through `tmp`, then copy back so `a` keeps its own (exactly reserved) storage
+template <typename T>
+static void permuteArray(std::vector<T>& a, const std::vector<int>& order, std::vector<T>& tmp) {
+    tmp.resize(a.size());
+    for (size_t k = 0; k < order.size(); ++k) tmp[k] = a[order[k]];
+    std::copy(tmp.begin(), tmp.end(), a.begin());
+}
+
+void permuteParticles(ParticleStore& P, const std::vector<int>& order) {
+    std::vector<float>& f = buildScratch().floats;
+    permuteArray(P.x, order, f);  permuteArray(P.y, order, f);  permuteArray(P.z, order, f);
+    permuteArray(P.px, order, f); permuteArray(P.py, order, f); permuteArray(P.pz, order, f);
+    permuteArray(P.vx, order, f); permuteArray(P.vy, order, f); permuteArray(P.vz, order, f);
+    permuteArray(P.w, order, f);
+    permuteArray(P.pinned, order, buildScratch().bytes);
+}
@@ -0,0 +1,14 @@
+// layout.h - Cache-friendly particle ordering (Morton / Z-order curve)
+
+#pragma once
+
+#include "cloth_types.h"
+
+#include <vector>
+
+// Particle order along a Morton curve through the bounding box of the current positions.
+// Fills order[newIndex] = oldIndex.
+void mortonOrder(const ParticleStore& P, std::vector<int>& order);
+
+// Applies order[newIndex] = oldIndex to every particle array in place
+void permuteParticles(ParticleStore& P, const std::vector<int>& order);
@@ -2,76 +2,32 @@
 // Implementation based on "Long Range Attachments - A Method to Simulate Inextensible Clothing in Computer Games"
 // Using structure from previous hpbd.cpp
 
-#if defined(WIN32)
-#pragma warning(disable:4996)
-#include <GL/freeglut.h>
-#elif defined(__APPLE__) || defined(MACOSX)
-#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
-#define GL_SILENCE_DEPRECATION
-#include <GLUT/glut.h>
-#else
-#include <GL/freeglut.h>
-#endif
+#include "gl_platform.h"
 
 #include <glm/glm.hpp>
-#include <glm/gtc/type_ptr.hpp>
 #include <vector>
 #include <cmath>
 #include <algorithm>
 #include <cstdio>
-
-using glm::vec3;
-using glm::length;
-using glm::dot;
-using glm::normalize;
-
-// ---------------------------------------------------------
-// Data Structures
-// ---------------------------------------------------------
-
-struct Particle {
-    vec3 p;         // position
-    vec3 old_p;     // previous position (for Verlet)
-    vec3 v;         // velocity
-    float w;        // inverse mass (0 = infinite mass/pinned)
-    bool pinned = false;
-};
-
-// Standard PBD distance constraint (Local)
-struct LocalConstraint {
-    int i, j;
-    float restLen;
-};
-
-// Long Range Attachment Constraint (Global)
-struct LRAConstraint {
-    int particleIdx;
-    int attachmentIdx; // Index of the pinned particle used as anchor
-    float maxDist;     // Initial geodesic (or euclidean in flat case) distance
-};
+#include <cstdlib>
+#include <cstring>
+
+#include "simulation.h"
+#include "lra_simd.h"
+#include "thread_pool.h"
+#include "fixed_step.h"
+#include "sim_thread.h"
+#include "profiler.h"
+#include "gl_renderer.h"
+#include "gl_compute.h"
+#include "cloth_asset.h"
+#include "replay.h"
+#include "mesh_import.h"
 
 // ---------------------------------------------------------
 // Globals
 // ---------------------------------------------------------
 
-// Simulation Constants
-static const float dt = 1.0f / 60.0f;
-static const vec3 g(0.0f, -9.8f, 0.0f);
-static const int clothW = 30;
-static const int clothH = 30; // Taller to show stretching better
-static const float spacing = 0.05f;
-
-// Data
-std::vector<Particle> P;
-std::vector<LocalConstraint> localConstraints;
-std::vector<LRAConstraint> lraConstraints;
-std::vector<int> attachmentIndices; // Indices of pinned particles
-
-// Parameters
-int  g_iterations = 5;       // Low iteration count to demonstrate LRA benefit
-bool g_useLRA = true;        // Toggle LRA
-float g_lraSlack = 1.0f;     // 1.0 = exact length, 1.2 = 20% stretch allowed (Fig 5)
-
 // Camera
 float camDist = 3.5f;
 float camYaw = 0.0f;
@@ -80,161 +36,190 @@ glm::vec2 camPan(0.0f, -1.0f);
 int lastMouseX = 0, lastMouseY = 0;
 bool lbtn = false, rbtn = false;
 
-// ---------------------------------------------------------
-// Simulation Core
-// ---------------------------------------------------------
-
-inline int idx(int x, int y) { return y * clothW + x; }
-
-void buildScene() {
-    P.clear();
-    P.resize(clothW * clothH);
-    localConstraints.clear();
-    lraConstraints.clear();
-    attachmentIndices.clear();
-
-    // 1. Init Particles
-    for (int y = 0; y < clothH; ++y) {
-        for (int x = 0; x < clothW; ++x) {
-            int id = idx(x, y);
-            // Center the cloth horizontally
-            P[id].p = vec3((x - (clothW - 1) * 0.5f) * spacing,
-                           (clothH - 1 - y) * spacing, 
-                           0.0f);
-            P[id].old_p = P[id].p;
-            P[id].v = vec3(0.0f);
-            
-            // Pin top corners (Hanging Cloth setup)
-            bool isPinned = (y == 0 && (x == 0 || x == clothW - 1));
-            
-            if (isPinned) {
-                P[id].w = 0.0f;
-                P[id].pinned = true;
-                attachmentIndices.push_back(id);
-            } else {
-                P[id].w = 1.0f;
-                P[id].pinned = false;
-            }
-        }
-    }
+// The simulated cloth and its fixed-timestep driver
+ClothInstance g_cloth;
+FixedStepDriver g_driver;
+
+// Profiler overlay / trace capture
+bool g_showProfiler = false;
+static const char* kTracePath = "lra_trace.json";
+
+// Packed positions interpolated from the SoA store once per frame
+std::vector<vec3> g_drawPos;
+ClothRenderer g_renderer;
+
+// CPU solver on its own thread; display() draws its published frames. Off (Y) steps in idle().
+SimulationThread g_sim;
+
+// Optional GL 4.3 compute backend: state stays on the GPU while it is active
+GpuClothSolver g_gpu;
+bool g_useGpu = false;
+
+// Grid resolution for buildScene() (--size N), or a baked asset (--asset FILE) or an OBJ / glTF
+// mesh (--mesh FILE) to load instead. Non-grid cloths set it from their extent.
+int g_clothSize = clothW;
+ClothAsset g_asset;
+ClothMesh g_mesh;
+
+// Animated attachments: every pin follows one swaying, twisting bone (A toggles)
+bool g_animate = false;
+float g_animTime = 0.0f;
+
+// Collisions: a sphere "body" in front of the hanging cloth plus self-collision (K toggles)
+bool g_collide = false;
+
+void placeBody() {
+    g_cloth.colliders.clear();
+    g_selfCollision = g_collide;
+    g_cloth.commands.setParam(PARAM_SELF_COLLISION, g_selfCollision);
+    if (!g_collide) return;
+    float size = (g_clothSize - 1) * spacing;
+    g_cloth.colliders.spheres.push_back({vec3(0.0f, 0.35f * size, 0.15f * size), 0.25f * size});
+}
 
-    // 2. Build Local Constraints (Grid edges)
-    auto addEdge = [&](int a, int b) {
-        float d = length(P[a].p - P[b].p);
-        localConstraints.push_back({a, b, d});
-    };
-    for (int y = 0; y < clothH; ++y) {
-        for (int x = 0; x < clothW; ++x) {
-            if (x + 1 < clothW) addEdge(idx(x, y), idx(x + 1, y));
-            if (y + 1 < clothH) addEdge(idx(x, y), idx(x, y + 1));
-        }
-    }
+// Wind: a gusty breeze blowing through the cloth along +z (W toggles)
+bool g_wind = false;
 
-    // 3. Build LRA Constraints
-    // For every free particle, find the closest attachment point and store the initial distance.
-    for (int i = 0; i < (int)P.size(); ++i) {
-        if (P[i].pinned) continue;
-
-        int bestAttach = -1;
-        float minInitDist = 1e30f;
-
-        // Simple strategy: Connect to the spatially closest attachment point in the rest configuration.
-        // Since the mesh is initially flat, Euclidean distance == Geodesic distance.
-        for (int attachID : attachmentIndices) {
-            float d = length(P[i].p - P[attachID].p);
-            if (d < minInitDist) {
-                minInitDist = d;
-                bestAttach = attachID;
-            }
-        }
+// Replay recording of the CPU cloth (X toggles; play back with lra-replay)
+ReplayRecorder g_recorder;
+static const char* kReplayPath = "lra_replay.lrar";
 
-        if (bestAttach != -1) {
-            lraConstraints.push_back({i, bestAttach, minInitDist});
-        }
-    }
+void stopRecording() {
+    if (!g_recorder.recording()) return;
+    int steps = g_recorder.steps();
+    if (g_recorder.end()) printf("Replay written to %s (%d steps, %.1f KB)\n", kReplayPath, steps, g_recorder.bytesWritten() / 1024.0);
+    else printf("Replay: could not write %s\n", kReplayPath);
 }
 
-// Projection for Local Constraints (Standard PBD)
-void projectLocal(const LocalConstraint& c) {
-    Particle& p1 = P[c.i];
-    Particle& p2 = P[c.j];
-    
-    vec3 dir = p1.p - p2.p;
-    float dist = length(dir);
-    if (dist < 1e-6f) return;
-    
-    float correction = (dist - c.restLen) * (1.0f - 0.0f /*stiffness=1*/); // simplified stiff
-    vec3 grad = dir / dist;
-    
-    float wSum = p1.w + p2.w;
-    if (wSum < 1e-6f) return;
+void bindAnchors() {
+    g_cloth.bindAttachments(std::vector<int>(g_cloth.attachmentIndices.size(), g_animate ? 0 : -1));
+}
 
-    vec3 dp = -correction * grad;
-    
-    if (!p1.pinned) p1.p += dp * (p1.w / wSum);
-    if (!p2.pinned) p2.p -= dp * (p2.w / wSum);
+// FixedStepDriver::onStep: sample the bone at the end of the coming step and skin the pins
+void animateAnchors() {
+    if (!g_animate) return;
+    g_animTime += dt;
+    float a = 0.6f * std::sin(g_animTime * 1.3f);
+    float c = std::cos(a), s = std::sin(a);
+    glm::mat4 bone(1.0f);
+    bone[0] = glm::vec4(c, 0.0f, -s, 0.0f);
+    bone[2] = glm::vec4(s, 0.0f, c, 0.0f);
+    bone[3] = glm::vec4(0.4f * std::sin(g_animTime * 0.9f), 0.1f * std::sin(g_animTime * 2.1f), 0.0f, 1.0f);
+    g_cloth.skinAttachments(&bone, 1);
+    if (g_useGpu) g_gpu.moveAnchors(g_cloth);
 }
 
-// Projection for LRA (The Core Algorithm)
-void projectLRA(const LRAConstraint& c) {
-    Particle& p = P[c.particleIdx];
-    const Particle& attach = P[c.attachmentIdx];
+void resetCloth() {
+    if (g_asset.isOpen()) g_asset.instantiate(g_cloth);
+    else if (!g_mesh.positions.empty()) g_cloth.buildMesh(g_mesh.positions, g_mesh.triangles, g_mesh.pinned);
+    else g_cloth.buildScene(g_clothSize, g_clothSize);
+    g_animTime = 0.0f;
+    if (g_animate) bindAnchors();
+    g_driver.reset(g_cloth);
+    if (g_recorder.recording()) g_recorder.rebuilt(g_cloth);
+}
 
-    vec3 dir = p.p - attach.p;
-    float currentDist = length(dir);
-    
-    // Apply Slack (Controlled Stretchiness, Section 3.5)
-    float limit = c.maxDist * g_lraSlack;
-
-    // Unilateral Constraint: Only project if stretched beyond limit
-    if (currentDist > limit) {
-        if (currentDist < 1e-6f) return; 
-        
-        // Project back to the surface of the sphere
-        // p_new = center + dir * limit
-        vec3 correction = dir * (limit / currentDist);
-        p.p = attach.p + correction;
+// Re-upload after any CPU-side edit to the cloth (reset, pin / release)
+void syncGpu() {
+    if (!g_useGpu || g_gpu.version() == g_cloth.topologyVersion) return;
+    g_cloth.wake(); // sleeping particles carry w = 0
+    if (!g_gpu.upload(g_cloth)) {
+        g_useGpu = false;
+        g_driver.reset(g_cloth);
+        g_sim.start(g_cloth);
     }
 }
 
-void simulate() {
-    // 1. Explicit Euler Integration (Prediction)
-    for (auto& p : P) {
-        if (p.pinned) continue;
-        p.v += g * dt;
-        p.old_p = p.p;
-        p.p += p.v * dt;
+void setGpu(bool on) {
+    if (on == g_useGpu) return;
+    if (on) {
+        if (!GpuClothSolver::supported()) {
+            printf("GPU solver: needs OpenGL 4.3 compute shaders\n");
+            return;
+        }
+        // GL lives on this thread, so the GPU solver steps in idle() instead
+        const bool threaded = g_sim.running();
+        g_sim.stop();
+        stopRecording(); // replays cover the CPU solver only
+        g_cloth.wake();
+        g_useGpu = g_gpu.upload(g_cloth);
+        if (!g_useGpu && threaded) g_sim.start(g_cloth);
+    } else {
+        g_gpu.download(g_cloth);
+        g_useGpu = false;
+        g_sim.start(g_cloth);
     }
+    g_driver.reset(g_cloth);
+    printf("Backend: %s\n", g_useGpu ? "GPU compute" : "CPU");
+}
 
-    // 2. Constraint Projection
-    for (int iter = 0; iter < g_iterations; ++iter) {
-        
-        // (A) Local Constraints (Edges)
-        // Maintain local shape / wrinkles
-        for (const auto& c : localConstraints) {
-            projectLocal(c);
-        }
+// ---------------------------------------------------------
+// Visualization & UI
+// ---------------------------------------------------------
 
-        // (B) LRA Constraints (Global Inextensibility)
-        // Enforce global length limits immediately
-        if (g_useLRA) {
-            for (const auto& c : lraConstraints) {
-                projectLRA(c);
-            }
-        }
+void drawText(int x, int y, const char* s) {
+    glRasterPos2i(x, y);
+    for (; *s; ++s) glutBitmapCharacter(GLUT_BITMAP_8_BY_13, *s);
+}
+
+// Rolling per-phase timings (ms per frame) in the top-left corner
+void drawProfilerOverlay() {
+    int w = glutGet(GLUT_WINDOW_WIDTH);
+    int h = glutGet(GLUT_WINDOW_HEIGHT);
+
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
+    glLoadIdentity();
+    gluOrtho2D(0, w, 0, h);
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glLoadIdentity();
+    glDisable(GL_DEPTH_TEST);
+
+    const Profiler& prof = profiler();
+    char buf[128];
+    int y = h - 18;
+    glColor3f(1.0f, 1.0f, 0.6f);
+    snprintf(buf, sizeof(buf), "%-10s %7s %7s %7s %7s  ms/frame (%d frames)%s",
+             "phase", "avg", "p50", "p95", "p99", prof.frames(), prof.tracing() ? "  [TRACE]" : "");
+    drawText(10, y, buf);
+    for (int p = 0; p < PHASE_COUNT; ++p) {
+        Profiler::PhaseStats st = prof.stats(p);
+        snprintf(buf, sizeof(buf), "%-10s %7.3f %7.3f %7.3f %7.3f", phaseName(p), st.avgMs, st.p50Ms, st.p95Ms, st.p99Ms);
+        drawText(10, y -= 15, buf);
     }
 
-    // 3. Velocity Update & Damping
-    for (auto& p : P) {
-        if (p.pinned) continue;
-        p.v = (p.p - p.old_p) / dt;
-        p.v *= 0.99f; // Simple drag
+    glEnable(GL_DEPTH_TEST);
+    glPopMatrix();
+    glMatrixMode(GL_PROJECTION);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+}
+
+void drawCloth() {
+    LRA_PROFILE_SCOPE(PHASE_DISPLAY);
+
+    syncGpu();
+    if (g_useGpu) {
+        // No readback: the solver writes the blended positions the renderer draws from
+        g_gpu.present(g_driver.alpha());
+        g_renderer.drawResident(g_cloth, g_gpu.renderBuffer(), g_useLRA);
+    } else if (g_sim.running()) {
+        // Only the published frame is read here, never g_cloth: the simulation thread changes its
+        // constraints while stepping (queued pins, tethers, compliance, tearing)
+        const ClothFrame& frame = g_sim.latest();
+        if (frame.empty()) return;
+        frame.interpolate(std::chrono::steady_clock::now(), g_drawPos);
+        g_renderer.draw(frame.topology, g_drawPos, g_useLRA);
+    } else {
+        g_driver.interpolate(g_cloth, g_drawPos);
+        g_renderer.draw(g_cloth, g_drawPos, g_useLRA);
     }
 }
 
-// ---------------------------------------------------------
-// Visualization & UI
-// ---------------------------------------------------------
+static const char* solverModeName(int mode) {
+    return mode == SOLVER_JACOBI ? "Jacobi" : mode == SOLVER_COLORED_PARALLEL ? "Colored parallel" : "Gauss-Seidel";
+}
 
 void display() {
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -245,46 +230,43 @@ void display() {
     glRotatef(camPitch * 180.0f / 3.14159265f, 1, 0, 0);
     glRotatef(camYaw   * 180.0f / 3.14159265f, 0, 1, 0);
 
-    // Draw Cloth Lines
-    glColor3f(0.8f, 0.8f, 0.9f);
-    glBegin(GL_LINES);
-    for (const auto& c : localConstraints) {
-        glVertex3fv(glm::value_ptr(P[c.i].p));
-        glVertex3fv(glm::value_ptr(P[c.j].p));
-    }
-    glEnd();
-
-    // Draw Points
-    glPointSize(3.0f);
-    glBegin(GL_POINTS);
-    for(size_t i=0; i<P.size(); ++i) {
-        if(P[i].pinned) glColor3f(1.0f, 0.2f, 0.2f); // Red for attachments
-        else glColor3f(0.2f, 0.4f, 1.0f);            // Blue for free
-        glVertex3fv(glm::value_ptr(P[i].p));
-    }
-    glEnd();
-    
-    // Optional: Draw LRA lines (faint green) to visualize attachments
-    if (g_useLRA) {
-        glColor3f(0.0f, 1.0f, 0.0f);
-        glEnable(GL_BLEND); 
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-        glColor4f(0.2f, 1.0f, 0.2f, 0.15f); // Transparent
-        glBegin(GL_LINES);
-        for(const auto& c : lraConstraints) {
-            // Only draw if significant tension? No, draw all to see topology
-             glVertex3fv(glm::value_ptr(P[c.particleIdx].p));
-             glVertex3fv(glm::value_ptr(P[c.attachmentIdx].p));
-        }
-        glEnd();
-        glDisable(GL_BLEND);
+    drawCloth();
+    for (const SphereCollider& s : g_cloth.colliders.spheres) {
+        glPushMatrix();
+        glTranslatef(s.center.x, s.center.y, s.center.z);
+        glColor3f(0.5f, 0.6f, 0.8f);
+        glutWireSphere(s.radius, 24, 16);
+        glPopMatrix();
     }
+    if (g_showProfiler) drawProfilerOverlay();
 
     glutSwapBuffers();
+    profiler().endFrame();
 }
 
 void idle() {
-    simulate();
+    // Fixed-step simulation driven by wall-clock time, independent of the display rate
+    static int tLast = glutGet(GLUT_ELAPSED_TIME);
+    int tNow = glutGet(GLUT_ELAPSED_TIME);
+    syncGpu();
+    if (g_useGpu) {
+        g_driver.advance((tNow - tLast) * 0.001f, []() {
+            // The GPU has the particle state: pins, impulses and teleports act on a fresh CPU copy
+            // that is sent back, settings alone only need setParams()
+            const bool edits = g_cloth.commands.pendingEdits();
+            if (edits) g_gpu.download(g_cloth);
+            g_cloth.applyCommands();
+            if (edits) {
+                g_cloth.wake(); // sleeping particles carry w = 0
+                g_gpu.upload(g_cloth); // kernels are built already, so this cannot fail
+            }
+            g_gpu.setParams(g_cloth.params);
+            g_gpu.step();
+        });
+    } else if (!g_sim.running()) {
+        g_driver.advance(g_cloth, (tNow - tLast) * 0.001f);
+    }
+    tLast = tNow;
     
     // Performance title update
     static int frame = 0;
@@ -293,8 +275,41 @@ void idle() {
     int t = glutGet(GLUT_ELAPSED_TIME);
     if (t - t0 > 200) {
         char buf[256];
-        sprintf(buf, "SCA 2012 LRA Demo | LRA: %s | Slack: %.2f | Iters: %d", 
-                g_useLRA ? "ON" : "OFF", g_lraSlack, g_iterations);
+        char iters[64], sleeping[48] = "", torn[32] = "";
+        // Stats of the simulation thread's last published step, else of the cloth itself. While
+        // the thread runs it writes the cloth, so only the frame may be read.
+        ClothInstance::SolveStats solve;
+        int particles, asleep, tiles, tornEdges, tethers;
+        if (g_sim.running()) {
+            const ClothFrame& frame = g_sim.latest();
+            solve = frame.solve;
+            particles = (int)frame.x.size();
+            asleep = frame.sleepingTiles;
+            tiles = frame.numTiles;
+            tornEdges = frame.tornEdges;
+            tethers = frame.tethersPerParticle;
+        } else {
+            solve = g_cloth.lastSolve;
+            particles = (int)g_cloth.P.size();
+            asleep = g_cloth.sleepingTiles();
+            tiles = g_cloth.numTiles();
+            tornEdges = g_cloth.tornEdges;
+            tethers = g_cloth.tethersPerParticle;
+        }
+        if (g_sleep && !g_useGpu) snprintf(sleeping, sizeof(sleeping), " | Asleep: %d/%d tiles", asleep, tiles);
+        if (g_tearStrain > 0.0f && !g_useGpu) snprintf(torn, sizeof(torn), " | Torn: %d", tornEdges);
+        if (g_iterationMode == ITERATIONS_ADAPTIVE && !g_useGpu) {
+            snprintf(iters, sizeof(iters), "adaptive %d/%d (RMS %.1f%%)", solve.iterations,
+                     g_maxIterations * g_substeps, solve.rmsError * 100.0f);
+        } else {
+            snprintf(iters, sizeof(iters), "%d x %d substeps", g_iterations, g_substeps);
+        }
+        char compliance[32] = "";
+        if (g_compliance > 0.0f) snprintf(compliance, sizeof(compliance), " | XPBD: %.0e m/N", g_compliance);
+        sprintf(buf, "SCA 2012 LRA Demo | %d particles | LRA: %s (%s) | Slack: %.2f | Iters: %s | K: %d | Solver: %s%s%s%s%s", 
+                particles, g_useLRA ? "ON" : "OFF", g_useGpu ? "GPU" : g_lraSimd ? lraSimdName() : "scalar",
+                g_lraSlack, iters, tethers, g_useGpu ? "GPU compute" : solverModeName(g_solverMode),
+                compliance, g_sim.running() ? " (own thread)" : "", sleeping, torn);
         glutSetWindowTitle(buf);
         t0 = t;
     }
@@ -308,7 +323,50 @@ void reshape(int w, int h) {
     gluPerspective(45.0, (double)w / h, 0.01, 100.0);
 }
 
+// Particle closest to the cursor in screen space (within 12 px), or -1
+int pickParticle(int x, int y) {
+    GLdouble model[16], proj[16];
+    GLint view[4];
+    glGetDoublev(GL_MODELVIEW_MATRIX, model);
+    glGetDoublev(GL_PROJECTION_MATRIX, proj);
+    glGetIntegerv(GL_VIEWPORT, view);
+
+    int best = -1;
+    double bestD2 = 12.0 * 12.0;
+    for (int i = 0; i < (int)g_cloth.P.size(); ++i) {
+        vec3 p = g_cloth.P.position(i);
+        GLdouble sx, sy, sz;
+        if (!gluProject(p.x, p.y, p.z, model, proj, view, &sx, &sy, &sz)) continue;
+        double dx = sx - x, dy = sy - (view[3] - y);
+        if (dx * dx + dy * dy < bestD2) {
+            bestD2 = dx * dx + dy * dy;
+            best = i;
+        }
+    }
+    return best;
+}
+
 void mouseButton(int button, int state, int x, int y) {
+    // Middle click pins / releases a particle without rebuilding the scene
+    if (button == GLUT_MIDDLE_BUTTON && state == GLUT_DOWN) {
+        g_sim.edit([x, y] {
+            if (g_useGpu) g_gpu.download(g_cloth); // pick and pin against current positions
+            int i = pickParticle(x, y);
+            if (i != -1 && g_recorder.recording()) {
+                // As a command, so the replay sees it: PIN / UNPIN take the build-order vertex
+                int v = 0;
+                while (g_cloth.particleOf(v) != i) ++v;
+                if (g_cloth.P.pinned[i]) g_cloth.commands.unpin(v);
+                else g_cloth.commands.pin(v);
+                printf("Particle %d: %s\n", i, g_cloth.P.pinned[i] ? "releasing" : "pinning");
+            } else if (i != -1) {
+                if (g_cloth.P.pinned[i]) g_cloth.removeAttachment(i);
+                else g_cloth.addAttachment(i);
+                printf("Particle %d: %s (%d attachments)\n", i, g_cloth.P.pinned[i] ? "pinned" : "released",
+                       (int)g_cloth.attachmentIndices.size());
+            }
+        });
+    }
     if (button == GLUT_LEFT_BUTTON)  lbtn = (state == GLUT_DOWN);
     if (button == GLUT_RIGHT_BUTTON) rbtn = (state == GLUT_DOWN);
     lastMouseX = x;
@@ -332,38 +390,199 @@ void mouseMotion(int x, int y) {
     }
 }
 
-void keyboard(unsigned char key, int, int) {
+// Solver settings: the UI globals hold what the title shows and are sent to the cloth as commands,
+// which the next step applies, so these need no edit() and never wait for the simulation thread.
+// Tether and compliance changes rebuild constraints on the stepping thread (the GPU path
+// downloads and re-uploads around them); frames carry the topology the renderer draws, and a
+// replay in progress records them.
+bool paramKey(unsigned char key) {
+    CommandQueue& q = g_cloth.commands;
     switch (key) {
+    case 't': case 'T':
+        g_lraTethers = (g_lraTethers >= 4) ? 1 : g_lraTethers * 2;
+        q.setTethers(g_lraTethers);
+        printf("Tethers per particle: %d\n", g_lraTethers);
+        break;
+    case 'e': case 'E': {
+        static const float kCompliance[] = {0.0f, 1e-6f, 1e-5f, 1e-4f};
+        int k = 0;
+        while (k < 4 && kCompliance[k] != g_compliance) ++k;
+        g_compliance = kCompliance[(k + 1) % 4];
+        q.setCompliance(g_compliance);
+        if (g_compliance > 0.0f) printf("Edge compliance: %.0e m/N (XPBD)\n", g_compliance);
+        else printf("Edge compliance: 0 (rigid)\n");
+        break;
+    }
     case 'l': case 'L':
         g_useLRA = !g_useLRA;
+        q.setParam(PARAM_USE_LRA, g_useLRA);
         printf("LRA: %s\n", g_useLRA ? "ON" : "OFF");
         break;
-    case 'r': case 'R':
-        buildScene();
+    case 'v': case 'V':
+        g_lraSimd = !g_lraSimd;
+        q.setParam(PARAM_LRA_SIMD, g_lraSimd);
+        printf("LRA kernel: %s\n", g_lraSimd ? lraSimdName() : "scalar");
+        break;
+    case 'p': case 'P':
+        g_solverMode = (g_solverMode + 1) % (SOLVER_JACOBI + 1);
+        q.setParam(PARAM_SOLVER_MODE, (float)g_solverMode);
+        printf("Solver: %s (%d threads)%s\n", solverModeName(g_solverMode), solverPool().size(), g_useGpu ? " (CPU only)" : "");
+        break;
+    case 's': case 'S':
+        g_substeps = (g_substeps >= 8) ? 1 : g_substeps * 2;
+        q.setParam(PARAM_SUBSTEPS, (float)g_substeps);
+        printf("Substeps: %d\n", g_substeps);
+        break;
+    case 'i': case 'I':
+        g_iterationMode = (g_iterationMode == ITERATIONS_ADAPTIVE) ? ITERATIONS_FIXED : ITERATIONS_ADAPTIVE;
+        q.setParam(PARAM_ITERATION_MODE, (float)g_iterationMode);
+        if (g_iterationMode == ITERATIONS_ADAPTIVE) {
+            printf("Iterations: adaptive, RMS edge error < %.1f%%, at most %d per substep%s\n",
+                   g_iterationTolerance * 100.0f, g_maxIterations, g_useGpu ? " (CPU only)" : "");
+        } else {
+            printf("Iterations: fixed %d\n", g_iterations);
+        }
+        break;
+    case 'z': case 'Z':
+        g_sleep = !g_sleep;
+        q.setParam(PARAM_SLEEP, g_sleep);
+        printf("Sleeping: %s (below %.0f mm/s for %d steps)\n", g_sleep ? "ON" : "OFF", g_sleepVelocity * 1000.0f, g_sleepSteps);
+        break;
+    case 'd': case 'D':
+        g_tearStrain = (g_tearStrain == 0.0f) ? 0.5f : (g_tearStrain == 0.5f) ? 0.25f : 0.0f;
+        q.setParam(PARAM_TEAR_STRAIN, g_tearStrain);
+        if (g_tearStrain > 0.0f) printf("Tearing: edges past %.0f%% stretch%s\n", g_tearStrain * 100.0f, g_useGpu ? " (CPU only)" : "");
+        else printf("Tearing: OFF\n");
         break;
     case ']': 
         g_lraSlack += 0.05f; 
+        q.setParam(PARAM_LRA_SLACK, g_lraSlack);
         printf("Slack: %.2f\n", g_lraSlack);
         break;
     case '[': 
         g_lraSlack = std::max(1.0f, g_lraSlack - 0.05f); 
+        q.setParam(PARAM_LRA_SLACK, g_lraSlack);
         printf("Slack: %.2f\n", g_lraSlack);
         break;
-    case '1': g_iterations = 1; break;
-    case '2': g_iterations = 2; break;
-    case '3': g_iterations = 5; break;
-    case '4': g_iterations = 10; break;
-    case 27: exit(0); break;
+    case '1': case '2': case '3': case '4': {
+        static const int kIterations[] = {1, 2, 5, 10};
+        g_iterations = kIterations[key - '1'];
+        q.setParam(PARAM_ITERATIONS, (float)g_iterations);
+        break;
+    }
+    default:
+        return false;
+    }
+    return true;
+}
+
+// Keys that change the cloth itself; run inside g_sim.edit()
+void editKey(unsigned char key) {
+    switch (key) {
+    case 'a': case 'A':
+        g_animate = !g_animate;
+        if (g_useGpu) g_gpu.download(g_cloth); // bind pose = current pin positions
+        g_animTime = 0.0f;
+        bindAnchors();
+        printf("Animated attachments: %s\n", g_animate ? "ON" : "OFF");
+        break;
+    case 'k': case 'K':
+        g_collide = !g_collide;
+        placeBody();
+        g_cloth.wake();
+        printf("Collisions: %s (sphere body + self, %.0f mm thickness)%s\n", g_collide ? "ON" : "OFF",
+               g_collisionThickness * 1000.0f, g_useGpu ? " (CPU only)" : "");
+        break;
+    case 'w': case 'W':
+        g_wind = !g_wind;
+        g_cloth.wind.velocity = vec3(0.0f, 0.0f, g_wind ? 4.0f : 0.0f);
+        g_cloth.wind.turbulence = g_wind ? 1.5f : 0.0f;
+        g_cloth.wake();
+        printf("Wind: %s%s\n", g_wind ? "ON (4 m/s, 1.5 m/s gusts)" : "OFF", g_useGpu ? " (CPU only)" : "");
+        break;
+    case 'm': case 'M':
+        g_renderer.shaded = !g_renderer.shaded;
+        printf("Render: %s\n", g_renderer.shaded ? "shaded mesh" : "wireframe");
+        break;
+    case 'o': case 'O':
+        g_showProfiler = !g_showProfiler;
+        break;
+    case 'c': case 'C':
+        if (!profiler().tracing()) {
+            profiler().beginTrace();
+            printf("Trace capture started\n");
+        } else if (profiler().endTrace(kTracePath)) {
+            printf("Trace written to %s\n", kTracePath);
+        }
+        break;
+    case 'r': case 'R':
+        resetCloth();
+        break;
+    case 'x': case 'X':
+        if (g_recorder.recording()) {
+            stopRecording();
+        } else if (g_useGpu || g_asset.isOpen() || !g_mesh.positions.empty()) {
+            printf("Replay: CPU backend and buildScene() cloths only\n");
+        } else {
+            resetCloth(); // replays start from a rebuild
+            if (g_recorder.begin(g_cloth, kReplayPath)) printf("Replay recording to %s\n", kReplayPath);
+            else printf("Replay: could not write %s\n", kReplayPath);
+        }
+        break;
+    }
+}
+
+void keyboard(unsigned char key, int, int) {
+    switch (key) {
+    // These start / stop the simulation thread, so they cannot run inside an edit
+    case 'g': case 'G':
+        setGpu(!g_useGpu);
+        break;
+    case 'y': case 'Y':
+        if (g_useGpu) break;
+        if (g_sim.running()) {
+            g_sim.stop();
+            g_driver.reset(g_cloth);
+        } else {
+            g_sim.start(g_cloth);
+        }
+        printf("Simulation thread: %s\n", g_sim.running() ? "ON" : "OFF (steps in idle)");
+        break;
+    case 27:
+        g_sim.stop();
+        stopRecording();
+        exit(0);
+        break;
+    default:
+        if (!paramKey(key)) g_sim.edit([key] { editKey(key); });
+        break;
     }
 }
 
 void usage() {
     printf("=== SCA 2012 Long Range Attachments Demo ===\n");
     printf("L       : Toggle LRA ON/OFF (Observe stretching without it!)\n");
+    printf("V       : Toggle vectorized LRA kernel (%s)\n", lraSimdName());
+    printf("P       : Cycle Gauss-Seidel / colored parallel / Jacobi solver\n");
+    printf("E       : Cycle edge compliance 0 / 1e-6 / 1e-5 / 1e-4 m/N (XPBD stretch)\n");
     printf("R       : Reset Simulation\n");
     printf("[ / ]   : Decrease / Increase LRA Slack (Current: %.2f)\n", g_lraSlack);
     printf("1..4    : Set Iterations (Current: %d)\n", g_iterations);
-    printf("Mouse   : Rotate (Left), Pan (Right)\n");
+    printf("I       : Toggle fixed / adaptive iterations (stop at %.1f%% RMS edge error)\n", g_iterationTolerance * 100.0f);
+    printf("S       : Cycle substeps per step 1/2/4/8 (Current: %d)\n", g_substeps);
+    printf("T       : Cycle tethers per particle 1/2/4 (Current: %d)\n", g_lraTethers);
+    printf("A       : Toggle animated (skinned) attachments\n");
+    printf("K       : Toggle sphere body collider and self-collision\n");
+    printf("W       : Toggle gusty wind (per-triangle drag and lift)\n");
+    printf("Z       : Toggle sleeping of settled %d-particle tiles\n", kSleepTile);
+    printf("D       : Cycle tearing off / edges past 50%% / 25%% stretch (R mends the cloth)\n");
+    printf("G       : Toggle CPU / GPU compute backend\n");
+    printf("Y       : Toggle CPU simulation on its own thread / in the GLUT idle callback\n");
+    printf("M       : Toggle wireframe / shaded mesh\n");
+    printf("O       : Toggle profiler overlay\n");
+    printf("C       : Start / stop Chrome trace capture (%s)\n", kTracePath);
+    printf("X       : Start (resets the cloth) / stop replay recording (%s, see lra-replay)\n", kReplayPath);
+    printf("Mouse   : Rotate (Left), Pan (Right), Pin / Release particle (Middle)\n");
 }
 
 int main(int argc, char** argv) {
@@ -371,11 +590,39 @@ int main(int argc, char** argv) {
     glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB | GLUT_DEPTH);
     glutInitWindowSize(800, 600);
     glutCreateWindow("SCA 2012 LRA Cloth");
+    profiler().enabled = true; // phase overlay and the trace key
+
+    // --size N: N x N particles (e.g. 320 for 100k); --asset FILE: baked cloth (lra-bake);
+    // --mesh FILE: OBJ / glTF cloth pinned by its pin groups; --gpu: start on the compute backend
+    bool startGpu = false;
+    for (int a = 1; a < argc; ++a) {
+        if (!strcmp(argv[a], "--size") && a + 1 < argc) g_clothSize = std::max(2, atoi(argv[++a]));
+        else if (!strcmp(argv[a], "--asset") && a + 1 < argc) g_asset.open(argv[++a]);
+        else if (!strcmp(argv[a], "--mesh") && a + 1 < argc) { if (!loadClothMesh(argv[++a], g_mesh)) g_mesh.clear(); }
+        else if (!strcmp(argv[a], "--gpu")) startGpu = true;
+    }
 
+    loadGLExtensions();
     glEnable(GL_DEPTH_TEST);
     glClearColor(0.2f, 0.2f, 0.2f, 1.0f);
 
-    buildScene();
+    resetCloth();
+    if (g_cloth.gridW > 0) {
+        g_clothSize = std::max(g_cloth.gridW, g_cloth.gridH);
+    } else if (!g_cloth.P.empty()) {
+        // Grid cloth of the same extent, for the camera and the collision body
+        vec3 lo = g_cloth.P.position(0), hi = lo;
+        for (int i = 1; i < (int)g_cloth.P.size(); ++i) {
+            lo = glm::min(lo, g_cloth.P.position(i));
+            hi = glm::max(hi, g_cloth.P.position(i));
+        }
+        g_clothSize = 1 + (int)(std::max(hi.x - lo.x, hi.y - lo.y) / spacing);
+    }
+    camDist *= std::max(1.0f, g_clothSize / (float)clothW);
+    g_driver.onStep = animateAnchors;
+    g_sim.onStep = animateAnchors;
+    if (startGpu) setGpu(true);
+    if (!g_useGpu) g_sim.start(g_cloth);
     usage();
 
     glutDisplayFunc(display);
@@ -0,0 +1,344 @@
+// lra_simd.cpp - Vectorized LRA projection kernel
+// Positions are gathered from the SoA store, the unilateral test (currentDist > limit) becomes
+// a lane mask, and the projected position is blended in only where the mask is set.
+
+#include "lra_simd.h"
+
+#include <cmath>
+
+#if defined(LRA_SIMD_AVX2)
+#include <immintrin.h>
+#elif defined(LRA_SIMD_SSE2)
+#include <emmintrin.h>
+#elif defined(LRA_SIMD_NEON)
+#include <arm_neon.h>
+#endif
+
+static_assert(sizeof(LRAConstraint) == 3 * sizeof(int), "LRAConstraint is gathered as 3 packed 32-bit fields");
+
+// Scalar reference, identical to projectLRA() in simulation.cpp (used for the tail)
+static inline void projectOne(float* X, float* Y, float* Z, const LRAConstraint& c, float slack) {
+    const int i = c.particleIdx;
+    const int a = c.attachmentIdx;
+    float dx = X[i] - X[a];
+    float dy = Y[i] - Y[a];
+    float dz = Z[i] - Z[a];
+    float currentDist = std::sqrt(dx * dx + dy * dy + dz * dz);
+    float limit = c.maxDist * slack;
+    if (currentDist > limit) {
+        if (currentDist < 1e-6f) return;
+        float s = limit / currentDist;
+        X[i] = X[a] + dx * s;
+        Y[i] = Y[a] + dy * s;
+        Z[i] = Z[a] + dz * s;
+    }
+}
+
+const char* lraSimdName() {
+#if defined(LRA_SIMD_AVX2)
+    return "AVX2";
+#elif defined(LRA_SIMD_SSE2)
+    return "SSE2";
+#elif defined(LRA_SIMD_NEON)
+    return "NEON";
+#else
+    return "scalar";
+#endif
+}
+
+void projectLRASimd(ParticleStore& ps, const LRAConstraint* c, int count, float slack) {
+    float* X = ps.x.data();
+    float* Y = ps.y.data();
+    float* Z = ps.z.data();
+    int k = 0;
+
+#if defined(LRA_SIMD_AVX2)
+    const int* base = reinterpret_cast<const int*>(c);
+    const __m256i stride = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+    const __m256 vSlack = _mm256_set1_ps(slack);
+    const __m256 vEps = _mm256_set1_ps(1e-6f);
+    alignas(32) int   outIdx[8];
+    alignas(32) float outX[8], outY[8], outZ[8];
+
+    for (; k + 8 <= count; k += 8) {
+        const int* b = base + 3 * k;
+        __m256i pi = _mm256_i32gather_epi32(b, stride, 4);
+        __m256i ai = _mm256_i32gather_epi32(b + 1, stride, 4);
+        __m256 maxDist = _mm256_i32gather_ps(reinterpret_cast<const float*>(b + 2), stride, 4);
+
+        __m256 px = _mm256_i32gather_ps(X, pi, 4);
+        __m256 py = _mm256_i32gather_ps(Y, pi, 4);
+        __m256 pz = _mm256_i32gather_ps(Z, pi, 4);
+        __m256 ax = _mm256_i32gather_ps(X, ai, 4);
+        __m256 ay = _mm256_i32gather_ps(Y, ai, 4);
+        __m256 az = _mm256_i32gather_ps(Z, ai, 4);
+
+        __m256 dx = _mm256_sub_ps(px, ax);
+        __m256 dy = _mm256_sub_ps(py, ay);
+        __m256 dz = _mm256_sub_ps(pz, az);
+        __m256 d2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+        __m256 dist = _mm256_sqrt_ps(d2);
+        __m256 limit = _mm256_mul_ps(maxDist, vSlack);
+
+        // Unilateral: only lanes stretched beyond the limit (and not degenerate) move
+        __m256 mask = _mm256_and_ps(_mm256_cmp_ps(dist, limit, _CMP_GT_OQ), _mm256_cmp_ps(dist, vEps, _CMP_GE_OQ));
+        if (_mm256_movemask_ps(mask) == 0) continue;
+        __m256 s = _mm256_div_ps(limit, dist);
+
+        _mm256_store_si256(reinterpret_cast<__m256i*>(outIdx), pi);
+        _mm256_store_ps(outX, _mm256_blendv_ps(px, _mm256_add_ps(ax, _mm256_mul_ps(dx, s)), mask));
+        _mm256_store_ps(outY, _mm256_blendv_ps(py, _mm256_add_ps(ay, _mm256_mul_ps(dy, s)), mask));
+        _mm256_store_ps(outZ, _mm256_blendv_ps(pz, _mm256_add_ps(az, _mm256_mul_ps(dz, s)), mask));
+
+        for (int l = 0; l < 8; ++l) {
+            X[outIdx[l]] = outX[l];
+            Y[outIdx[l]] = outY[l];
+            Z[outIdx[l]] = outZ[l];
+        }
+    }
+#elif defined(LRA_SIMD_SSE2)
+    const __m128 vSlack = _mm_set1_ps(slack);
+    const __m128 vEps = _mm_set1_ps(1e-6f);
+    alignas(16) float outX[4], outY[4], outZ[4];
+
+    for (; k + 4 <= count; k += 4) {
+        const LRAConstraint* b = c + k;
+        const int i0 = b[0].particleIdx, i1 = b[1].particleIdx, i2 = b[2].particleIdx, i3 = b[3].particleIdx;
+        const int a0 = b[0].attachmentIdx, a1 = b[1].attachmentIdx, a2 = b[2].attachmentIdx, a3 = b[3].attachmentIdx;
+
+        __m128 px = _mm_setr_ps(X[i0], X[i1], X[i2], X[i3]);
+        __m128 py = _mm_setr_ps(Y[i0], Y[i1], Y[i2], Y[i3]);
+        __m128 pz = _mm_setr_ps(Z[i0], Z[i1], Z[i2], Z[i3]);
+        __m128 ax = _mm_setr_ps(X[a0], X[a1], X[a2], X[a3]);
+        __m128 ay = _mm_setr_ps(Y[a0], Y[a1], Y[a2], Y[a3]);
+        __m128 az = _mm_setr_ps(Z[a0], Z[a1], Z[a2], Z[a3]);
+        __m128 maxDist = _mm_setr_ps(b[0].maxDist, b[1].maxDist, b[2].maxDist, b[3].maxDist);
+
+        __m128 dx = _mm_sub_ps(px, ax);
+        __m128 dy = _mm_sub_ps(py, ay);
+        __m128 dz = _mm_sub_ps(pz, az);
+        __m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+        __m128 dist = _mm_sqrt_ps(d2);
+        __m128 limit = _mm_mul_ps(maxDist, vSlack);
+
+        __m128 mask = _mm_and_ps(_mm_cmpgt_ps(dist, limit), _mm_cmpge_ps(dist, vEps));
+        if (_mm_movemask_ps(mask) == 0) continue;
+        __m128 s = _mm_div_ps(limit, dist);
+
+        // SSE2 has no blendv: (mask & new) | (~mask & old)
+        __m128 nx = _mm_add_ps(ax, _mm_mul_ps(dx, s));
+        __m128 ny = _mm_add_ps(ay, _mm_mul_ps(dy, s));
+        __m128 nz = _mm_add_ps(az, _mm_mul_ps(dz, s));
+        _mm_store_ps(outX, _mm_or_ps(_mm_and_ps(mask, nx), _mm_andnot_ps(mask, px)));
+        _mm_store_ps(outY, _mm_or_ps(_mm_and_ps(mask, ny), _mm_andnot_ps(mask, py)));
+        _mm_store_ps(outZ, _mm_or_ps(_mm_and_ps(mask, nz), _mm_andnot_ps(mask, pz)));
+
+        X[i0] = outX[0]; Y[i0] = outY[0]; Z[i0] = outZ[0];
+        X[i1] = outX[1]; Y[i1] = outY[1]; Z[i1] = outZ[1];
+        X[i2] = outX[2]; Y[i2] = outY[2]; Z[i2] = outZ[2];
+        X[i3] = outX[3]; Y[i3] = outY[3]; Z[i3] = outZ[3];
+    }
+#elif defined(LRA_SIMD_NEON)
+    const float32x4_t vSlack = vdupq_n_f32(slack);
+    const float32x4_t vEps = vdupq_n_f32(1e-6f);
+    alignas(16) int   outIdx[4], inIdx[4];
+    alignas(16) float outX[4], outY[4], outZ[4];
+
+    for (; k + 4 <= count; k += 4) {
+        // De-interleave 4 packed {particleIdx, attachmentIdx, maxDist} records in one load
+        int32x4x3_t rec = vld3q_s32(reinterpret_cast<const int32_t*>(c + k));
+        vst1q_s32(outIdx, rec.val[0]);
+        vst1q_s32(inIdx, rec.val[1]);
+        float32x4_t maxDist = vreinterpretq_f32_s32(rec.val[2]);
+
+        float px_[4], py_[4], pz_[4], ax_[4], ay_[4], az_[4];
+        for (int l = 0; l < 4; ++l) {
+            px_[l] = X[outIdx[l]]; py_[l] = Y[outIdx[l]]; pz_[l] = Z[outIdx[l]];
+            ax_[l] = X[inIdx[l]];  ay_[l] = Y[inIdx[l]];  az_[l] = Z[inIdx[l]];
+        }
+        float32x4_t px = vld1q_f32(px_), py = vld1q_f32(py_), pz = vld1q_f32(pz_);
+        float32x4_t ax = vld1q_f32(ax_), ay = vld1q_f32(ay_), az = vld1q_f32(az_);
+
+        float32x4_t dx = vsubq_f32(px, ax);
+        float32x4_t dy = vsubq_f32(py, ay);
+        float32x4_t dz = vsubq_f32(pz, az);
+        float32x4_t d2 = vaddq_f32(vaddq_f32(vmulq_f32(dx, dx), vmulq_f32(dy, dy)), vmulq_f32(dz, dz));
+        float32x4_t dist = vsqrtq_f32(d2);
+        float32x4_t limit = vmulq_f32(maxDist, vSlack);
+
+        uint32x4_t mask = vandq_u32(vcgtq_f32(dist, limit), vcgeq_f32(dist, vEps));
+        if (vmaxvq_u32(mask) == 0) continue;
+        float32x4_t s = vdivq_f32(limit, dist);
+
+        vst1q_f32(outX, vbslq_f32(mask, vaddq_f32(ax, vmulq_f32(dx, s)), px));
+        vst1q_f32(outY, vbslq_f32(mask, vaddq_f32(ay, vmulq_f32(dy, s)), py));
+        vst1q_f32(outZ, vbslq_f32(mask, vaddq_f32(az, vmulq_f32(dz, s)), pz));
+        for (int l = 0; l < 4; ++l) {
+            X[outIdx[l]] = outX[l];
+            Y[outIdx[l]] = outY[l];
+            Z[outIdx[l]] = outZ[l];
+        }
+    }
+#endif
+
+    for (; k < count; ++k) {
+        projectOne(X, Y, Z, c[k], slack);
+    }
+}
+
+void projectLRATethersSimd(ParticleStore& ps, const LRAConstraint* c, int numParticles, int K, float slack) {
+    float* X = ps.x.data();
+    float* Y = ps.y.data();
+    float* Z = ps.z.data();
+    int m = 0;
+
+#if defined(LRA_SIMD_AVX2)
+    const int* base = reinterpret_cast<const int*>(c);
+    const __m256i stride = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(3 * K));
+    const __m256 vSlack = _mm256_set1_ps(slack);
+    const __m256 vEps = _mm256_set1_ps(1e-6f);
+    alignas(32) int   outIdx[8];
+    alignas(32) float outX[8], outY[8], outZ[8];
+
+    for (; m + 8 <= numParticles; m += 8) {
+        const int* b = base + 3 * K * m;
+        __m256i pi = _mm256_i32gather_epi32(b, stride, 4);
+        __m256 px = _mm256_i32gather_ps(X, pi, 4);
+        __m256 py = _mm256_i32gather_ps(Y, pi, 4);
+        __m256 pz = _mm256_i32gather_ps(Z, pi, 4);
+
+        for (int k = 0; k < K; ++k, b += 3) {
+            __m256i ai = _mm256_i32gather_epi32(b + 1, stride, 4);
+            __m256 maxDist = _mm256_i32gather_ps(reinterpret_cast<const float*>(b + 2), stride, 4);
+            __m256 ax = _mm256_i32gather_ps(X, ai, 4);
+            __m256 ay = _mm256_i32gather_ps(Y, ai, 4);
+            __m256 az = _mm256_i32gather_ps(Z, ai, 4);
+
+            __m256 dx = _mm256_sub_ps(px, ax);
+            __m256 dy = _mm256_sub_ps(py, ay);
+            __m256 dz = _mm256_sub_ps(pz, az);
+            __m256 d2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+            __m256 dist = _mm256_sqrt_ps(d2);
+            __m256 limit = _mm256_mul_ps(maxDist, vSlack);
+            __m256 mask = _mm256_and_ps(_mm256_cmp_ps(dist, limit, _CMP_GT_OQ), _mm256_cmp_ps(dist, vEps, _CMP_GE_OQ));
+            if (_mm256_movemask_ps(mask) == 0) continue;
+            __m256 s = _mm256_div_ps(limit, dist);
+
+            px = _mm256_blendv_ps(px, _mm256_add_ps(ax, _mm256_mul_ps(dx, s)), mask);
+            py = _mm256_blendv_ps(py, _mm256_add_ps(ay, _mm256_mul_ps(dy, s)), mask);
+            pz = _mm256_blendv_ps(pz, _mm256_add_ps(az, _mm256_mul_ps(dz, s)), mask);
+        }
+
+        _mm256_store_si256(reinterpret_cast<__m256i*>(outIdx), pi);
+        _mm256_store_ps(outX, px);
+        _mm256_store_ps(outY, py);
+        _mm256_store_ps(outZ, pz);
+        for (int l = 0; l < 8; ++l) {
+            X[outIdx[l]] = outX[l];
+            Y[outIdx[l]] = outY[l];
+            Z[outIdx[l]] = outZ[l];
+        }
+    }
+#elif defined(LRA_SIMD_SSE2)
+    const __m128 vSlack = _mm_set1_ps(slack);
+    const __m128 vEps = _mm_set1_ps(1e-6f);
+    alignas(16) float outX[4], outY[4], outZ[4];
+
+    for (; m + 4 <= numParticles; m += 4) {
+        const LRAConstraint* b0 = c + K * m;
+        const LRAConstraint* b1 = b0 + K;
+        const LRAConstraint* b2 = b1 + K;
+        const LRAConstraint* b3 = b2 + K;
+        const int i0 = b0->particleIdx, i1 = b1->particleIdx, i2 = b2->particleIdx, i3 = b3->particleIdx;
+        __m128 px = _mm_setr_ps(X[i0], X[i1], X[i2], X[i3]);
+        __m128 py = _mm_setr_ps(Y[i0], Y[i1], Y[i2], Y[i3]);
+        __m128 pz = _mm_setr_ps(Z[i0], Z[i1], Z[i2], Z[i3]);
+
+        for (int k = 0; k < K; ++k) {
+            const int a0 = b0[k].attachmentIdx, a1 = b1[k].attachmentIdx, a2 = b2[k].attachmentIdx, a3 = b3[k].attachmentIdx;
+            __m128 ax = _mm_setr_ps(X[a0], X[a1], X[a2], X[a3]);
+            __m128 ay = _mm_setr_ps(Y[a0], Y[a1], Y[a2], Y[a3]);
+            __m128 az = _mm_setr_ps(Z[a0], Z[a1], Z[a2], Z[a3]);
+            __m128 maxDist = _mm_setr_ps(b0[k].maxDist, b1[k].maxDist, b2[k].maxDist, b3[k].maxDist);
+
+            __m128 dx = _mm_sub_ps(px, ax);
+            __m128 dy = _mm_sub_ps(py, ay);
+            __m128 dz = _mm_sub_ps(pz, az);
+            __m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+            __m128 dist = _mm_sqrt_ps(d2);
+            __m128 limit = _mm_mul_ps(maxDist, vSlack);
+            __m128 mask = _mm_and_ps(_mm_cmpgt_ps(dist, limit), _mm_cmpge_ps(dist, vEps));
+            if (_mm_movemask_ps(mask) == 0) continue;
+            __m128 s = _mm_div_ps(limit, dist);
+
+            __m128 nx = _mm_add_ps(ax, _mm_mul_ps(dx, s));
+            __m128 ny = _mm_add_ps(ay, _mm_mul_ps(dy, s));
+            __m128 nz = _mm_add_ps(az, _mm_mul_ps(dz, s));
+            px = _mm_or_ps(_mm_and_ps(mask, nx), _mm_andnot_ps(mask, px));
+            py = _mm_or_ps(_mm_and_ps(mask, ny), _mm_andnot_ps(mask, py));
+            pz = _mm_or_ps(_mm_and_ps(mask, nz), _mm_andnot_ps(mask, pz));
+        }
+
+        _mm_store_ps(outX, px);
+        _mm_store_ps(outY, py);
+        _mm_store_ps(outZ, pz);
+        X[i0] = outX[0]; Y[i0] = outY[0]; Z[i0] = outZ[0];
+        X[i1] = outX[1]; Y[i1] = outY[1]; Z[i1] = outZ[1];
+        X[i2] = outX[2]; Y[i2] = outY[2]; Z[i2] = outZ[2];
+        X[i3] = outX[3]; Y[i3] = outY[3]; Z[i3] = outZ[3];
+    }
+#elif defined(LRA_SIMD_NEON)
+    const float32x4_t vSlack = vdupq_n_f32(slack);
+    const float32x4_t vEps = vdupq_n_f32(1e-6f);
+    alignas(16) float outX[4], outY[4], outZ[4];
+
+    for (; m + 4 <= numParticles; m += 4) {
+        const LRAConstraint* b[4] = {c + K * m, c + K * (m + 1), c + K * (m + 2), c + K * (m + 3)};
+        float in_[4];
+        for (int l = 0; l < 4; ++l) in_[l] = X[b[l]->particleIdx];
+        float32x4_t px = vld1q_f32(in_);
+        for (int l = 0; l < 4; ++l) in_[l] = Y[b[l]->particleIdx];
+        float32x4_t py = vld1q_f32(in_);
+        for (int l = 0; l < 4; ++l) in_[l] = Z[b[l]->particleIdx];
+        float32x4_t pz = vld1q_f32(in_);
+
+        for (int k = 0; k < K; ++k) {
+            float ax_[4], ay_[4], az_[4], md_[4];
+            for (int l = 0; l < 4; ++l) {
+                const int a = b[l][k].attachmentIdx;
+                ax_[l] = X[a]; ay_[l] = Y[a]; az_[l] = Z[a];
+                md_[l] = b[l][k].maxDist;
+            }
+            float32x4_t ax = vld1q_f32(ax_), ay = vld1q_f32(ay_), az = vld1q_f32(az_);
+
+            float32x4_t dx = vsubq_f32(px, ax);
+            float32x4_t dy = vsubq_f32(py, ay);
+            float32x4_t dz = vsubq_f32(pz, az);
+            float32x4_t d2 = vaddq_f32(vaddq_f32(vmulq_f32(dx, dx), vmulq_f32(dy, dy)), vmulq_f32(dz, dz));
+            float32x4_t dist = vsqrtq_f32(d2);
+            float32x4_t limit = vmulq_f32(vld1q_f32(md_), vSlack);
+            uint32x4_t mask = vandq_u32(vcgtq_f32(dist, limit), vcgeq_f32(dist, vEps));
+            if (vmaxvq_u32(mask) == 0) continue;
+            float32x4_t s = vdivq_f32(limit, dist);
+
+            px = vbslq_f32(mask, vaddq_f32(ax, vmulq_f32(dx, s)), px);
+            py = vbslq_f32(mask, vaddq_f32(ay, vmulq_f32(dy, s)), py);
+            pz = vbslq_f32(mask, vaddq_f32(az, vmulq_f32(dz, s)), pz);
+        }
+
+        vst1q_f32(outX, px);
+        vst1q_f32(outY, py);
+        vst1q_f32(outZ, pz);
+        for (int l = 0; l < 4; ++l) {
+            const int i = b[l]->particleIdx;
+            X[i] = outX[l];
+            Y[i] = outY[l];
+            Z[i] = outZ[l];
+        }
+    }
+#endif
+
+    for (; m < numParticles; ++m) {
+        for (int k = 0; k < K; ++k) projectOne(X, Y, Z, c[m * K + k], slack);
+    }
+}
@@ -0,0 +1,33 @@
+// lra_simd.h - Vectorized LRA projection kernel (SSE2 / AVX2 / NEON)
+// The instruction set is picked at compile time; the scalar path is always available.
+
+#pragma once
+
+#include "cloth_types.h"
+
+#if defined(__AVX2__)
+#define LRA_SIMD_AVX2 1
+#define LRA_SIMD_WIDTH 8
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LRA_SIMD_SSE2 1
+#define LRA_SIMD_WIDTH 4
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#define LRA_SIMD_NEON 1
+#define LRA_SIMD_WIDTH 4
+#else
+#define LRA_SIMD_WIDTH 1
+#endif
+
+// Name of the compiled-in instruction set ("AVX2", "SSE2", "NEON" or "scalar")
+const char* lraSimdName();
+
+// Project `count` LRA constraints with the given slack, LRA_SIMD_WIDTH constraints per instruction.
+// Each constraint writes only its own particleIdx and reads a pinned anchor, so lanes never conflict
+// as long as a particle appears at most once in the range.
+void projectLRASimd(ParticleStore& ps, const LRAConstraint* c, int count, float slack);
+
+// K tethers per particle: `c` holds numParticles * K records, particle m's tethers at [m * K, m * K + K).
+// Lanes run over particles; each lane applies its K tethers in order with the position kept in
+// registers, matching K sequential projectLRA() calls. Pad short tether lists by repeating a
+// tether (projecting it twice is a no-op).
+void projectLRATethersSimd(ParticleStore& ps, const LRAConstraint* c, int numParticles, int K, float slack);
@@ -0,0 +1,593 @@
+// mesh_import.cpp - Cloth meshes from OBJ and glTF files
+
+#include "mesh_import.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <tuple>
+#include <utility>
+
+void ClothMesh::clear() {
+    positions.clear();
+    triangles.clear();
+    pinGroup.clear();
+    pinGroupNames.clear();
+    pinned.clear();
+}
+
+static bool hasExtension(const char* path, const char* ext) {
+    const size_t n = strlen(path), m = strlen(ext);
+    if (n < m) return false;
+    for (size_t k = 0; k < m; ++k) {
+        char c = path[n - m + k];
+        if (c >= 'A' && c <= 'Z') c = (char)(c - 'A' + 'a');
+        if (c != ext[k]) return false;
+    }
+    return true;
+}
+
+bool loadClothMesh(const char* path, ClothMesh& mesh, const MeshImportOptions& opt) {
+    if (hasExtension(path, ".obj")) return loadClothMeshOBJ(path, mesh, opt);
+    if (hasExtension(path, ".gltf") || hasExtension(path, ".glb")) return loadClothMeshGLTF(path, mesh, opt);
+    printf("%s: unknown mesh format (expected .obj, .gltf or .glb)\n", path);
+    return false;
+}
+
+// ---------------------------------------------------------
+// Common post-processing
+// ---------------------------------------------------------
+
+// Weld, drop triangles that collapsed, and list the vertices of the selected pin groups
+static bool finishMesh(const char* path, ClothMesh& mesh, const MeshImportOptions& opt) {
+    const int n = (int)mesh.positions.size();
+    for (int v : mesh.triangles) {
+        if (v < 0 || v >= n) {
+            printf("%s: vertex index %d out of range (%d vertices)\n", path, v, n);
+            return false;
+        }
+    }
+
+    if (opt.weld && n > 0) {
+        // Sort by position; each run of equal positions keeps its lowest original index, and the
+        // survivors are renumbered in file order so vertex ids stay predictable
+        std::vector<int> order(n), rep(n), newOf(n);
+        for (int i = 0; i < n; ++i) order[i] = i;
+        const std::vector<vec3>& pos = mesh.positions;
+        std::sort(order.begin(), order.end(), [&pos](int a, int b) {
+            return std::tie(pos[a].x, pos[a].y, pos[a].z, a) < std::tie(pos[b].x, pos[b].y, pos[b].z, b);
+        });
+        for (int k = 0; k < n; ++k) {
+            rep[order[k]] = (k > 0 && pos[order[k]] == pos[order[k - 1]]) ? rep[order[k - 1]] : order[k];
+        }
+        int m = 0;
+        for (int i = 0; i < n; ++i) {
+            if (rep[i] == i) {
+                newOf[i] = m;
+                mesh.positions[m] = mesh.positions[i];
+                mesh.pinGroup[m] = mesh.pinGroup[i];
+                ++m;
+            } else {
+                int& g = mesh.pinGroup[newOf[rep[i]]];
+                if (g == 0) g = mesh.pinGroup[i]; // a pinned copy pins the welded vertex
+                newOf[i] = newOf[rep[i]];
+            }
+        }
+        mesh.positions.resize(m);
+        mesh.pinGroup.resize(m);
+        for (int& v : mesh.triangles) v = newOf[v];
+    }
+
+    size_t kept = 0;
+    for (size_t t = 0; t + 2 < mesh.triangles.size(); t += 3) {
+        const int a = mesh.triangles[t], b = mesh.triangles[t + 1], c = mesh.triangles[t + 2];
+        if (a == b || b == c || a == c) continue;
+        mesh.triangles[kept++] = a;
+        mesh.triangles[kept++] = b;
+        mesh.triangles[kept++] = c;
+    }
+    mesh.triangles.resize(kept);
+    if (mesh.triangles.empty()) {
+        printf("%s: no triangles\n", path);
+        return false;
+    }
+
+    std::vector<unsigned char> selected(mesh.pinGroupNames.size() + 1, 0);
+    for (size_t g = 0; g < mesh.pinGroupNames.size(); ++g) {
+        selected[g + 1] = opt.pinGroups.empty() ||
+                          std::find(opt.pinGroups.begin(), opt.pinGroups.end(), mesh.pinGroupNames[g]) != opt.pinGroups.end();
+    }
+    mesh.pinned.clear();
+    for (int i = 0; i < (int)mesh.pinGroup.size(); ++i) {
+        const int g = mesh.pinGroup[i];
+        if (g > 0 && g < (int)selected.size() && selected[g]) mesh.pinned.push_back(i);
+    }
+    return true;
+}
+
+static int pinGroupId(ClothMesh& mesh, const std::string& name) {
+    auto it = std::find(mesh.pinGroupNames.begin(), mesh.pinGroupNames.end(), name);
+    if (it != mesh.pinGroupNames.end()) return (int)(it - mesh.pinGroupNames.begin()) + 1;
+    mesh.pinGroupNames.push_back(name);
+    return (int)mesh.pinGroupNames.size();
+}
+
+// ---------------------------------------------------------
+// OBJ
+// ---------------------------------------------------------
+
+// Next line without its terminator, of any length; false at end of file
+static bool readLine(FILE* f, std::string& line) {
+    line.clear();
+    char buf[4096];
+    while (fgets(buf, sizeof(buf), f)) {
+        line += buf;
+        if (line.back() == '\n') break;
+    }
+    if (line.empty()) return false;
+    while (!line.empty() && (line.back() == '\n' || line.back() == '\r')) line.pop_back();
+    return true;
+}
+
+static const char* skipSpace(const char* s) {
+    while (*s == ' ' || *s == '\t') ++s;
+    return s;
+}
+
+// Vertex references of an `f` or `p` element ("7", "7/1", "7//3", "-1/-1/-1"), 0-based.
+// Negative references count back from the vertices read so far.
+static bool parseVertexRefs(const char* s, int numVertices, std::vector<int>& refs) {
+    refs.clear();
+    for (s = skipSpace(s); *s; s = skipSpace(s)) {
+        char* end = nullptr;
+        long v = strtol(s, &end, 10);
+        if (end == s || v == 0) return false;
+        refs.push_back(v < 0 ? numVertices + (int)v : (int)v - 1);
+        s = end;
+        while (*s && *s != ' ' && *s != '\t') ++s; // texture / normal indices
+    }
+    return true;
+}
+
+bool loadClothMeshOBJ(const char* path, ClothMesh& mesh, const MeshImportOptions& opt) {
+    mesh.clear();
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        printf("%s: cannot open\n", path);
+        return false;
+    }
+
+    std::string line, group = "default";
+    std::vector<int> refs;
+    int lineNo = 0;
+    bool ok = true;
+    while (ok && readLine(f, line)) {
+        ++lineNo;
+        const char* s = skipSpace(line.c_str());
+        const char* args = s + 1;
+        if (s[0] == 'v' && (s[1] == ' ' || s[1] == '\t')) {
+            // "v x y z [w]" or "v x y z r g b": only the position is used
+            char* end = nullptr;
+            float p[3];
+            for (int k = 0; k < 3; ++k) {
+                p[k] = strtof(args, &end);
+                ok &= (end != args);
+                args = end;
+            }
+            mesh.positions.push_back(vec3(p[0], p[1], p[2]) * opt.scale);
+            mesh.pinGroup.push_back(0);
+        } else if (s[0] == 'f' && (s[1] == ' ' || s[1] == '\t')) {
+            // Polygons are fanned around their first corner
+            ok = parseVertexRefs(args, (int)mesh.positions.size(), refs) && refs.size() >= 3;
+            for (size_t k = 2; ok && k < refs.size(); ++k) {
+                mesh.triangles.insert(mesh.triangles.end(), {refs[0], refs[k - 1], refs[k]});
+            }
+        } else if (s[0] == 'p' && (s[1] == ' ' || s[1] == '\t')) {
+            ok = parseVertexRefs(args, (int)mesh.positions.size(), refs);
+            const int g = pinGroupId(mesh, group);
+            for (int v : refs) {
+                ok &= (v >= 0 && v < (int)mesh.positions.size());
+                if (ok) mesh.pinGroup[v] = g;
+            }
+        } else if ((s[0] == 'g' || s[0] == 'o') && (s[1] == ' ' || s[1] == '\t')) {
+            group = skipSpace(args);
+            while (!group.empty() && (group.back() == ' ' || group.back() == '\t')) group.pop_back();
+        }
+        // vt, vn, l, s, usemtl, mtllib and comments carry nothing the solver needs
+    }
+    fclose(f);
+    if (!ok) {
+        printf("%s:%d: malformed element\n", path, lineNo);
+        return false;
+    }
+    return finishMesh(path, mesh, opt);
+}
+
+// ---------------------------------------------------------
+// glTF
+// ---------------------------------------------------------
+
+namespace {
+
+// Just enough JSON for the glTF document (the geometry itself never goes through it)
+struct Json {
+    enum Type { NUL, BOOL, NUMBER, STRING, ARRAY, OBJECT };
+    Type type = NUL;
+    double number = 0.0;
+    std::string str;
+    std::vector<Json> items;
+    std::vector<std::pair<std::string, Json>> members;
+
+    const Json* get(const char* key) const {
+        for (const auto& m : members) {
+            if (m.first == key) return &m.second;
+        }
+        return nullptr;
+    }
+    const Json* at(int k) const { return (type == ARRAY && k >= 0 && k < (int)items.size()) ? &items[k] : nullptr; }
+    int intOr(const char* key, int fallback) const {
+        const Json* v = get(key);
+        return (v && v->type == NUMBER) ? (int)v->number : fallback;
+    }
+    uint64_t sizeOr(const char* key, uint64_t fallback) const {
+        const Json* v = get(key);
+        return (v && v->type == NUMBER && v->number >= 0.0) ? (uint64_t)v->number : fallback;
+    }
+};
+
+class JsonParser {
+public:
+    JsonParser(const char* begin, const char* end) : p(begin), end(end) {}
+
+    bool parse(Json& out) {
+        return value(out, 0) && (skip(), p == end);
+    }
+
+private:
+    static const int kMaxDepth = 64;
+
+    void skip() {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) ++p;
+    }
+    bool literal(const char* word) {
+        const size_t n = strlen(word);
+        if ((size_t)(end - p) < n || memcmp(p, word, n) != 0) return false;
+        p += n;
+        return true;
+    }
+
+    bool string(std::string& out) {
+        out.clear();
+        if (p == end || *p != '"') return false;
+        for (++p; p < end && *p != '"'; ++p) {
+            if (*p != '\\') {
+                out += *p;
+                continue;
+            }
+            if (++p == end) return false;
+            switch (*p) {
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case 'u': // keys and names the importer compares are ASCII
+                if (end - p < 5) return false;
+                out += '?';
+                p += 4;
+                break;
+            default: out += *p; break;
+            }
+        }
+        if (p == end) return false;
+        ++p;
+        return true;
+    }
+
+    bool value(Json& v, int depth) {
+        skip();
+        if (p == end || depth > kMaxDepth) return false;
+        if (*p == '{') {
+            v.type = Json::OBJECT;
+            ++p;
+            skip();
+            if (p < end && *p == '}') return ++p, true;
+            for (;;) {
+                v.members.emplace_back();
+                skip();
+                if (!string(v.members.back().first)) return false;
+                skip();
+                if (p == end || *p++ != ':' || !value(v.members.back().second, depth + 1)) return false;
+                skip();
+                if (p < end && *p == ',') { ++p; continue; }
+                return p < end && *p++ == '}';
+            }
+        }
+        if (*p == '[') {
+            v.type = Json::ARRAY;
+            ++p;
+            skip();
+            if (p < end && *p == ']') return ++p, true;
+            for (;;) {
+                v.items.emplace_back();
+                if (!value(v.items.back(), depth + 1)) return false;
+                skip();
+                if (p < end && *p == ',') { ++p; continue; }
+                return p < end && *p++ == ']';
+            }
+        }
+        if (*p == '"') {
+            v.type = Json::STRING;
+            return string(v.str);
+        }
+        if (literal("true"))  { v.type = Json::BOOL; v.number = 1.0; return true; }
+        if (literal("false")) { v.type = Json::BOOL; return true; }
+        if (literal("null"))  return true;
+
+        // The document is not NUL-terminated: copy the number out before strtod
+        char buf[64];
+        size_t n = 0;
+        while (p + n < end && n + 1 < sizeof(buf) && p[n] && strchr("+-0123456789.eE", p[n])) ++n;
+        if (n == 0) return false;
+        memcpy(buf, p, n);
+        buf[n] = 0;
+        v.type = Json::NUMBER;
+        v.number = strtod(buf, nullptr);
+        p += n;
+        return true;
+    }
+
+    const char* p;
+    const char* end;
+};
+
+// 64-bit file positioning
+bool seekTo(FILE* f, uint64_t offset) {
+#if defined(_WIN32)
+    return _fseeki64(f, (long long)offset, SEEK_SET) == 0;
+#else
+    return fseeko(f, (off_t)offset, SEEK_SET) == 0;
+#endif
+}
+
+enum : int {
+    GL_UNSIGNED_BYTE = 5121,
+    GL_UNSIGNED_SHORT = 5123,
+    GL_UNSIGNED_INT = 5125,
+    GL_FLOAT = 5126,
+};
+
+int componentSize(int type) {
+    switch (type) {
+    case GL_UNSIGNED_BYTE:  return 1;
+    case GL_UNSIGNED_SHORT: return 2;
+    case GL_UNSIGNED_INT:
+    case GL_FLOAT:          return 4;
+    default:                return 0;
+    }
+}
+
+int componentCount(const Json* type) {
+    if (!type || type->type != Json::STRING) return 0;
+    if (type->str == "SCALAR") return 1;
+    if (type->str == "VEC2") return 2;
+    if (type->str == "VEC3") return 3;
+    if (type->str == "VEC4") return 4;
+    return 0;
+}
+
+// The document plus one open file per buffer: the .glb itself (BIN chunk at `base`) or the
+// external .bin files of a .gltf
+struct GltfSource {
+    Json doc;
+    std::vector<FILE*> files;
+    std::vector<uint64_t> base, size;
+    std::vector<uint8_t> chunk; // accessor staging, reused
+
+    ~GltfSource() {
+        for (FILE* f : files) {
+            if (f) fclose(f);
+        }
+    }
+};
+
+// Elements of accessor `index` converted to T, `comps` per element, written to `out` (count * comps).
+// Read through a fixed staging chunk, never the whole buffer. Integer components are taken as
+// they are stored ("normalized" is ignored).
+template <typename T>
+bool readAccessor(GltfSource& src, int index, int comps, T* out, size_t expectedCount) {
+    static const size_t kChunkBytes = 1 << 16;
+
+    const Json* acc = src.doc.get("accessors") ? src.doc.get("accessors")->at(index) : nullptr;
+    if (!acc || acc->get("sparse") || componentCount(acc->get("type")) != comps) return false;
+    const int type = acc->intOr("componentType", 0);
+    const size_t compSize = (size_t)componentSize(type);
+    const size_t count = (size_t)acc->sizeOr("count", 0);
+    if (compSize == 0 || count != expectedCount) return false;
+
+    const Json* view = src.doc.get("bufferViews") ? src.doc.get("bufferViews")->at(acc->intOr("bufferView", -1)) : nullptr;
+    if (!view) {
+        std::fill(out, out + count * comps, T(0)); // no view: all zeros
+        return true;
+    }
+    const int buffer = view->intOr("buffer", -1);
+    if (buffer < 0 || buffer >= (int)src.files.size() || !src.files[buffer]) return false;
+    const size_t elemSize = compSize * comps;
+    const size_t stride = std::max<size_t>(elemSize, (size_t)view->sizeOr("byteStride", 0));
+    const uint64_t start = view->sizeOr("byteOffset", 0) + acc->sizeOr("byteOffset", 0);
+    const uint64_t viewEnd = view->sizeOr("byteOffset", 0) + view->sizeOr("byteLength", 0);
+    if (count > 0 && (start + (count - 1) * stride + elemSize > viewEnd || viewEnd > src.size[buffer])) return false;
+
+    FILE* f = src.files[buffer];
+    const size_t perChunk = std::max<size_t>(1, kChunkBytes / stride);
+    for (size_t first = 0; first < count; first += perChunk) {
+        const size_t m = std::min(perChunk, count - first);
+        const size_t bytes = (m - 1) * stride + elemSize;
+        src.chunk.resize(bytes);
+        if (!seekTo(f, src.base[buffer] + start + first * stride) || fread(src.chunk.data(), 1, bytes, f) != bytes) return false;
+        for (size_t e = 0; e < m; ++e) {
+            const uint8_t* q = src.chunk.data() + e * stride;
+            T* o = out + (first + e) * comps;
+            for (int c = 0; c < comps; ++c, q += compSize) {
+                switch (type) {
+                case GL_UNSIGNED_BYTE:  o[c] = (T)q[0]; break;
+                case GL_UNSIGNED_SHORT: { uint16_t v; memcpy(&v, q, 2); o[c] = (T)v; break; }
+                case GL_UNSIGNED_INT:   { uint32_t v; memcpy(&v, q, 4); o[c] = (T)v; break; }
+                default:                { float v;    memcpy(&v, q, 4); o[c] = (T)v; break; }
+                }
+            }
+        }
+    }
+    return true;
+}
+
+bool readAll(FILE* f, uint64_t offset, size_t bytes, std::string& out) {
+    out.resize(bytes);
+    return seekTo(f, offset) && (bytes == 0 || fread(&out[0], 1, bytes, f) == bytes);
+}
+
+uint64_t fileSize(FILE* f) {
+#if defined(_WIN32)
+    _fseeki64(f, 0, SEEK_END);
+    return (uint64_t)_ftelli64(f);
+#else
+    fseeko(f, 0, SEEK_END);
+    return (uint64_t)ftello(f);
+#endif
+}
+
+// Open the document and every buffer it names
+bool openGltf(const char* path, GltfSource& src) {
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        printf("%s: cannot open\n", path);
+        return false;
+    }
+    const uint64_t bytes = fileSize(f);
+
+    std::string json;
+    uint64_t binBase = 0, binSize = 0;
+    uint32_t header[5] = {};
+    const bool glb = hasExtension(path, ".glb");
+    if (glb) {
+        // magic, version, length, then the JSON chunk (length, type) and an optional BIN chunk
+        if (!seekTo(f, 0) || fread(header, 4, 5, f) != 5 || header[0] != 0x46546C67u || header[1] != 2 ||
+            header[4] != 0x4E4F534Au || 20 + (uint64_t)header[3] > bytes || !readAll(f, 20, header[3], json)) {
+            printf("%s: not a glTF 2.0 binary\n", path);
+            fclose(f);
+            return false;
+        }
+        uint32_t bin[2] = {};
+        const uint64_t binHeader = 20 + (((uint64_t)header[3] + 3) & ~uint64_t(3));
+        if (binHeader + 8 <= bytes && seekTo(f, binHeader) && fread(bin, 4, 2, f) == 2 && bin[1] == 0x004E4942u) {
+            binBase = binHeader + 8;
+            binSize = std::min<uint64_t>(bin[0], bytes - binBase);
+        }
+    } else if (!readAll(f, 0, (size_t)bytes, json)) {
+        printf("%s: cannot read\n", path);
+        fclose(f);
+        return false;
+    }
+    if (!JsonParser(json.data(), json.data() + json.size()).parse(src.doc) || src.doc.type != Json::OBJECT) {
+        printf("%s: malformed glTF JSON\n", path);
+        fclose(f);
+        return false;
+    }
+
+    std::string dir(path);
+    const size_t slash = dir.find_last_of("/\\");
+    dir = (slash == std::string::npos) ? std::string() : dir.substr(0, slash + 1);
+
+    const Json* buffers = src.doc.get("buffers");
+    const int numBuffers = buffers ? (int)buffers->items.size() : 0;
+    bool ownUsed = false;
+    for (int b = 0; b < numBuffers; ++b) {
+        const Json* uri = buffers->items[b].get("uri");
+        FILE* bf = nullptr;
+        uint64_t base = 0, size = 0;
+        if (!uri && glb && b == 0 && binSize > 0) {
+            bf = f;
+            base = binBase;
+            size = binSize;
+            ownUsed = true;
+        } else if (uri && uri->type == Json::STRING && uri->str.compare(0, 5, "data:") != 0) {
+            bf = fopen((dir + uri->str).c_str(), "rb");
+            if (bf) size = fileSize(bf);
+        }
+        if (!bf) {
+            printf("%s: buffer %d unavailable (data URIs are not supported)\n", path, b);
+        }
+        src.files.push_back(bf);
+        src.base.push_back(base);
+        src.size.push_back(size);
+    }
+    if (!ownUsed) fclose(f);
+    return true;
+}
+
+} // namespace
+
+bool loadClothMeshGLTF(const char* path, ClothMesh& mesh, const MeshImportOptions& opt) {
+    mesh.clear();
+    GltfSource src;
+    if (!openGltf(path, src)) return false;
+
+    const Json* meshes = src.doc.get("meshes");
+    const Json* accessors = src.doc.get("accessors");
+    std::vector<float> pins;
+    std::vector<uint32_t> indices;
+    int maxGroup = 0;
+    for (size_t mi = 0; meshes && accessors && mi < meshes->items.size(); ++mi) {
+        const Json* prims = meshes->items[mi].get("primitives");
+        for (size_t pi = 0; prims && pi < prims->items.size(); ++pi) {
+            const Json& prim = prims->items[pi];
+            const Json* attrs = prim.get("attributes");
+            if (prim.intOr("mode", 4) != 4 || !attrs || !attrs->get("POSITION")) continue; // triangles only
+
+            const int posAcc = attrs->intOr("POSITION", -1);
+            const Json* posInfo = accessors->at(posAcc);
+            const size_t count = posInfo ? (size_t)posInfo->sizeOr("count", 0) : 0;
+            const size_t first = mesh.positions.size();
+            mesh.positions.resize(first + count);
+            mesh.pinGroup.resize(first + count, 0);
+            bool ok = posInfo && posInfo->intOr("componentType", 0) == GL_FLOAT &&
+                      readAccessor(src, posAcc, 3, reinterpret_cast<float*>(mesh.positions.data() + first), count);
+
+            if (ok && attrs->get("_PIN")) {
+                pins.resize(count);
+                ok = readAccessor(src, attrs->intOr("_PIN", -1), 1, pins.data(), count);
+                for (size_t k = 0; ok && k < count; ++k) {
+                    const int g = std::max(0, (int)std::lround(pins[k]));
+                    mesh.pinGroup[first + k] = g;
+                    maxGroup = std::max(maxGroup, g);
+                }
+            }
+
+            if (ok && prim.get("indices")) {
+                const Json* idxInfo = accessors->at(prim.intOr("indices", -1));
+                indices.resize(idxInfo ? (size_t)idxInfo->sizeOr("count", 0) : 0);
+                ok = idxInfo && indices.size() % 3 == 0 &&
+                     readAccessor(src, prim.intOr("indices", -1), 1, indices.data(), indices.size());
+                for (size_t k = 0; ok && k < indices.size(); ++k) {
+                    ok = indices[k] < count;
+                    mesh.triangles.push_back((int)(first + indices[k]));
+                }
+            } else if (ok) {
+                for (size_t k = 0; k + 2 < count; k += 3) {
+                    mesh.triangles.insert(mesh.triangles.end(), {(int)(first + k), (int)(first + k + 1), (int)(first + k + 2)});
+                }
+            }
+            if (!ok) {
+                printf("%s: mesh %d primitive %d has unreadable accessors\n", path, (int)mi, (int)pi);
+                return false;
+            }
+        }
+    }
+
+    for (vec3& p : mesh.positions) p *= opt.scale;
+    for (int g = 1; g <= maxGroup; ++g) mesh.pinGroupNames.push_back(std::to_string(g));
+    return finishMesh(path, mesh, opt);
+}
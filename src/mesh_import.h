@@ -0,0 +1,45 @@
+// mesh_import.h - Cloth meshes from OBJ and glTF files
+//
+// Loads positions, triangles and pin groups of a garment authored in a DCC tool, ready for
+// ClothInstance::buildMesh(), which derives de-duplicated edge constraints (optionally bending
+// constraints across every interior edge) and geodesic LRA tethers from them.
+//
+// Files are streamed: OBJ line by line, glTF accessors in fixed-size chunks straight from the
+// binary buffer, so only the resulting arrays are ever held in memory.
+//
+// Pin groups:
+// - OBJ: point elements (`p v1 v2 ...`) pin their vertices into the group of the current
+//   `g` / `o` statement. Groups are numbered 1, 2, ... in order of first appearance.
+// - glTF: a scalar `_PIN` vertex attribute (float, unsigned byte or unsigned short); the rounded
+//   value is the group, 0 is free. Group k is named "k".
+//
+// glTF support covers .glb and .gltf with external .bin buffers (no data URIs), triangle
+// primitives of every mesh, in mesh space (node transforms are not applied).
+
+#pragma once
+
+#include "cloth_types.h"
+
+#include <string>
+#include <vector>
+
+struct ClothMesh {
+    std::vector<vec3> positions;
+    std::vector<int> triangles;             // 3 vertex indices per triangle
+    std::vector<int> pinGroup;              // per vertex: 0 = free, k = pinGroupNames[k - 1]
+    std::vector<std::string> pinGroupNames;
+    std::vector<int> pinned;                // vertices of the selected pin groups, ascending
+
+    void clear();
+};
+
+struct MeshImportOptions {
+    float scale = 1.0f;                  // applied to every position (e.g. 0.01 for centimetre files)
+    bool weld = true;                    // merge vertices at bitwise equal positions (UV / normal seams)
+    std::vector<std::string> pinGroups;  // groups to pin by name, empty = every group
+};
+
+// Load by extension (.obj, .gltf, .glb). Prints the reason and returns false on failure.
+bool loadClothMesh(const char* path, ClothMesh& mesh, const MeshImportOptions& opt = MeshImportOptions());
+bool loadClothMeshOBJ(const char* path, ClothMesh& mesh, const MeshImportOptions& opt = MeshImportOptions());
+bool loadClothMeshGLTF(const char* path, ClothMesh& mesh, const MeshImportOptions& opt = MeshImportOptions());
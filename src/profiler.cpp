@@ -0,0 +1,95 @@
+// profiler.cpp - Per-phase hot-path timers, rolling statistics and Chrome trace capture
+
+#include "profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+const char* phaseName(int phase) {
+    static const char* names[PHASE_COUNT] = {"aero", "integrate", "local", "lra", "collide", "velocity", "display"};
+    return (phase >= 0 && phase < PHASE_COUNT) ? names[phase] : "?";
+}
+
+int64_t Profiler::nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Small stable id per thread for the trace viewer
+static int threadId() {
+    static std::atomic<int> next{0};
+    thread_local int id = next.fetch_add(1);
+    return id;
+}
+
+void Profiler::add(int phase, int64_t startNs, int64_t durNs) {
+    frameNs[phase].fetch_add(durNs, std::memory_order_relaxed);
+    if (traceOn.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(traceMtx);
+        trace.push_back({phase, threadId(), startNs, durNs});
+    }
+}
+
+void Profiler::endFrame() {
+    for (int p = 0; p < PHASE_COUNT; ++p) {
+        history[p][head] = (float)(frameNs[p].exchange(0, std::memory_order_relaxed) * 1e-6);
+    }
+    head = (head + 1) % kHistory;
+    count = std::min(count + 1, kHistory);
+}
+
+void Profiler::reset() {
+    for (int p = 0; p < PHASE_COUNT; ++p) frameNs[p].store(0);
+    head = 0;
+    count = 0;
+}
+
+Profiler::PhaseStats Profiler::stats(int phase) const {
+    PhaseStats s = {0.0, 0.0, 0.0, 0.0, 0.0};
+    if (count == 0) return s;
+
+    std::vector<float> v(history[phase], history[phase] + count);
+    double sum = 0.0;
+    for (float x : v) sum += x;
+    s.avgMs = sum / count;
+
+    std::sort(v.begin(), v.end());
+    auto pct = [&](double q) { return (double)v[std::min(count - 1, (int)(q * (count - 1) + 0.5))]; };
+    s.p50Ms = pct(0.50);
+    s.p95Ms = pct(0.95);
+    s.p99Ms = pct(0.99);
+    s.maxMs = v.back();
+    return s;
+}
+
+void Profiler::beginTrace() {
+    std::lock_guard<std::mutex> lock(traceMtx);
+    trace.clear();
+    traceStartNs = nowNs();
+    traceOn = true;
+}
+
+bool Profiler::endTrace(const char* path) {
+    traceOn = false;
+    std::lock_guard<std::mutex> lock(traceMtx);
+
+    FILE* f = fopen(path, "w");
+    if (!f) return false;
+    fprintf(f, "{\"traceEvents\":[\n");
+    for (size_t k = 0; k < trace.size(); ++k) {
+        const TraceEvent& e = trace[k];
+        fprintf(f, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}%s\n",
+                phaseName(e.phase), e.tid, (e.startNs - traceStartNs) * 1e-3, e.durNs * 1e-3,
+                k + 1 < trace.size() ? "," : "");
+    }
+    fprintf(f, "],\"displayTimeUnit\":\"ms\"}\n");
+    fclose(f);
+    trace.clear();
+    return true;
+}
+
+Profiler& profiler() {
+    static Profiler p;
+    return p;
+}
@@ -0,0 +1,102 @@
+// profiler.h - Per-phase hot-path timers, rolling statistics and Chrome trace capture
+//
+// LRA_PROFILE_SCOPE(phase) times the enclosing scope. Durations are summed per frame (a phase may
+// run many times per frame: every substep / iteration) and endFrame() pushes the totals into a
+// rolling window from which averages and percentiles are read. While a trace is being captured
+// every scope is also recorded as a Chrome trace event (chrome://tracing, Perfetto). Building with
+// LRA_TRACY forwards the same scopes to Tracy.
+//
+// Timing is off until `enabled` is set: every scope reads the clock twice and adds to atomics
+// shared by all threads, which the inner passes of a shipping build should not pay for. The demo
+// and the benchmarks that report phases switch it on.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#if defined(LRA_TRACY)
+#include <tracy/Tracy.hpp>
+#endif
+
+enum ProfilePhase {
+    PHASE_AERO = 0,
+    PHASE_INTEGRATE,
+    PHASE_LOCAL,
+    PHASE_LRA,
+    PHASE_COLLIDE,
+    PHASE_VELOCITY,
+    PHASE_DISPLAY,
+    PHASE_COUNT
+};
+
+const char* phaseName(int phase);
+
+class Profiler {
+public:
+    static const int kHistory = 240; // frames in the rolling window
+
+    struct PhaseStats {
+        double avgMs, p50Ms, p95Ms, p99Ms, maxMs;
+    };
+
+    bool enabled = false;
+
+    static int64_t nowNs();
+
+    // Called by ScopedTimer (thread-safe)
+    void add(int phase, int64_t startNs, int64_t durNs);
+
+    // Close the current frame: per-phase totals go into the rolling window
+    void endFrame();
+    void reset();
+
+    PhaseStats stats(int phase) const;
+    int frames() const { return count; }
+
+    // Chrome trace capture ("traceEvents" JSON)
+    void beginTrace();
+    bool endTrace(const char* path);
+    bool tracing() const { return traceOn.load(std::memory_order_relaxed); }
+
+private:
+    struct TraceEvent {
+        int phase;
+        int tid;
+        int64_t startNs, durNs;
+    };
+
+    std::atomic<int64_t> frameNs[PHASE_COUNT] = {};
+    float history[PHASE_COUNT][kHistory] = {};
+    int head = 0;
+    int count = 0;
+
+    std::atomic<bool> traceOn{false};
+    int64_t traceStartNs = 0;
+    std::mutex traceMtx;
+    std::vector<TraceEvent> trace;
+};
+
+Profiler& profiler();
+
+class ScopedTimer {
+public:
+    explicit ScopedTimer(int phase) : phase(phase), start(profiler().enabled ? Profiler::nowNs() : -1) {}
+    ~ScopedTimer() {
+        if (start >= 0) profiler().add(phase, start, Profiler::nowNs() - start);
+    }
+
+private:
+    int phase;
+    int64_t start;
+};
+
+#define LRA_PROFILE_CONCAT2(a, b) a##b
+#define LRA_PROFILE_CONCAT(a, b) LRA_PROFILE_CONCAT2(a, b)
+#if defined(LRA_TRACY)
+#define LRA_PROFILE_SCOPE(phase) ZoneScopedN(#phase); ScopedTimer LRA_PROFILE_CONCAT(lraTimer_, __LINE__)(phase)
+#else
+#define LRA_PROFILE_SCOPE(phase) ScopedTimer LRA_PROFILE_CONCAT(lraTimer_, __LINE__)(phase)
+#endif
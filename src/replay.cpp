@@ -0,0 +1,396 @@
+// replay.cpp - Deterministic recording and headless replay of one cloth's simulation
+
+#include "replay.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+static const uint32_t kByteOrderTag = 0x01020304u;
+
+// ---------------------------------------------------------
+// Byte helpers
+// ---------------------------------------------------------
+
+template <typename T>
+static void put(std::vector<uint8_t>& out, const T& v) {
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(&v);
+    out.insert(out.end(), p, p + sizeof(T));
+}
+
+template <typename T>
+static void putArray(std::vector<uint8_t>& out, const T* v, size_t count) {
+    put(out, (uint32_t)count);
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(v);
+    out.insert(out.end(), p, p + count * sizeof(T));
+}
+
+// Bounds-checked reader over one record's payload
+struct ByteReader {
+    const uint8_t* p;
+    const uint8_t* end;
+    bool ok = true;
+
+    template <typename T>
+    T get() {
+        T v{};
+        if (end - p < (ptrdiff_t)sizeof(T)) { ok = false; p = end; return v; }
+        memcpy(&v, p, sizeof(T));
+        p += sizeof(T);
+        return v;
+    }
+
+    template <typename T>
+    void getArray(std::vector<T>& out) {
+        const uint32_t count = get<uint32_t>();
+        if (!ok || (size_t)(end - p) / sizeof(T) < count) { ok = false; p = end; return; }
+        out.resize(count);
+        if (count) memcpy(out.data(), p, count * sizeof(T));
+        p += count * sizeof(T);
+    }
+};
+
+// ---------------------------------------------------------
+// Keyframes
+// ---------------------------------------------------------
+
+static const int kKeyframeArrays = 10;
+static std::vector<float> ParticleStore::* const kKeyframeMembers[kKeyframeArrays] = {
+    &ParticleStore::x,  &ParticleStore::y,  &ParticleStore::z,
+    &ParticleStore::px, &ParticleStore::py, &ParticleStore::pz,
+    &ParticleStore::vx, &ParticleStore::vy, &ParticleStore::vz, &ParticleStore::w,
+};
+
+// Word `i` of array `a` is predicted by the same word of the previous keyframe, except the previous
+// positions, which sit much closer to this keyframe's positions (one step back)
+static const int kReferenceArray[kKeyframeArrays] = {-1, -1, -1, 0, 1, 2, -1, -1, -1, -1};
+
+// XOR residuals of nearby floats keep their high bytes zero; two residuals share a byte holding
+// how many low bytes of each follow
+static void putResiduals(std::vector<uint8_t>& out, const uint32_t* r, uint32_t n) {
+    auto bytes = [](uint32_t v) { return v == 0 ? 0 : v < 0x100 ? 1 : v < 0x10000 ? 2 : v < 0x1000000 ? 3 : 4; };
+    for (uint32_t i = 0; i < n; i += 2) {
+        const uint32_t a = r[i], b = (i + 1 < n) ? r[i + 1] : 0u;
+        const int na = bytes(a), nb = bytes(b);
+        out.push_back(uint8_t(na | (nb << 4)));
+        for (int k = 0; k < na; ++k) out.push_back(uint8_t(a >> (8 * k)));
+        for (int k = 0; k < nb; ++k) out.push_back(uint8_t(b >> (8 * k)));
+    }
+}
+
+static bool getResiduals(ByteReader& r, uint32_t* out, uint32_t n) {
+    for (uint32_t i = 0; i < n; i += 2) {
+        const uint8_t counts = r.get<uint8_t>();
+        const int na = counts & 0xf, nb = counts >> 4;
+        if (!r.ok || na > 4 || nb > 4 || r.end - r.p < na + nb) return false;
+        uint32_t a = 0, b = 0;
+        for (int k = 0; k < na; ++k) a |= uint32_t(*r.p++) << (8 * k);
+        for (int k = 0; k < nb; ++k) b |= uint32_t(*r.p++) << (8 * k);
+        out[i] = a;
+        if (i + 1 < n) out[i + 1] = b;
+        else if (b) return false;
+    }
+    return true;
+}
+
+void KeyframeCodec::encode(const ParticleStore& P, std::vector<uint8_t>& out) {
+    const uint32_t n = (uint32_t)P.size();
+    put(out, n);
+    if (last.size() != size_t(n) * kKeyframeArrays) last.assign(size_t(n) * kKeyframeArrays, 0u);
+    residual.resize(n);
+
+    for (int a = 0; a < kKeyframeArrays; ++a) {
+        const float* v = (P.*kKeyframeMembers[a]).data();
+        const uint32_t* ref = last.data() + size_t(kReferenceArray[a] < 0 ? a : kReferenceArray[a]) * n;
+        for (uint32_t i = 0; i < n; ++i) {
+            uint32_t bits;
+            memcpy(&bits, &v[i], 4);
+            residual[i] = bits ^ ref[i];
+        }
+        putResiduals(out, residual.data(), n);
+        memcpy(last.data() + size_t(a) * n, v, size_t(n) * 4);
+    }
+    out.insert(out.end(), P.pinned.begin(), P.pinned.end());
+}
+
+bool KeyframeCodec::decode(const uint8_t* p, const uint8_t* end, ParticleStore& P) {
+    ByteReader r{p, end};
+    const uint32_t n = r.get<uint32_t>();
+    if (!r.ok || n > (uint32_t)(end - r.p)) return false;
+    P.resize(n);
+    if (last.size() != size_t(n) * kKeyframeArrays) last.assign(size_t(n) * kKeyframeArrays, 0u);
+    residual.resize(n);
+
+    for (int a = 0; a < kKeyframeArrays; ++a) {
+        if (!getResiduals(r, residual.data(), n)) return false;
+        // Positions are decoded before the previous positions that reference them
+        const uint32_t* ref = last.data() + size_t(kReferenceArray[a] < 0 ? a : kReferenceArray[a]) * n;
+        uint32_t* bits = last.data() + size_t(a) * n;
+        for (uint32_t i = 0; i < n; ++i) bits[i] = residual[i] ^ ref[i];
+        memcpy((P.*kKeyframeMembers[a]).data(), bits, size_t(n) * 4);
+    }
+    if ((uint32_t)(end - r.p) < n) return false;
+    memcpy(P.pinned.data(), r.p, n);
+    return true;
+}
+
+// ---------------------------------------------------------
+// Recorder
+// ---------------------------------------------------------
+
+static bool sameColliders(const ColliderSet& a, const ColliderSet& b) {
+    return a.spheres.size() == b.spheres.size() && a.capsules.size() == b.capsules.size() &&
+           (a.spheres.empty() || !memcmp(a.spheres.data(), b.spheres.data(), a.spheres.size() * sizeof(SphereCollider))) &&
+           (a.capsules.empty() || !memcmp(a.capsules.data(), b.capsules.data(), a.capsules.size() * sizeof(CapsuleCollider)));
+}
+
+bool ReplayRecorder::begin(ClothInstance& c, const char* path, int keyframeInterval) {
+    end();
+    file = fopen(path, "wb");
+    if (!file) {
+        printf("Replay: cannot write %s\n", path);
+        return false;
+    }
+    cloth = &c;
+    interval = std::max(1, keyframeInterval);
+    step = 0;
+    bytes = 0;
+    ok = true;
+    codec.reset();
+    lastWind = WindField();
+    lastColliders = ColliderSet();
+
+    ReplayHeader h = {};
+    memcpy(h.magic, "LRAR", 4);
+    h.version = kReplayVersion;
+    h.byteOrder = kByteOrderTag;
+    h.keyframeInterval = (uint32_t)interval;
+    h.paramsSize = sizeof(SolverParams);
+    h.commandSize = sizeof(ClothCommand);
+    h.windSize = sizeof(WindField);
+    h.params = c.params;
+    ok = fwrite(&h, sizeof(h), 1, file) == 1;
+    bytes += sizeof(h);
+
+    writeRebuild();
+    c.onCommands = [this](const std::vector<ClothCommand>& batch) { onStep(batch); };
+    return ok;
+}
+
+void ReplayRecorder::rebuilt(const ClothInstance& c) {
+    if (!file || &c != cloth) return;
+    writeRebuild();
+}
+
+bool ReplayRecorder::end() {
+    if (!file) return ok;
+    writeKeyframe();
+    writeRecord(REPLAY_END, std::vector<uint8_t>());
+    cloth->onCommands = nullptr;
+    ok = (fclose(file) == 0) && ok;
+    file = nullptr;
+    cloth = nullptr;
+    return ok;
+}
+
+void ReplayRecorder::writeRebuild() {
+    buffer.clear();
+    put(buffer, (int32_t)cloth->gridW);
+    put(buffer, (int32_t)cloth->gridH);
+    put(buffer, (uint8_t)g_optimizeLayout);
+    put(buffer, (int32_t)g_lraTethers);
+    put(buffer, g_compliance);
+    writeRecord(REPLAY_REBUILD, buffer);
+    // The next keyframe is coded against zeros, as the player sees it after the rebuild
+    codec.reset();
+    writeKeyframe();
+}
+
+void ReplayRecorder::writeKeyframe() {
+    buffer.clear();
+    put(buffer, (uint32_t)step);
+    codec.encode(cloth->P, buffer);
+    writeRecord(REPLAY_KEYFRAME, buffer);
+}
+
+// Runs at the start of every simulate(): the state is that after `step` steps
+void ReplayRecorder::onStep(const std::vector<ClothCommand>& batch) {
+    if (step > 0 && step % interval == 0) writeKeyframe();
+
+    buffer.clear();
+    putArray(buffer, batch.data(), batch.size());
+    uint8_t flags = 0;
+    const bool skin = cloth->skin.moved;
+    const bool wind = memcmp(&cloth->wind, &lastWind, sizeof(WindField)) != 0;
+    const bool colliders = !sameColliders(cloth->colliders, lastColliders);
+    flags |= skin ? 1 : 0;
+    flags |= wind ? 2 : 0;
+    flags |= colliders ? 4 : 0;
+    put(buffer, flags);
+    if (skin) {
+        putArray(buffer, cloth->skin.x.data(), cloth->skin.size());
+        putArray(buffer, cloth->skin.y.data(), cloth->skin.size());
+        putArray(buffer, cloth->skin.z.data(), cloth->skin.size());
+    }
+    if (wind) {
+        put(buffer, cloth->wind);
+        lastWind = cloth->wind;
+    }
+    if (colliders) {
+        putArray(buffer, cloth->colliders.spheres.data(), cloth->colliders.spheres.size());
+        putArray(buffer, cloth->colliders.capsules.data(), cloth->colliders.capsules.size());
+        lastColliders = cloth->colliders;
+    }
+    writeRecord(REPLAY_STEP, buffer);
+    ++step;
+}
+
+void ReplayRecorder::writeRecord(ReplayRecordType type, const std::vector<uint8_t>& payload) {
+    const uint8_t t = type;
+    const uint32_t size = (uint32_t)payload.size();
+    ok = ok && fwrite(&t, 1, 1, file) == 1 && fwrite(&size, sizeof(size), 1, file) == 1 &&
+         (payload.empty() || fwrite(payload.data(), 1, payload.size(), file) == payload.size());
+    bytes += 1 + sizeof(size) + payload.size();
+}
+
+// ---------------------------------------------------------
+// Player
+// ---------------------------------------------------------
+
+bool ReplayPlayer::open(const char* path) {
+    data.clear();
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        printf("%s: cannot open\n", path);
+        return false;
+    }
+    const bool gotHeader = fread(&head, sizeof(head), 1, f) == 1;
+    uint8_t chunk[1 << 16];
+    size_t got;
+    while ((got = fread(chunk, 1, sizeof(chunk), f)) > 0) data.insert(data.end(), chunk, chunk + got);
+    fclose(f);
+
+    if (!gotHeader || memcmp(head.magic, "LRAR", 4) != 0) {
+        printf("%s: not a replay\n", path);
+        return false;
+    }
+    if (head.byteOrder != kByteOrderTag || head.version != kReplayVersion || head.paramsSize != sizeof(SolverParams) ||
+        head.commandSize != sizeof(ClothCommand) || head.windSize != sizeof(WindField)) {
+        printf("%s: version %u, recorded by a different build; record it again\n", path, head.version);
+        return false;
+    }
+    return true;
+}
+
+bool ReplayPlayer::run(ClothInstance& cloth, int maxSteps) {
+    stepsRun = keyframesChecked = keyframesMatched = mismatchedValues = 0;
+    firstMismatchStep = -1;
+    maxDeviation = 0.0f;
+
+    cloth.params = head.params;
+    cloth.onCommands = nullptr;
+    KeyframeCodec codec;
+    ParticleStore expected;
+    std::vector<ClothCommand> batch;
+    std::vector<float> sx, sy, sz;
+
+    const uint8_t* p = data.data();
+    const uint8_t* end = p + data.size();
+    while (p < end) {
+        ByteReader rec{p, end};
+        const uint8_t type = rec.get<uint8_t>();
+        const uint32_t size = rec.get<uint32_t>();
+        if (!rec.ok || (size_t)(end - rec.p) < size) return false;
+        ByteReader r{rec.p, rec.p + size};
+        p = rec.p + size;
+
+        switch (type) {
+        case REPLAY_REBUILD: {
+            const int w = r.get<int32_t>(), h = r.get<int32_t>();
+            const bool layout = r.get<uint8_t>() != 0;
+            const int tethers = r.get<int32_t>();
+            const float compliance = r.get<float>();
+            if (!r.ok || w < 2 || h < 2) return false;
+            // Build under the recorded globals, then put the caller's back
+            const bool savedLayout = g_optimizeLayout;
+            const int savedTethers = g_lraTethers;
+            const float savedCompliance = g_compliance;
+            g_optimizeLayout = layout;
+            g_lraTethers = tethers;
+            g_compliance = compliance;
+            cloth.buildScene(w, h);
+            g_optimizeLayout = savedLayout;
+            g_lraTethers = savedTethers;
+            g_compliance = savedCompliance;
+            codec.reset();
+            break;
+        }
+        case REPLAY_STEP: {
+            if (maxSteps >= 0 && stepsRun >= maxSteps) return true;
+            r.getArray(batch);
+            const uint8_t flags = r.get<uint8_t>();
+            if (flags & 1) {
+                r.getArray(sx);
+                r.getArray(sy);
+                r.getArray(sz);
+                // Recorded targets are all the replay needs; static bones keep the bind poses out of it
+                if (cloth.skin.size() != sx.size()) cloth.bindAttachments(std::vector<int>(cloth.attachmentIndices.size(), -1));
+                if (cloth.skin.size() != sx.size() || sy.size() != sx.size() || sz.size() != sx.size()) return false;
+                std::copy(sx.begin(), sx.end(), cloth.skin.x.begin());
+                std::copy(sy.begin(), sy.end(), cloth.skin.y.begin());
+                std::copy(sz.begin(), sz.end(), cloth.skin.z.begin());
+                cloth.skin.moved = true;
+            }
+            if (flags & 2) cloth.wind = r.get<WindField>();
+            if (flags & 4) {
+                r.getArray(cloth.colliders.spheres);
+                r.getArray(cloth.colliders.capsules);
+            }
+            if (!r.ok) return false;
+            for (const ClothCommand& c : batch) cloth.commands.push(c);
+            cloth.simulate();
+            ++stepsRun;
+            break;
+        }
+        case REPLAY_KEYFRAME: {
+            const int step = (int)r.get<uint32_t>();
+            if (!r.ok || !codec.decode(r.p, r.end, expected)) return false;
+            compare(cloth, expected, step);
+            break;
+        }
+        case REPLAY_END:
+            return true;
+        default:
+            return false;
+        }
+    }
+    return false; // no REPLAY_END: truncated
+}
+
+void ReplayPlayer::compare(const ClothInstance& cloth, const ParticleStore& expected, int step) {
+    ++keyframesChecked;
+    const ParticleStore& P = cloth.P;
+    int differing = 0;
+    float deviation = 0.0f;
+    if (P.size() != expected.size()) {
+        differing = (int)std::max(P.size(), expected.size());
+        deviation = INFINITY;
+    } else {
+        for (int k = 0; k < kKeyframeArrays; ++k) {
+            const float* a = (P.*kKeyframeMembers[k]).data();
+            const float* b = (expected.*kKeyframeMembers[k]).data();
+            for (size_t i = 0; i < P.size(); ++i) differing += memcmp(&a[i], &b[i], 4) != 0;
+        }
+        for (size_t i = 0; i < P.size(); ++i) {
+            differing += P.pinned[i] != expected.pinned[i];
+            deviation = std::max(deviation, glm::length(P.position((int)i) - expected.position((int)i)));
+        }
+    }
+    if (differing == 0) {
+        ++keyframesMatched;
+    } else if (firstMismatchStep < 0) {
+        firstMismatchStep = step;
+        mismatchedValues = differing;
+        maxDeviation = deviation;
+    }
+}
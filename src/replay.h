@@ -0,0 +1,122 @@
+// replay.h - Deterministic recording and headless replay of one cloth's simulation
+//
+// ReplayRecorder logs everything a step consumes from outside the solver: the command batch
+// (parameter changes, pins, impulses, teleports, wind, compliance, tethers), the skinned anchor
+// targets, and the wind field and colliders whenever they change. Rebuilds are logged with the
+// build globals they ran under. Every `keyframeInterval` steps it also writes the particle state,
+// each word XORed with a prediction (the previous keyframe; this one's positions for the previous
+// positions) and stored as its nonzero low bytes. Settled regions cost half a byte a word, moving
+// ones stay near raw size, so the interval sets the file size. ReplayPlayer rebuilds the cloth,
+// feeds the logged inputs to simulate() at full speed and compares each keyframe bit for bit,
+// which turns any recording into a golden trajectory for solver changes.
+//
+// Other direct edits of the cloth (setCompliance(), setTethersPerParticle(), addAttachment()...)
+// bypass the log; push them as commands while recording. Only the ParticleStore is keyframed,
+// so a replay runs from a rebuild, not from the middle of a recording.
+//
+// File: ReplayHeader, then records of [uint8 type][uint32 payload bytes][payload], ending with
+// REPLAY_END. Little-endian, same build only (commands and params are stored as raw structs).
+
+#pragma once
+
+#include "simulation.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+static const uint32_t kReplayVersion = 1;
+
+enum ReplayRecordType : uint8_t {
+    REPLAY_REBUILD = 1, // buildScene(w, h) under the recorded globals
+    REPLAY_STEP,        // inputs of one simulate()
+    REPLAY_KEYFRAME,    // ParticleStore after `step` steps
+    REPLAY_END,
+};
+
+struct ReplayHeader {
+    char magic[4];            // "LRAR"
+    uint32_t version;         // kReplayVersion
+    uint32_t byteOrder;       // 0x01020304 as written
+    uint32_t keyframeInterval;
+    uint32_t paramsSize;      // sizeof(SolverParams), sizeof(ClothCommand), sizeof(WindField)
+    uint32_t commandSize;
+    uint32_t windSize;
+    uint32_t reserved;
+    SolverParams params;      // of the cloth when recording began
+};
+
+// XOR-residual keyframe codec, shared by the recorder and the player
+class KeyframeCodec {
+public:
+    void reset() { last.clear(); }
+    void encode(const ParticleStore& P, std::vector<uint8_t>& out);
+    // False on a truncated or malformed payload
+    bool decode(const uint8_t* p, const uint8_t* end, ParticleStore& P);
+
+private:
+    std::vector<uint32_t> last;     // bits of the previous keyframe, 10 arrays of n words
+    std::vector<uint32_t> residual; // one array's XOR residuals
+};
+
+class ReplayRecorder {
+public:
+    ~ReplayRecorder() { end(); }
+
+    // Start logging `cloth`, which must have just been built by buildScene() (its particles are
+    // the first keyframe). Installs cloth.onCommands, so call it between steps. Returns false
+    // if the file cannot be written.
+    bool begin(ClothInstance& cloth, const char* path, int keyframeInterval = 60);
+
+    // Log a buildScene() of the recorded cloth just made (e.g. a reset), between steps
+    void rebuilt(const ClothInstance& cloth);
+
+    // Final keyframe, REPLAY_END and close; detaches from the cloth
+    bool end();
+
+    bool recording() const { return file != nullptr; }
+    int steps() const { return step; }
+    size_t bytesWritten() const { return bytes; }
+
+private:
+    void onStep(const std::vector<ClothCommand>& batch);
+    void writeRebuild();
+    void writeKeyframe();
+    void writeRecord(ReplayRecordType type, const std::vector<uint8_t>& payload);
+
+    FILE* file = nullptr;
+    ClothInstance* cloth = nullptr;
+    int interval = 60;
+    int step = 0;
+    size_t bytes = 0;
+    bool ok = true;
+    KeyframeCodec codec;
+    std::vector<uint8_t> buffer;
+    WindField lastWind;
+    ColliderSet lastColliders;
+};
+
+class ReplayPlayer {
+public:
+    bool open(const char* path);
+
+    // Run the whole log into `cloth`: rebuild, feed every step and compare every keyframe.
+    // `maxSteps` >= 0 stops early (fast-forward to that step). Returns false on a malformed file.
+    bool run(ClothInstance& cloth, int maxSteps = -1);
+
+    // Results of the last run()
+    int stepsRun = 0;
+    int keyframesChecked = 0;
+    int keyframesMatched = 0;
+    int firstMismatchStep = -1;   // step of the first keyframe that differed, -1 if none
+    int mismatchedValues = 0;     // in that keyframe
+    float maxDeviation = 0.0f;    // largest position difference there (m)
+
+    const ReplayHeader& header() const { return head; }
+
+private:
+    void compare(const ClothInstance& cloth, const ParticleStore& expected, int step);
+
+    ReplayHeader head = {};
+    std::vector<uint8_t> data; // records after the header
+};
@@ -0,0 +1,88 @@
+// sim_thread.cpp - Fixed-step simulation on its own thread, publishing frames to the renderer
+
+#include "sim_thread.h"
+
+#include <algorithm>
+
+using Clock = std::chrono::steady_clock;
+
+void ClothFrame::interpolate(Clock::time_point now, std::vector<vec3>& out) const {
+    const size_t n = x.size();
+    out.resize(n);
+    float a = std::chrono::duration<float>(now - time).count() / dt;
+    a = std::min(1.0f, std::max(0.0f, a));
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = vec3(prevX[i] + (x[i] - prevX[i]) * a,
+                      prevY[i] + (y[i] - prevY[i]) * a,
+                      prevZ[i] + (z[i] - prevZ[i]) * a);
+    }
+}
+
+void SimulationThread::start(ClothInstance& c) {
+    stop();
+    cloth = &c;
+    lastX = c.P.x;
+    lastY = c.P.y;
+    lastZ = c.P.z;
+    publish();
+    quit = false;
+    worker = std::thread([this] { run(); });
+}
+
+void SimulationThread::stop() {
+    if (!worker.joinable()) return;
+    quit = true;
+    worker.join();
+}
+
+void SimulationThread::edit(const std::function<void()>& f) {
+    std::lock_guard<std::mutex> lock(stepMutex);
+    f();
+    if (!cloth) return;
+    // The edit may have rebuilt or reordered the particles: restart the blend from here
+    lastX = cloth->P.x;
+    lastY = cloth->P.y;
+    lastZ = cloth->P.z;
+    publish();
+}
+
+void SimulationThread::publish() {
+    ClothFrame& f = frames.back();
+    // Same-size assignments reuse the slot's storage
+    f.prevX = lastX;
+    f.prevY = lastY;
+    f.prevZ = lastZ;
+    f.x = cloth->P.x;
+    f.y = cloth->P.y;
+    f.z = cloth->P.z;
+    f.time = Clock::now();
+    // Each slot keeps its own copy, refreshed the first time it is published after a change
+    if (f.topology.version != cloth->topologyVersion) cloth->copyTopology(f.topology);
+    f.solve = cloth->lastSolve;
+    f.sleepingTiles = cloth->sleepingTiles();
+    f.numTiles = cloth->numTiles();
+    f.tornEdges = cloth->tornEdges;
+    f.tethersPerParticle = cloth->tethersPerParticle;
+    f.steps = steps;
+    frames.publish();
+}
+
+void SimulationThread::run() {
+    const auto step = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(dt));
+    Clock::time_point next = Clock::now() + step;
+    while (!quit) {
+        std::this_thread::sleep_until(next);
+        const Clock::time_point now = Clock::now();
+        for (int k = 0; k < maxStepsPerFrame && next <= now; ++k, next += step) {
+            std::lock_guard<std::mutex> lock(stepMutex);
+            if (onStep) onStep();
+            lastX = cloth->P.x;
+            lastY = cloth->P.y;
+            lastZ = cloth->P.z;
+            cloth->simulate();
+            ++steps;
+            publish();
+        }
+        if (next <= now) next = now + step; // fell too far behind: slow down instead of spiralling
+    }
+}
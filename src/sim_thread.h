@@ -0,0 +1,77 @@
+// sim_thread.h - Fixed-step simulation on its own thread, publishing frames to the renderer
+//
+// The thread owns the cloth while it runs: it steps it every dt of wall-clock time and
+// publishes a ClothFrame (the last two step states, the topology they belong to and stats)
+// through a lock-free triple buffer. The render thread only ever reads frames, never the cloth,
+// so drawing and stepping overlap and neither waits for the other, and topology changes made
+// while stepping (queued pins, tether and compliance changes, tearing) reach it only as a new
+// frame. Those can be queued on ClothInstance::commands from any thread; other changes to the
+// cloth go through edit().
+
+#pragma once
+
+#include "simulation.h"
+#include "triple_buffer.h"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// One published simulation state: positions after the last two steps, so the renderer can
+// blend between them, the topology to draw them with and the stats the UI shows
+struct ClothFrame {
+    std::vector<float> prevX, prevY, prevZ;
+    std::vector<float> x, y, z;
+    std::chrono::steady_clock::time_point time; // when the step finished
+    ClothTopology topology;                     // re-copied only when topologyVersion changed
+    ClothInstance::SolveStats solve;
+    int sleepingTiles = 0;
+    int numTiles = 0;
+    int tornEdges = 0;
+    int tethersPerParticle = 1;
+    int steps = 0;                              // steps taken so far
+
+    bool empty() const { return x.empty(); }
+
+    // Positions blended between the two steps by the time elapsed since `time` (at most one step)
+    void interpolate(std::chrono::steady_clock::time_point now, std::vector<vec3>& out) const;
+};
+
+class SimulationThread {
+public:
+    // At most this many catch-up steps after a stall; further lost time is dropped
+    int maxStepsPerFrame = 4;
+
+    // Called on the simulation thread before every step (see FixedStepDriver::onStep)
+    std::function<void()> onStep;
+
+    ~SimulationThread() { stop(); }
+
+    // Start stepping `cloth`. It belongs to the simulation thread until stop(); touch it
+    // only inside edit().
+    void start(ClothInstance& cloth);
+    void stop();
+    bool running() const { return worker.joinable(); }
+
+    // Run `f` between two steps, with the simulation paused, and publish the edited state.
+    // Works (and runs `f` directly) when the thread is not running.
+    void edit(const std::function<void()>& f);
+
+    // Render thread: the newest published frame
+    const ClothFrame& latest() { return frames.acquire(); }
+
+private:
+    void run();
+    void publish();
+
+    ClothInstance* cloth = nullptr;
+    std::thread worker;
+    std::atomic<bool> quit{false};
+    std::mutex stepMutex; // held by the thread while stepping, by edit() while editing
+    TripleBuffer<ClothFrame> frames;
+    std::vector<float> lastX, lastY, lastZ; // positions before the current step
+    int steps = 0;
+};
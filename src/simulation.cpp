@@ -0,0 +1,1507 @@
+// simulation.cpp - Long Range Attachments (SCA 2012) solver core
+// Implementation based on "Long Range Attachments - A Method to Simulate Inextensible Clothing in Computer Games"
+
+#include "simulation.h"
+#include "lra_simd.h"
+#include "thread_pool.h"
+#include "geodesic.h"
+#include "layout.h"
+#include "profiler.h"
+#include "build_scratch.h"
+
+#include <cmath>
+#include <algorithm>
+
+using glm::length;
+
+// ---------------------------------------------------------
+// Globals
+// ---------------------------------------------------------
+
+// Parameters
+int  g_solverMode = SOLVER_GAUSS_SEIDEL;
+int  g_iterations = 5;       // Low iteration count to demonstrate LRA benefit
+int  g_iterationMode = ITERATIONS_FIXED;
+float g_iterationTolerance = 0.05f; // 5% RMS, about what 15 fixed iterations leave on a hanging 64x64
+int  g_maxIterations = 20;
+int  g_substeps = 1;         // Substeps per dt, each with `iterations` solver iterations
+bool g_useLRA = true;        // Toggle LRA
+float g_lraSlack = 1.0f;     // 1.0 = exact length, 1.2 = 20% stretch allowed (Fig 5)
+bool g_lraSimd = true;       // Vectorized LRA pass
+bool g_optimizeLayout = true; // Morton-order particles after buildScene()
+int  g_lraTethers = 1;       // 1 = nearest attachment only (paper default)
+bool g_sleep = false;
+float g_sleepVelocity = 0.01f; // 1 cm/s
+int  g_sleepSteps = 30;        // half a second at 60 Hz
+bool g_selfCollision = false;
+float g_collisionThickness = 0.04f; // a little under the particle spacing, so rest neighbours never collide
+float g_jacobiRelaxation = 1.5f;
+float g_compliance = 0.0f;          // rigid edges, as in the paper
+float g_tearStrain = 0.0f;          // untearable
+
+// ---------------------------------------------------------
+// Particle Storage
+// ---------------------------------------------------------
+
+void ParticleStore::resize(size_t n) {
+    x.resize(n);  y.resize(n);  z.resize(n);
+    px.resize(n); py.resize(n); pz.resize(n);
+    vx.resize(n); vy.resize(n); vz.resize(n);
+    w.resize(n);
+    pinned.resize(n);
+}
+
+Particle ParticleStore::get(int i) const {
+    Particle p;
+    p.p = vec3(x[i], y[i], z[i]);
+    p.old_p = vec3(px[i], py[i], pz[i]);
+    p.v = vec3(vx[i], vy[i], vz[i]);
+    p.w = w[i];
+    p.pinned = pinned[i] != 0;
+    return p;
+}
+
+void ParticleStore::set(int i, const Particle& p) {
+    x[i] = p.p.x;      y[i] = p.p.y;      z[i] = p.p.z;
+    px[i] = p.old_p.x; py[i] = p.old_p.y; pz[i] = p.old_p.z;
+    vx[i] = p.v.x;     vy[i] = p.v.y;     vz[i] = p.v.z;
+    w[i] = p.w;
+    pinned[i] = p.pinned ? 1 : 0;
+}
+
+void ParticleStore::gatherPositions(std::vector<vec3>& out) const {
+    out.resize(size());
+    for (size_t i = 0; i < size(); ++i) {
+        out[i] = vec3(x[i], y[i], z[i]);
+    }
+}
+
+void AttachmentSkin::clear() {
+    bone.clear();
+    bindX.clear(); bindY.clear(); bindZ.clear();
+    x.clear(); y.clear(); z.clear();
+    moved = false;
+}
+
+void AttachmentSkin::push(int b, float px, float py, float pz) {
+    bone.push_back(b);
+    bindX.push_back(px); bindY.push_back(py); bindZ.push_back(pz);
+    x.push_back(px);     y.push_back(py);     z.push_back(pz);
+}
+
+void AttachmentSkin::erase(size_t k) {
+    bone.erase(bone.begin() + k);
+    bindX.erase(bindX.begin() + k); bindY.erase(bindY.begin() + k); bindZ.erase(bindZ.begin() + k);
+    x.erase(x.begin() + k);         y.erase(y.begin() + k);         z.erase(z.begin() + k);
+}
+
+// ---------------------------------------------------------
+// Simulation Core
+// ---------------------------------------------------------
+
+void ClothInstance::buildScene(int w, int h, const vec3& origin) {
+    // 1. Particle rest positions, top corners pinned (Hanging Cloth setup)
+    BuildScratch& scratch = buildScratch();
+    std::vector<vec3>& rest = scratch.rest;
+    rest.resize(w * h);
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            // Center the cloth horizontally
+            rest[y * w + x] = origin + vec3((x - (w - 1) * 0.5f) * spacing,
+                                            (h - 1 - y) * spacing,
+                                            0.0f);
+        }
+    }
+    scratch.pinned.assign({0, w - 1});
+    buildGrid(w, h, rest, scratch.pinned);
+}
+
+void ClothInstance::buildGrid(int w, int h, const std::vector<vec3>& rest, const std::vector<int>& pinned) {
+    gridW = w;
+    gridH = h;
+
+    P.clear();
+    P.resize(w * h);
+    localConstraints.clear();
+    localColorOffsets.clear();
+    lraConstraints.clear();
+    attachmentIndices.clear();
+    skin.clear();
+    sleep.clear();
+    local.clear();
+    triangles.clear();
+    sourceToParticle.clear();
+    tornEdges = 0;
+
+    // Exact sizes up front: a rebuild at the same resolution reuses every array as it is
+    const int numEdges = (w - 1) * h + w * (h - 1);
+    localConstraints.reserve(numEdges);
+    localColorOffsets.reserve(5);
+    triangles.reserve(6 * std::max(0, w - 1) * std::max(0, h - 1));
+    attachmentIndices.reserve(pinned.size());
+    for (int id : pinned) P.pinned[id] = 1;
+
+    // 1. Init Particles
+    for (int id = 0; id < w * h; ++id) {
+        Particle p;
+        p.p = rest[id];
+        p.old_p = p.p;
+        p.v = vec3(0.0f);
+        if (P.pinned[id]) {
+            p.w = 0.0f;
+            p.pinned = true;
+            attachmentIndices.push_back(id);
+        } else {
+            p.w = 1.0f;
+            p.pinned = false;
+        }
+        P.set(id, p);
+    }
+
+    // 2. Build Local Constraints (Grid edges)
+    // Emitted directly in 4 colour batches: horizontal even/odd x, vertical even/odd y.
+    // No two edges in a batch share a particle, so a batch can be projected in parallel.
+    auto addEdge = [&](int a, int b) {
+        float d = length(P.position(a) - P.position(b));
+        localConstraints.push_back({a, b, d, g_compliance});
+    };
+    localColorOffsets.push_back(0);
+    for (int parity = 0; parity < 2; ++parity) {
+        for (int y = 0; y < h; ++y) {
+            for (int x = parity; x + 1 < w; x += 2) addEdge(idx(x, y), idx(x + 1, y));
+        }
+        localColorOffsets.push_back((int)localConstraints.size());
+    }
+    for (int parity = 0; parity < 2; ++parity) {
+        for (int y = parity; y + 1 < h; y += 2) {
+            for (int x = 0; x < w; ++x) addEdge(idx(x, y), idx(x, y + 1));
+        }
+        localColorOffsets.push_back((int)localConstraints.size());
+    }
+
+    // 3. Triangles (two per grid cell), used by the geodesic pass and rendering
+    for (int y = 0; y + 1 < h; ++y) {
+        for (int x = 0; x + 1 < w; ++x) {
+            int i00 = idx(x, y), i10 = idx(x + 1, y), i01 = idx(x, y + 1), i11 = idx(x + 1, y + 1);
+            triangles.insert(triangles.end(), {i00, i01, i11, i00, i11, i10});
+        }
+    }
+
+    // 4. Build LRA Constraints
+    buildLRAConstraints();
+
+    if (g_optimizeLayout) optimizeLayout();
+}
+
+void ClothInstance::buildMesh(const std::vector<vec3>& rest, const std::vector<int>& tris, const std::vector<int>& pinned,
+                              bool bending) {
+    const int n = (int)rest.size();
+    gridW = 0;
+    gridH = 0;
+
+    P.clear();
+    P.resize(n);
+    localConstraints.clear();
+    localColorOffsets.clear();
+    lraConstraints.clear();
+    attachmentIndices.clear();
+    skin.clear();
+    sleep.clear();
+    local.clear();
+    sourceToParticle.clear();
+    tornEdges = 0;
+    triangles.assign(tris.begin(), tris.end());
+    attachmentIndices.reserve(pinned.size());
+    for (int id : pinned) P.pinned[id] = 1;
+
+    // 1. Init Particles
+    for (int id = 0; id < n; ++id) {
+        Particle p;
+        p.p = rest[id];
+        p.old_p = p.p;
+        p.v = vec3(0.0f);
+        p.pinned = P.pinned[id] != 0;
+        p.w = p.pinned ? 0.0f : 1.0f;
+        if (p.pinned) attachmentIndices.push_back(id);
+        P.set(id, p);
+    }
+
+    // 2. Edges: every triangle side once, keyed (min, max) so neighbours sharing it agree
+    BuildScratch& scratch = buildScratch();
+    std::vector<uint64_t>& keys = scratch.edgeKeys;
+    std::vector<std::pair<uint64_t, int>>& hinges = scratch.hinges;
+    auto key = [](int a, int b) { return ((uint64_t)(uint32_t)std::min(a, b) << 32) | (uint32_t)std::max(a, b); };
+    keys.clear();
+    hinges.clear();
+    for (size_t t = 0; t + 2 < triangles.size(); t += 3) {
+        for (int e = 0; e < 3; ++e) {
+            const int a = triangles[t + e], b = triangles[t + (e + 1) % 3], c = triangles[t + (e + 2) % 3];
+            keys.push_back(key(a, b));
+            if (bending) hinges.push_back({key(a, b), c});
+        }
+    }
+
+    // Bending: the opposite corners of each pair of triangles sharing a side. A distance across
+    // the hinge joins the geodesic graph too; on a flat rest shape it is the exact surface path.
+    if (bending) {
+        std::sort(hinges.begin(), hinges.end());
+        for (size_t b = 0, e; b < hinges.size(); b = e) {
+            for (e = b + 1; e < hinges.size() && hinges[e].first == hinges[b].first; ++e) {}
+            for (size_t u = b; u < e; ++u) {
+                for (size_t v = u + 1; v < e; ++v) {
+                    if (hinges[u].second != hinges[v].second) keys.push_back(key(hinges[u].second, hinges[v].second));
+                }
+            }
+        }
+    }
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+    localConstraints.reserve(keys.size());
+    for (uint64_t k : keys) {
+        const int a = (int)(k >> 32), b = (int)(uint32_t)k;
+        localConstraints.push_back({a, b, length(rest[a] - rest[b]), g_compliance});
+    }
+    colorConstraintsGreedy(localConstraints, n, localColorOffsets);
+
+    // 3. Build LRA Constraints
+    buildLRAConstraints();
+
+    if (g_optimizeLayout) optimizeLayout();
+}
+
+void ClothInstance::buildLRAConstraints() {
+    // One multi-source pass assigns each particle its nearest attachment along the surface
+    // and the geodesic rest distance to it (no flat-mesh assumption, O(E log V)).
+    geodesic.build(P, localConstraints, triangles);
+    geodesic.compute(attachmentIndices);
+
+    tethersPerParticle = std::max(1, g_lraTethers);
+    emitTethers();
+}
+
+void ClothInstance::setTethersPerParticle(int K) {
+    if (!geodesic.hasTopology()) geodesic.setTopology(localConstraints, triangles); // loaded from an asset
+    tethersPerParticle = std::max(1, K);
+    emitTethers();
+}
+
+void ClothInstance::setCompliance(float compliance) {
+    compliance = std::max(0.0f, compliance);
+    for (auto& c : localConstraints) c.compliance = compliance;
+    ++topologyVersion;
+}
+
+// Insert attachment s at distance di into a particle's K nearest (sorted, -1 = empty slot)
+static void insertNearest(int* a, float* d, int K, int s, float di) {
+    int k = K;
+    while (k > 0 && (a[k - 1] == -1 || d[k - 1] > di)) --k;
+    if (k == K) return;
+    for (int m = K - 1; m > k; --m) {
+        a[m] = a[m - 1];
+        d[m] = d[m - 1];
+    }
+    a[k] = s;
+    d[k] = di;
+}
+
+void ClothInstance::emitTethers() {
+    lraConstraints.clear();
+    ++topologyVersion;
+    const int n = (int)P.size();
+    lraOfParticle.assign(n, -1);
+
+    if (tethersPerParticle == 1) {
+        int numTethers = 0;
+        for (int i = 0; i < n; ++i) numTethers += (!P.pinned[i] && geodesic.anchorOf(i) != -1);
+        lraConstraints.reserve(numTethers);
+        for (int i = 0; i < n; ++i) {
+            if (P.pinned[i]) continue;
+
+            int anchor = geodesic.anchorOf(i);
+            if (anchor != -1) {
+                lraOfParticle[i] = (int)lraConstraints.size();
+                lraConstraints.push_back({i, anchor, geodesic.distanceOf(i)});
+            }
+        }
+        return;
+    }
+
+    // K nearest: one single-source pass per attachment on a copy of the field (same rest state
+    // and adjacency), keeping a sorted top-K per particle. O(A * E log V) for A attachments.
+    const int K = tethersPerParticle;
+    BuildScratch& scratch = buildScratch();
+    std::vector<int>& bestA = scratch.bestA;
+    std::vector<float>& bestD = scratch.bestD;
+    bestA.assign(size_t(n) * K, -1);
+    bestD.assign(size_t(n) * K, 0.0f);
+    GeodesicField& single = scratch.single;
+    single = geodesic;
+    for (int s : attachmentIndices) {
+        scratch.sources.assign(1, s);
+        single.compute(scratch.sources);
+        for (int i = 0; i < n; ++i) {
+            if (P.pinned[i] || single.anchorOf(i) == -1) continue;
+            insertNearest(&bestA[size_t(i) * K], &bestD[size_t(i) * K], K, s, single.distanceOf(i));
+        }
+    }
+
+    int numTethered = 0;
+    for (int i = 0; i < n; ++i) numTethered += (bestA[size_t(i) * K] != -1);
+    lraConstraints.reserve(size_t(numTethered) * K);
+    for (int i = 0; i < n; ++i) {
+        const int* a = &bestA[size_t(i) * K];
+        const float* d = &bestD[size_t(i) * K];
+        if (a[0] == -1) continue;
+        lraOfParticle[i] = (int)lraConstraints.size();
+        for (int k = 0, last = 0; k < K; ++k) {
+            if (a[k] != -1) last = k;
+            lraConstraints.push_back({i, a[last], d[last]});
+        }
+    }
+}
+
+void ClothInstance::updateLRAConstraints(const std::vector<int>& changed) {
+    ++topologyVersion;
+    for (int i : changed) {
+        int anchor = P.pinned[i] ? -1 : geodesic.anchorOf(i);
+        int k = lraOfParticle[i];
+
+        if (anchor != -1) {
+            LRAConstraint c = {i, anchor, geodesic.distanceOf(i)};
+            if (k != -1) {
+                lraConstraints[k] = c;
+            } else {
+                lraOfParticle[i] = (int)lraConstraints.size();
+                lraConstraints.push_back(c);
+            }
+        } else if (k != -1) {
+            // Swap-and-pop
+            int last = (int)lraConstraints.size() - 1;
+            lraConstraints[k] = lraConstraints[last];
+            lraOfParticle[lraConstraints[k].particleIdx] = k;
+            lraConstraints.pop_back();
+            lraOfParticle[i] = -1;
+        }
+    }
+}
+
+// K > 1 after a cut. A particle's K nearest can only change if one of its tethers' shortest
+// paths crossed the cut, and then so did the path of the particle it continued from with a
+// shorter tether to the same attachment. So `region` (the cut's ends and corners, plus what the
+// nearest field re-filled) is grown along rising tether lengths, and one pass per attachment
+// on its border, confined to the region, re-ranks it. Everything outside keeps its tethers.
+// Paths through a pinned border particle only count for its own attachment, so a re-ranked
+// distance can come out longer than a full emitTethers() would give, never shorter.
+void ClothInstance::retetherRegion(std::vector<int>& region) {
+    const int K = tethersPerParticle;
+    auto tethersOf = [this](int i) { return lraOfParticle[i] == -1 ? nullptr : &lraConstraints[lraOfParticle[i]]; };
+    region.erase(std::remove_if(region.begin(), region.end(), [this](int i) { return P.pinned[i] != 0; }), region.end());
+
+    BuildScratch& scratch = buildScratch();
+    std::vector<int>& border = scratch.border;
+    geodesic.growRegion(region, [&](int u, int v) {
+        const LRAConstraint* tu = tethersOf(u);
+        const LRAConstraint* tv = tethersOf(v);
+        if (P.pinned[v] || !tu || !tv) return false;
+        for (int a = 0; a < K; ++a) {
+            for (int b = 0; b < K; ++b) {
+                if (tv[b].attachmentIdx == tu[a].attachmentIdx && tv[b].maxDist > tu[a].maxDist) return true;
+            }
+        }
+        return false;
+    }, border);
+
+    std::vector<GeodesicField::RegionSeed>& seeds = scratch.seeds;
+    seeds.clear();
+    for (int b : border) {
+        if (P.pinned[b]) {
+            seeds.push_back({b, b, 0.0f});
+        } else if (const LRAConstraint* t = tethersOf(b)) {
+            for (int k = 0; k < K; ++k) {
+                if (k == 0 || t[k].attachmentIdx != t[k - 1].attachmentIdx) seeds.push_back({t[k].attachmentIdx, b, t[k].maxDist});
+            }
+        }
+    }
+    std::sort(seeds.begin(), seeds.end());
+
+    const int r = (int)region.size();
+    std::vector<int>& bestA = scratch.bestA;
+    std::vector<float>& bestD = scratch.bestD;
+    bestA.assign(size_t(r) * K, -1);
+    bestD.assign(size_t(r) * K, 0.0f);
+    geodesic.regionPasses(region, border, seeds, [&](int s) {
+        for (int k = 0; k < r; ++k) {
+            if (geodesic.anchorOf(region[k]) != s) continue;
+            insertNearest(&bestA[size_t(k) * K], &bestD[size_t(k) * K], K, s, geodesic.distanceOf(region[k]));
+        }
+    });
+
+    // Overwrite, append or swap-and-pop each region particle's K-slot block
+    ++topologyVersion;
+    for (int k = 0; k < r; ++k) {
+        const int i = region[k];
+        const int* a = &bestA[size_t(k) * K];
+        const float* d = &bestD[size_t(k) * K];
+        int first = lraOfParticle[i];
+        if (a[0] != -1) {
+            if (first == -1) {
+                first = (int)lraConstraints.size();
+                lraOfParticle[i] = first;
+                lraConstraints.resize(lraConstraints.size() + K);
+            }
+            for (int m = 0, last = 0; m < K; ++m) {
+                if (a[m] != -1) last = m;
+                lraConstraints[first + m] = {i, a[last], d[last]};
+            }
+        } else if (first != -1) {
+            const int last = (int)lraConstraints.size() - K;
+            if (first != last) {
+                std::copy(lraConstraints.begin() + last, lraConstraints.end(), lraConstraints.begin() + first);
+                lraOfParticle[lraConstraints[first].particleIdx] = first;
+            }
+            lraConstraints.resize(last);
+            lraOfParticle[i] = -1;
+        }
+    }
+}
+
+void ClothInstance::optimizeLayout() {
+    wake(); // tiles are index ranges; the permutation would scatter them
+    const int n = (int)P.size();
+    BuildScratch& scratch = buildScratch();
+    std::vector<int>& order = scratch.order;
+    std::vector<int>& newOf = scratch.newOf;
+    mortonOrder(P, order); // order[new] = old
+    ++topologyVersion;
+    newOf.resize(n);
+    for (int k = 0; k < n; ++k) newOf[order[k]] = k;
+
+    permuteParticles(P, order);
+
+    // Edges: remap, then sort inside each colour batch so the sweep walks memory forwards.
+    // Reordering within a batch never breaks the colouring.
+    for (auto& c : localConstraints) {
+        c.i = newOf[c.i];
+        c.j = newOf[c.j];
+        if (c.i > c.j) std::swap(c.i, c.j);
+    }
+    for (size_t b = 0; b + 1 < localColorOffsets.size(); ++b) {
+        std::sort(localConstraints.begin() + localColorOffsets[b], localConstraints.begin() + localColorOffsets[b + 1],
+                  [](const LocalConstraint& a, const LocalConstraint& c) { return a.i < c.i || (a.i == c.i && a.j < c.j); });
+    }
+
+    for (int& t : triangles) t = newOf[t];
+    for (int& a : attachmentIndices) a = newOf[a];
+
+    // LRA: grouped by anchor so the anchor position stays in cache, particles ascending.
+    // K > 1 keeps each particle's tethers together (and nearest first) instead.
+    for (auto& c : lraConstraints) {
+        c.particleIdx = newOf[c.particleIdx];
+        c.attachmentIdx = newOf[c.attachmentIdx];
+    }
+    if (tethersPerParticle == 1) {
+        std::sort(lraConstraints.begin(), lraConstraints.end(), [](const LRAConstraint& a, const LRAConstraint& b) {
+            return a.attachmentIdx < b.attachmentIdx || (a.attachmentIdx == b.attachmentIdx && a.particleIdx < b.particleIdx);
+        });
+    } else {
+        // A particle's tethers are nearest first, so ordering by length keeps them in place
+        // (std::stable_sort would need a temporary buffer)
+        std::sort(lraConstraints.begin(), lraConstraints.end(), [](const LRAConstraint& a, const LRAConstraint& b) {
+            return a.particleIdx < b.particleIdx || (a.particleIdx == b.particleIdx && a.maxDist < b.maxDist);
+        });
+    }
+    lraOfParticle.assign(n, -1);
+    for (int k = 0; k < (int)lraConstraints.size(); k += tethersPerParticle) {
+        lraOfParticle[lraConstraints[k].particleIdx] = k;
+    }
+
+    geodesic.remap(newOf, localConstraints, triangles);
+
+    // Compose with any earlier permutation
+    if (sourceToParticle.empty()) {
+        sourceToParticle = newOf;
+    } else {
+        for (int& k : sourceToParticle) k = newOf[k];
+    }
+}
+
+void ClothInstance::addAttachment(int i) {
+    if (P.pinned[i]) return;
+    wakeParticle(i);
+
+    // Pinned where it currently is, with zero velocity
+    P.pinned[i] = 1;
+    P.w[i] = 0.0f;
+    P.vx[i] = P.vy[i] = P.vz[i] = 0.0f;
+    P.px[i] = P.x[i]; P.py[i] = P.y[i]; P.pz[i] = P.z[i];
+    attachmentIndices.push_back(i);
+    if (!skin.empty()) skin.push(-1, P.x[i], P.y[i], P.z[i]);
+
+    std::vector<int> changed;
+    if (!geodesic.hasTopology()) geodesic.setTopology(localConstraints, triangles); // loaded from an asset
+    geodesic.addSource(i, changed);
+    if (tethersPerParticle == 1) updateLRAConstraints(changed);
+    else emitTethers();
+}
+
+void ClothInstance::removeAttachment(int i) {
+    auto it = std::find(attachmentIndices.begin(), attachmentIndices.end(), i);
+    if (it == attachmentIndices.end()) return;
+    if (!skin.empty()) skin.erase(it - attachmentIndices.begin());
+    attachmentIndices.erase(it);
+    wakeParticle(i);
+
+    P.pinned[i] = 0;
+    P.w[i] = 1.0f;
+
+    std::vector<int> changed;
+    if (!geodesic.hasTopology()) geodesic.setTopology(localConstraints, triangles);
+    geodesic.removeSource(i, changed);
+    if (tethersPerParticle == 1) updateLRAConstraints(changed);
+    else emitTethers();
+}
+
+void ClothInstance::bindAttachments(const std::vector<int>& bones) {
+    skin.clear();
+    for (size_t k = 0; k < attachmentIndices.size(); ++k) {
+        const int i = attachmentIndices[k];
+        skin.push(k < bones.size() ? bones[k] : -1, P.x[i], P.y[i], P.z[i]);
+    }
+}
+
+void ClothInstance::skinAttachments(const glm::mat4* palette, int numBones) {
+    const int n = (int)skin.size();
+    for (int k = 0; k < n; ++k) {
+        const int b = skin.bone[k];
+        if (b < 0 || b >= numBones) continue;
+        const glm::mat4& m = palette[b];
+        const float x = skin.bindX[k], y = skin.bindY[k], z = skin.bindZ[k];
+        skin.x[k] = m[0][0] * x + m[1][0] * y + m[2][0] * z + m[3][0];
+        skin.y[k] = m[0][1] * x + m[1][1] * y + m[2][1] * z + m[3][1];
+        skin.z[k] = m[0][2] * x + m[1][2] * y + m[2][2] * z + m[3][2];
+    }
+    skin.moved = n > 0;
+}
+
+// Move every anchor 1 / remaining of the way to its target, so `remaining` calls land on it.
+// Anchors get the matching velocity, which a particle keeps if it is released later.
+void ClothInstance::sweepAnchors(float h, int remaining) {
+    float* X = P.x.data();   float* Y = P.y.data();   float* Z = P.z.data();
+    float* PX = P.px.data(); float* PY = P.py.data(); float* PZ = P.pz.data();
+    float* VX = P.vx.data(); float* VY = P.vy.data(); float* VZ = P.vz.data();
+
+    const float t = 1.0f / remaining;
+    const float invH = 1.0f / h;
+    for (size_t k = 0; k < skin.size(); ++k) {
+        const int i = attachmentIndices[k];
+        float dx = (skin.x[k] - X[i]) * t, dy = (skin.y[k] - Y[i]) * t, dz = (skin.z[k] - Z[i]) * t;
+        PX[i] = X[i];       PY[i] = Y[i];       PZ[i] = Z[i];
+        X[i] += dx;         Y[i] += dy;         Z[i] += dz;
+        VX[i] = dx * invH;  VY[i] = dy * invH;  VZ[i] = dz * invH;
+    }
+}
+
+// Projection for Local Constraints (XPBD, Macklin et al. 2016)
+// Pinned particles have w == 0, so their share of the correction is zero.
+// Raw-pointer form so the loops over many edges keep the arrays in registers.
+// Compliant: dlambda = -(C + a * lambda) / (wSum + a) with a = compliance / h^2, accumulated in
+// `lambda` over the substep. A rigid edge (a = 0) takes the PBD step -C / wSum and keeps no
+// multiplier (the GPU kernel does the same), and rigid cloths skip the multipliers altogether.
+template <bool Compliant>
+static inline float projectEdge(float* X, float* Y, float* Z, const float* W, const LocalConstraint& c,
+                                float* lambda, float invH2) {
+    // Both ends pinned or asleep: nothing can move
+    float wSum = W[c.i] + W[c.j];
+    if (wSum < 1e-6f) return 0.0f;
+
+    float dx = X[c.i] - X[c.j];
+    float dy = Y[c.i] - Y[c.j];
+    float dz = Z[c.i] - Z[c.j];
+    float dist = std::sqrt(dx * dx + dy * dy + dz * dz);
+    if (dist < 1e-6f) return 0.0f;
+
+    const float violation = dist - c.restLen;
+    float dl;
+    if (Compliant && c.compliance > 0.0f) {
+        const float a = c.compliance * invH2;
+        dl = -(violation + a * *lambda) / (wSum + a);
+        *lambda += dl;
+    } else {
+        dl = -violation / wSum;
+    }
+
+    // dp_i = w_i * dlambda * grad, grad = dir / dist
+    float s = dl / dist;
+    float s1 =  s * W[c.i];
+    float s2 = -s * W[c.j];
+
+    X[c.i] += dx * s1; Y[c.i] += dy * s1; Z[c.i] += dz * s1;
+    X[c.j] += dx * s2; Y[c.j] += dy * s2; Z[c.j] += dz * s2;
+    return violation;
+}
+
+float projectLocal(ParticleStore& P, const LocalConstraint& c) {
+    return projectEdge<false>(P.x.data(), P.y.data(), P.z.data(), P.w.data(), c, nullptr, 0.0f);
+}
+
+// Projection for LRA (The Core Algorithm)
+void projectLRA(ParticleStore& P, const LRAConstraint& c, float slack) {
+    float* X = P.x.data();
+    float* Y = P.y.data();
+    float* Z = P.z.data();
+    const int i = c.particleIdx;
+    const int a = c.attachmentIdx;
+
+    float dx = X[i] - X[a];
+    float dy = Y[i] - Y[a];
+    float dz = Z[i] - Z[a];
+    float currentDist = std::sqrt(dx * dx + dy * dy + dz * dz);
+    
+    // Apply Slack (Controlled Stretchiness, Section 3.5)
+    float limit = c.maxDist * slack;
+
+    // Unilateral Constraint: Only project if stretched beyond limit
+    if (currentDist > limit) {
+        if (currentDist < 1e-6f) return; 
+        
+        // Project back to the surface of the sphere
+        // p_new = center + dir * limit
+        float s = limit / currentDist;
+        X[i] = X[a] + dx * s;
+        Y[i] = Y[a] + dy * s;
+        Z[i] = Z[a] + dz * s;
+    }
+}
+
+int colorConstraintsGreedy(std::vector<LocalConstraint>& cs, int numParticles, std::vector<int>& offsets) {
+    // used[p] holds the colours already taken by edges touching particle p
+    std::vector<std::vector<int>> used(numParticles);
+    std::vector<int> color(cs.size());
+    int numColors = 0;
+
+    for (size_t k = 0; k < cs.size(); ++k) {
+        const auto& ui = used[cs[k].i];
+        const auto& uj = used[cs[k].j];
+        int c = 0;
+        while (std::find(ui.begin(), ui.end(), c) != ui.end() ||
+               std::find(uj.begin(), uj.end(), c) != uj.end()) {
+            ++c;
+        }
+        color[k] = c;
+        used[cs[k].i].push_back(c);
+        used[cs[k].j].push_back(c);
+        numColors = std::max(numColors, c + 1);
+    }
+
+    // Counting sort by colour (stable)
+    offsets.assign(numColors + 1, 0);
+    for (int c : color) offsets[c + 1]++;
+    for (int c = 0; c < numColors; ++c) offsets[c + 1] += offsets[c];
+
+    std::vector<LocalConstraint> sorted(cs.size());
+    std::vector<int> cursor(offsets.begin(), offsets.end() - 1);
+    for (size_t k = 0; k < cs.size(); ++k) {
+        sorted[cursor[color[k]]++] = cs[k];
+    }
+    cs.swap(sorted);
+    return numColors;
+}
+
+// Grain sizes for the parallel passes (constraints per task)
+static const int kLocalGrain = 512;
+static const int kLRAGrain = 1024;
+
+// Edges [b, e), projected in order
+template <bool Compliant>
+static void projectLocalRange(ClothInstance& cloth, int b, int e) {
+    float* X = cloth.P.x.data(); float* Y = cloth.P.y.data(); float* Z = cloth.P.z.data();
+    const float* W = cloth.P.w.data();
+    const LocalConstraint* cs = cloth.localConstraints.data();
+    float* lambda = Compliant ? cloth.local.lambda.data() : nullptr;
+    const float invH2 = cloth.local.invH2;
+    for (int k = b; k < e; ++k) projectEdge<Compliant>(X, Y, Z, W, cs[k], lambda + (Compliant ? k : 0), invH2);
+}
+
+static void projectLocalRange(ClothInstance& cloth, int b, int e) {
+    if (cloth.local.compliant) projectLocalRange<true>(cloth, b, e);
+    else projectLocalRange<false>(cloth, b, e);
+}
+
+static void projectLocalColored(ClothInstance& cloth) {
+    ThreadPool& pool = solverPool();
+    const std::function<void(int, int)> fn = [&cloth](int b, int e) {
+        projectLocalRange(cloth, b, e);
+    };
+    for (size_t c = 0; c + 1 < cloth.localColorOffsets.size(); ++c) {
+        pool.parallelFor(cloth.localColorOffsets[c], cloth.localColorOffsets[c + 1], kLocalGrain, fn);
+    }
+}
+
+// Relative error of edges [b, e), projected in order: running max and sum of squares
+template <bool Compliant>
+static void projectLocalRangeMeasured(ClothInstance& cloth, int b, int e, float& maxError, double& sumSq) {
+    float* X = cloth.P.x.data(); float* Y = cloth.P.y.data(); float* Z = cloth.P.z.data();
+    const float* W = cloth.P.w.data();
+    const LocalConstraint* cs = cloth.localConstraints.data();
+    float* lambda = Compliant ? cloth.local.lambda.data() : nullptr;
+    const float invH2 = cloth.local.invH2;
+    float m = 0.0f, sq = 0.0f;
+    for (int k = b; k < e; ++k) {
+        float err = projectEdge<Compliant>(X, Y, Z, W, cs[k], lambda + (Compliant ? k : 0), invH2) / cs[k].restLen;
+        m = std::max(m, std::fabs(err));
+        sq += err * err;
+    }
+    maxError = std::max(maxError, m);
+    sumSq += sq;
+}
+
+static void projectLocalRangeMeasured(ClothInstance& cloth, int b, int e, float& maxError, double& sumSq) {
+    if (cloth.local.compliant) projectLocalRangeMeasured<true>(cloth, b, e, maxError, sumSq);
+    else projectLocalRangeMeasured<false>(cloth, b, e, maxError, sumSq);
+}
+
+// Colour batches in parallel; each chunk reduces into its own slot so no locking is needed
+static void projectLocalColoredMeasured(ClothInstance& cloth, float& maxError, double& sumSq) {
+    ThreadPool& pool = solverPool();
+    std::vector<float>& chunkMax = cloth.local.chunkMax;  // reused: measured passes never allocate
+    std::vector<double>& chunkSq = cloth.local.chunkSq;
+    for (size_t c = 0; c + 1 < cloth.localColorOffsets.size(); ++c) {
+        const int begin = cloth.localColorOffsets[c], end = cloth.localColorOffsets[c + 1];
+        const int chunks = (end - begin + kLocalGrain - 1) / kLocalGrain;
+        chunkMax.assign(chunks, 0.0f);
+        chunkSq.assign(chunks, 0.0);
+        pool.parallelFor(begin, end, kLocalGrain, [&](int b, int e) {
+            const int slot = (b - begin) / kLocalGrain;
+            projectLocalRangeMeasured(cloth, b, e, chunkMax[slot], chunkSq[slot]);
+        });
+        for (int k = 0; k < chunks; ++k) {
+            maxError = std::max(maxError, chunkMax[k]);
+            sumSq += chunkSq[k];
+        }
+    }
+}
+
+// Jacobi: every edge is solved against the positions at the start of the pass, then each
+// particle moves by the sum of its edges' corrections. A correction is scaled by jacobiRelaxation
+// over the larger degree of its two ends, so no particle moves further than the relaxed average
+// of its edges, and the multiplier accumulates exactly the share that was applied (the compliant
+// fixed point matches the Gauss-Seidel one). Each half only writes its own edges or particles,
+// so both split across solverPool() with no colouring.
+static const int kParticleGrain = 1024;
+
+template <bool Compliant, bool Measure>
+static void jacobiEdges(ClothInstance& cloth, int b, int e, float& maxError, double& sumSq) {
+    const float* X = cloth.P.x.data(); const float* Y = cloth.P.y.data(); const float* Z = cloth.P.z.data();
+    const float* W = cloth.P.w.data();
+    const LocalConstraint* cs = cloth.localConstraints.data();
+    LocalSolveState& s = cloth.local;
+    float* CX = s.cx.data(); float* CY = s.cy.data(); float* CZ = s.cz.data();
+    float* lambda = s.lambda.data();
+    const int* offsets = s.vertexOffsets.data();
+    const float omega = cloth.params.jacobiRelaxation;
+    float m = 0.0f, sq = 0.0f;
+    for (int k = b; k < e; ++k) {
+        const LocalConstraint& c = cs[k];
+        CX[k] = CY[k] = CZ[k] = 0.0f;
+        const float wSum = W[c.i] + W[c.j];
+        if (wSum < 1e-6f) continue;
+        const float dx = X[c.i] - X[c.j], dy = Y[c.i] - Y[c.j], dz = Z[c.i] - Z[c.j];
+        const float dist = std::sqrt(dx * dx + dy * dy + dz * dz);
+        if (dist < 1e-6f) continue;
+
+        const float violation = dist - c.restLen;
+        const int degree = std::max(offsets[c.i + 1] - offsets[c.i], offsets[c.j + 1] - offsets[c.j]);
+        const float scale = omega / degree;
+        float dl;
+        if (Compliant && c.compliance > 0.0f) {
+            const float a = c.compliance * s.invH2;
+            dl = -(violation + a * lambda[k]) / (wSum + a) * scale;
+            lambda[k] += dl;
+        } else {
+            dl = -violation / wSum * scale;
+        }
+        const float f = dl / dist;
+        CX[k] = dx * f; CY[k] = dy * f; CZ[k] = dz * f;
+        if (Measure) {
+            const float err = violation / c.restLen;
+            m = std::max(m, std::fabs(err));
+            sq += err * err;
+        }
+    }
+    if (Measure) {
+        maxError = std::max(maxError, m);
+        sumSq += sq;
+    }
+}
+
+static void jacobiParticles(ClothInstance& cloth, int b, int e) {
+    float* X = cloth.P.x.data(); float* Y = cloth.P.y.data(); float* Z = cloth.P.z.data();
+    const float* W = cloth.P.w.data();
+    const LocalSolveState& s = cloth.local;
+    const float* CX = s.cx.data(); const float* CY = s.cy.data(); const float* CZ = s.cz.data();
+    const int* offsets = s.vertexOffsets.data();
+    const int* edges = s.vertexEdges.data();
+    for (int i = b; i < e; ++i) {
+        if (W[i] == 0.0f || offsets[i] == offsets[i + 1]) continue;
+        float sx = 0.0f, sy = 0.0f, sz = 0.0f;
+        for (int q = offsets[i]; q < offsets[i + 1]; ++q) {
+            const int k = edges[q];
+            if (k >= 0) { sx += CX[k];  sy += CY[k];  sz += CZ[k]; }
+            else        { sx -= CX[~k]; sy -= CY[~k]; sz -= CZ[~k]; }
+        }
+        X[i] += sx * W[i]; Y[i] += sy * W[i]; Z[i] += sz * W[i];
+    }
+}
+
+template <bool Compliant>
+static void projectLocalJacobi(ClothInstance& cloth, bool measure, float& maxError, double& sumSq) {
+    ThreadPool& pool = solverPool();
+    LocalSolveState& s = cloth.local;
+    const int m = (int)cloth.localConstraints.size();
+    if (measure) {
+        // Each chunk reduces into its own slot, as in projectLocalColoredMeasured()
+        const int chunks = (m + kLocalGrain - 1) / kLocalGrain;
+        s.chunkMax.assign(chunks, 0.0f);
+        s.chunkSq.assign(chunks, 0.0);
+        pool.parallelFor(0, m, kLocalGrain, [&cloth](int b, int e) {
+            const int slot = b / kLocalGrain;
+            jacobiEdges<Compliant, true>(cloth, b, e, cloth.local.chunkMax[slot], cloth.local.chunkSq[slot]);
+        });
+        for (int k = 0; k < chunks; ++k) {
+            maxError = std::max(maxError, s.chunkMax[k]);
+            sumSq += s.chunkSq[k];
+        }
+    } else {
+        pool.parallelFor(0, m, kLocalGrain, [&cloth](int b, int e) {
+            float unusedMax;
+            double unusedSq;
+            jacobiEdges<Compliant, false>(cloth, b, e, unusedMax, unusedSq);
+        });
+    }
+    pool.parallelFor(0, (int)cloth.P.size(), kParticleGrain, [&cloth](int b, int e) {
+        jacobiParticles(cloth, b, e);
+    });
+}
+
+static void projectLocalJacobi(ClothInstance& cloth, bool measure, float& maxError, double& sumSq) {
+    if (cloth.local.compliant) projectLocalJacobi<true>(cloth, measure, maxError, sumSq);
+    else projectLocalJacobi<false>(cloth, measure, maxError, sumSq);
+}
+
+// Edges around every particle, for the gather half of the Jacobi pass
+static void buildJacobiGather(ClothInstance& cloth) {
+    LocalSolveState& s = cloth.local;
+    const int n = (int)cloth.P.size();
+    const int m = (int)cloth.localConstraints.size();
+    s.cx.resize(m); s.cy.resize(m); s.cz.resize(m);
+    s.vertexOffsets.assign(n + 1, 0);
+    for (const auto& c : cloth.localConstraints) {
+        ++s.vertexOffsets[c.i + 1];
+        ++s.vertexOffsets[c.j + 1];
+    }
+    for (int i = 0; i < n; ++i) s.vertexOffsets[i + 1] += s.vertexOffsets[i];
+    std::vector<int>& cursor = buildScratch().cursor;
+    cursor.assign(s.vertexOffsets.begin(), s.vertexOffsets.end() - 1);
+    s.vertexEdges.resize(2 * m);
+    for (int k = 0; k < m; ++k) {
+        s.vertexEdges[cursor[cloth.localConstraints[k].i]++] = k;
+        s.vertexEdges[cursor[cloth.localConstraints[k].j]++] = ~k;
+    }
+    s.jacobiVersion = cloth.topologyVersion;
+}
+
+void LocalSolveState::clear() {
+    lambda.clear();
+    cx.clear(); cy.clear(); cz.clear();
+    vertexOffsets.clear();
+    vertexEdges.clear();
+    compliant = false;
+    version = ~0u;
+    jacobiVersion = ~0u;
+}
+
+// Tethered particles [b, e): constraints [b * K, e * K)
+static void projectLRARange(ClothInstance& cloth, int b, int e) {
+    const int K = cloth.tethersPerParticle;
+    const LRAConstraint* c = cloth.lraConstraints.data();
+    const float slack = cloth.params.lraSlack;
+    if (cloth.params.lraSimd) {
+        if (K == 1) projectLRASimd(cloth.P, c + b, e - b, slack);
+        else projectLRATethersSimd(cloth.P, c + b * K, e - b, K, slack);
+    } else {
+        for (int k = b * K; k < e * K; ++k) projectLRA(cloth.P, c[k], slack);
+    }
+}
+
+static void projectLRAParallel(ClothInstance& cloth) {
+    const std::function<void(int, int)> fn = [&cloth](int b, int e) {
+        projectLRARange(cloth, b, e);
+    };
+    const int K = cloth.tethersPerParticle;
+    solverPool().parallelFor(0, (int)cloth.lraConstraints.size() / K, std::max(1, kLRAGrain / K), fn);
+}
+
+void ClothInstance::simulate() {
+    applyCommands();
+
+    // "Small steps": split dt into substeps and keep the per-step drag the same
+    const int substeps = std::max(1, params.substeps);
+    const float h = dt / substeps;
+    const float damping = (substeps == 1) ? 0.99f : std::pow(0.99f, 1.0f / substeps);
+    lastSolve = SolveStats();
+    if (!canSleep() && sleep.numAsleep > 0) wake();
+
+    // Anchors about to move pull on their tethered particles anywhere in the cloth
+    if (skin.moved && sleep.numAsleep > 0) {
+        for (size_t k = 0; k < skin.size(); ++k) {
+            const int i = attachmentIndices[k];
+            if (skin.x[k] != P.x[i] || skin.y[k] != P.y[i] || skin.z[k] != P.z[i]) {
+                wake();
+                break;
+            }
+        }
+    }
+
+    // Everything at rest: nothing to integrate or project
+    if (sleep.numAsleep > 0 && sleep.numAsleep == (int)sleep.awake.size()) {
+        skin.moved = false;
+        return;
+    }
+
+    for (int s = 0; s < substeps; ++s) {
+        if (skin.moved) sweepAnchors(h, substeps - s);
+        substep(h, damping);
+    }
+    skin.moved = false;
+    updateSleep();
+}
+
+void ClothInstance::relax(int iterations) {
+    beginLocalSolve(dt);
+    for (int iter = 0; iter < iterations; ++iter) {
+        projectLocalPass();
+        if (params.useLRA) projectLRAPass();
+    }
+}
+
+void ClothInstance::substep(float h, float damping) {
+    // 1. Explicit Euler Integration (Prediction), after the wind has acted on the velocities
+    if (wind.active()) applyWindPass(h);
+    integrate(h);
+
+    // Collision broadphase and self-collision hash on the predicted positions
+    const bool collide = params.selfCollision || !colliders.empty();
+    if (collide) {
+        LRA_PROFILE_SCOPE(PHASE_COLLIDE);
+        collision.begin(P, colliders, params.collisionThickness, params.selfCollision,
+                        (geodesic.size() == (int)P.size()) ? geodesic.restData() : nullptr);
+    }
+
+    // 2. Constraint Projection (XPBD multipliers start from zero every substep)
+    beginLocalSolve(h);
+    // Adaptive: the local pass measures the error it is about to correct and the substep ends
+    // once that is below tolerance. A settled cloth stops after an iteration or two and drifts
+    // up to the tolerance; fast motion runs more iterations, up to the cap. Only every other
+    // pass is measured, which halves the monitor's cost and stops at most one iteration late.
+    const bool adaptive = (params.iterationMode == ITERATIONS_ADAPTIVE);
+    const int maxIters = adaptive ? std::max(1, params.maxIterations) : params.iterations;
+    for (int iter = 0; iter < maxIters; ++iter) {
+        const bool measure = adaptive && (iter % 2 == 0);
+        
+        // (A) Local Constraints (Edges)
+        // Maintain local shape / wrinkles
+        if (measure) projectLocalMeasured(lastSolve.maxError, lastSolve.rmsError);
+        else projectLocalPass();
+
+        // (B) LRA Constraints (Global Inextensibility)
+        // Enforce global length limits immediately
+        if (params.useLRA) {
+            projectLRAPass();
+        }
+
+        // (C) Collisions last, so each iteration ends out of the bodies; they only push
+        // outward, which the unilateral tethers never resist
+        if (collide && collision.active()) projectCollisionPass();
+
+        ++lastSolve.iterations;
+        if (measure && lastSolve.rmsError < params.iterationTolerance) break;
+    }
+
+    // Edges the solve could not bring back within the limit give way
+    if (params.tearStrain > 0.0f) tear(params.tearStrain);
+
+    // 3. Velocity Update & Damping
+    updateVelocities(h, damping);
+}
+
+void ClothInstance::integrate(float h) {
+    LRA_PROFILE_SCOPE(PHASE_INTEGRATE);
+    const int n = (int)P.size();
+    float* X = P.x.data();   float* Y = P.y.data();   float* Z = P.z.data();
+    float* PX = P.px.data(); float* PY = P.py.data(); float* PZ = P.pz.data();
+    float* VX = P.vx.data(); float* VY = P.vy.data(); float* VZ = P.vz.data();
+    const unsigned char* pinned = P.pinned.data();
+    const unsigned char* awake = sleep.numAsleep ? sleep.awake.data() : nullptr;
+
+    for (int b = 0; b < n; b += kSleepTile) {
+        if (awake && !awake[b >> kSleepTileShift]) continue;
+        const int e = std::min(n, b + kSleepTile);
+        for (int i = b; i < e; ++i) {
+            if (pinned[i]) continue;
+            VX[i] += g.x * h; VY[i] += g.y * h; VZ[i] += g.z * h;
+            PX[i] = X[i];     PY[i] = Y[i];     PZ[i] = Z[i];
+            X[i] += VX[i] * h; Y[i] += VY[i] * h; Z[i] += VZ[i] * h;
+        }
+    }
+}
+
+void ClothInstance::beginLocalSolve(float h) {
+    if (local.version != topologyVersion) {
+        local.compliant = std::any_of(localConstraints.begin(), localConstraints.end(),
+                                      [](const LocalConstraint& c) { return c.compliance > 0.0f; });
+        local.version = topologyVersion;
+    }
+    local.invH2 = 1.0f / (h * h);
+    if (local.compliant) local.lambda.assign(localConstraints.size(), 0.0f);
+    if (params.solverMode == SOLVER_JACOBI && local.jacobiVersion != topologyVersion) buildJacobiGather(*this);
+}
+
+void ClothInstance::projectLocalPass() {
+    LRA_PROFILE_SCOPE(PHASE_LOCAL);
+    if (params.solverMode == SOLVER_COLORED_PARALLEL) {
+        projectLocalColored(*this);
+    } else if (params.solverMode == SOLVER_JACOBI) {
+        float m = 0.0f;
+        double sumSq = 0.0;
+        projectLocalJacobi(*this, false, m, sumSq);
+    } else {
+        projectLocalRange(*this, 0, (int)localConstraints.size());
+    }
+}
+
+void ClothInstance::projectLocalMeasured(float& maxError, float& rmsError) {
+    LRA_PROFILE_SCOPE(PHASE_LOCAL);
+    float m = 0.0f;
+    double sumSq = 0.0;
+    const int n = (int)localConstraints.size();
+    if (params.solverMode == SOLVER_COLORED_PARALLEL) projectLocalColoredMeasured(*this, m, sumSq);
+    else if (params.solverMode == SOLVER_JACOBI) projectLocalJacobi(*this, true, m, sumSq);
+    else projectLocalRangeMeasured(*this, 0, n, m, sumSq);
+    maxError = m;
+    rmsError = n ? (float)std::sqrt(sumSq / n) : 0.0f;
+}
+
+void ClothInstance::projectLRAPass() {
+    LRA_PROFILE_SCOPE(PHASE_LRA);
+    if (params.solverMode != SOLVER_GAUSS_SEIDEL) {
+        projectLRAParallel(*this);
+    } else {
+        projectLRARange(*this, 0, (int)lraConstraints.size() / tethersPerParticle);
+    }
+}
+
+void ClothInstance::applyWindPass(float h) {
+    LRA_PROFILE_SCOPE(PHASE_AERO);
+    if (aero.version != topologyVersion) {
+        // A torn grid is no longer a full grid: the scalar path walks the surviving triangles
+        aero.build((int)P.size(), tornEdges ? 0 : gridW, gridH, sourceToParticle, triangles,
+                   (geodesic.size() == (int)P.size()) ? geodesic.restData() : nullptr, P);
+        aero.version = topologyVersion;
+    }
+    aero.apply(wind, P, h);
+}
+
+void ClothInstance::projectCollisionPass() {
+    LRA_PROFILE_SCOPE(PHASE_COLLIDE);
+    collision.project(P);
+}
+
+void ClothInstance::updateVelocities(float h, float damping) {
+    LRA_PROFILE_SCOPE(PHASE_VELOCITY);
+    const int n = (int)P.size();
+    const float* X = P.x.data();   const float* Y = P.y.data();   const float* Z = P.z.data();
+    const float* PX = P.px.data(); const float* PY = P.py.data(); const float* PZ = P.pz.data();
+    float* VX = P.vx.data(); float* VY = P.vy.data(); float* VZ = P.vz.data();
+    const unsigned char* pinned = P.pinned.data();
+    const unsigned char* awake = sleep.numAsleep ? sleep.awake.data() : nullptr;
+
+    const float invH = 1.0f / h;
+    for (int b = 0; b < n; b += kSleepTile) {
+        if (awake && !awake[b >> kSleepTileShift]) continue;
+        const int e = std::min(n, b + kSleepTile);
+        for (int i = b; i < e; ++i) {
+            if (pinned[i]) continue;
+            VX[i] = (X[i] - PX[i]) * invH * damping; // Simple drag
+            VY[i] = (Y[i] - PY[i]) * invH * damping;
+            VZ[i] = (Z[i] - PZ[i]) * invH * damping;
+        }
+    }
+}
+
+// ---------------------------------------------------------
+// Tearing
+// ---------------------------------------------------------
+
+int ClothInstance::tear(float strain) {
+    LRA_PROFILE_SCOPE(PHASE_LOCAL);
+    const float* X = P.x.data(); const float* Y = P.y.data(); const float* Z = P.z.data();
+    const LocalConstraint* cs = localConstraints.data();
+    const int m = (int)localConstraints.size();
+    const float limit = 1.0f + strain;
+    std::vector<int>& torn = local.torn;
+    torn.clear();
+    for (int k = 0; k < m; ++k) {
+        const LocalConstraint& c = cs[k];
+        const float dx = X[c.i] - X[c.j], dy = Y[c.i] - Y[c.j], dz = Z[c.i] - Z[c.j];
+        const float maxLen = c.restLen * limit;
+        if (dx * dx + dy * dy + dz * dz > maxLen * maxLen) torn.push_back(k);
+    }
+    if (torn.empty()) return 0;
+    cutEdges(torn);
+    return (int)torn.size();
+}
+
+void ClothInstance::cutEdges(std::vector<int>& edges) {
+    const int m = (int)localConstraints.size();
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+    edges.erase(std::remove_if(edges.begin(), edges.end(), [m](int k) { return k < 0 || k >= m; }), edges.end());
+    if (edges.empty()) return;
+    if (!geodesic.hasTopology()) geodesic.setTopology(localConstraints, triangles); // loaded from an asset
+
+    std::vector<LocalConstraint>& cut = local.cut;
+    cut.clear();
+    for (int k : edges) {
+        const LocalConstraint& c = localConstraints[k];
+        wakeParticle(c.i);
+        wakeParticle(c.j);
+        cut.push_back(c);
+    }
+
+    // Triangles with a cut side go too, so none spans the tear (rendering, geodesic, wind)
+    std::vector<uint64_t>& keys = buildScratch().edgeKeys;
+    auto key = [](int a, int b) { return ((uint64_t)(uint32_t)std::min(a, b) << 32) | (uint32_t)std::max(a, b); };
+    keys.clear();
+    for (const LocalConstraint& c : cut) keys.push_back(key(c.i, c.j));
+    std::sort(keys.begin(), keys.end());
+    auto isCut = [&keys, &key](int a, int b) { return std::binary_search(keys.begin(), keys.end(), key(a, b)); };
+    std::vector<int>& cutTris = local.cutTriangles;
+    cutTris.clear();
+    size_t kept = 0;
+    for (size_t t = 0; t + 2 < triangles.size(); t += 3) {
+        const int a = triangles[t], b = triangles[t + 1], c = triangles[t + 2];
+        if (isCut(a, b) || isCut(b, c) || isCut(c, a)) {
+            cutTris.insert(cutTris.end(), {a, b, c});
+        } else {
+            triangles[kept++] = a;
+            triangles[kept++] = b;
+            triangles[kept++] = c;
+        }
+    }
+    triangles.resize(kept);
+
+    // Swap-and-pop within the colour batches, highest index first. The edge's slot takes the last
+    // edge of its batch, and each later batch moves its last edge down into the slot just freed
+    // in front of it. Every move reads from above the slot it fills, so the indices still to be
+    // removed stay where they are.
+    LocalConstraint* cs = localConstraints.data();
+    int* offsets = localColorOffsets.data();
+    const int numColors = (int)localColorOffsets.size() - 1;
+    for (auto r = edges.rbegin(); r != edges.rend(); ++r) {
+        const int k = *r;
+        const int color = (int)(std::upper_bound(offsets, offsets + numColors + 1, k) - offsets) - 1;
+        cs[k] = cs[offsets[color + 1] - 1];
+        for (int b = color + 1; b < numColors; ++b) cs[offsets[b] - 1] = cs[offsets[b + 1] - 1];
+        for (int b = color + 1; b <= numColors; ++b) --offsets[b];
+        localConstraints.pop_back();
+    }
+    tornEdges += (int)edges.size();
+    ++topologyVersion;
+
+    // Nearest attachments behind the cut; what lost its last path to one drops its tether
+    std::vector<int>& changed = local.changed;
+    changed.clear();
+    geodesic.removeEdges(cut, cutTris, changed);
+    if (tethersPerParticle == 1) {
+        updateLRAConstraints(changed);
+        return;
+    }
+    for (const LocalConstraint& c : cut) changed.insert(changed.end(), {c.i, c.j});
+    changed.insert(changed.end(), cutTris.begin(), cutTris.end());
+    retetherRegion(changed);
+}
+
+// ---------------------------------------------------------
+// Runtime Commands
+// ---------------------------------------------------------
+
+void SolverParams::set(SolverParam p, float value) {
+    const int n = (int)std::lround(value);
+    const bool on = (value != 0.0f);
+    switch (p) {
+    case PARAM_SOLVER_MODE:         solverMode = n; break;
+    case PARAM_ITERATIONS:          iterations = std::max(0, n); break;
+    case PARAM_ITERATION_MODE:      iterationMode = n; break;
+    case PARAM_ITERATION_TOLERANCE: iterationTolerance = value; break;
+    case PARAM_MAX_ITERATIONS:      maxIterations = std::max(1, n); break;
+    case PARAM_SUBSTEPS:            substeps = std::max(1, n); break;
+    case PARAM_USE_LRA:             useLRA = on; break;
+    case PARAM_LRA_SLACK:           lraSlack = std::max(1.0f, value); break;
+    case PARAM_LRA_SIMD:            lraSimd = on; break;
+    case PARAM_SLEEP:               sleep = on; break;
+    case PARAM_SLEEP_VELOCITY:      sleepVelocity = value; break;
+    case PARAM_SLEEP_STEPS:         sleepSteps = std::max(1, n); break;
+    case PARAM_SELF_COLLISION:      selfCollision = on; break;
+    case PARAM_COLLISION_THICKNESS: collisionThickness = value; break;
+    case PARAM_JACOBI_RELAXATION:   jacobiRelaxation = std::max(0.0f, value); break;
+    case PARAM_TEAR_STRAIN:         tearStrain = std::max(0.0f, value); break;
+    case PARAM_COUNT:               break;
+    }
+}
+
+void ClothInstance::applyCommands() {
+    const std::vector<ClothCommand>& batch = commands.take();
+    if (onCommands) onCommands(batch);
+    for (const ClothCommand& c : batch) applyCommand(c);
+}
+
+void ClothInstance::applyCommand(const ClothCommand& c) {
+    const int n = (int)P.size();
+    const int i = (c.vertex >= 0 && c.vertex < n) ? particleOf(c.vertex) : -1;
+    switch (c.type) {
+    case ClothCommand::SET_PARAM:
+        params.set(c.param, c.value);
+        wake(); // a tile at rest under the old settings (slack, tethers on) may not be under the new ones
+        break;
+    case ClothCommand::PIN:
+        if (i != -1) addAttachment(i);
+        break;
+    case ClothCommand::UNPIN:
+        if (i != -1) removeAttachment(i);
+        break;
+    case ClothCommand::IMPULSE:
+        if (c.vertex == -1) {
+            wake();
+            for (int k = 0; k < n; ++k) {
+                if (P.pinned[k]) continue;
+                P.vx[k] += c.v.x; P.vy[k] += c.v.y; P.vz[k] += c.v.z;
+            }
+        } else if (i != -1 && !P.pinned[i]) {
+            wakeParticle(i);
+            P.vx[i] += c.v.x; P.vy[i] += c.v.y; P.vz[i] += c.v.z;
+        }
+        break;
+    case ClothCommand::WIND:
+        wind.velocity = c.v;
+        wake();
+        break;
+    case ClothCommand::COMPLIANCE:
+        setCompliance(c.value);
+        wake();
+        break;
+    case ClothCommand::TETHERS:
+        setTethersPerParticle(c.vertex);
+        wake();
+        break;
+    case ClothCommand::TELEPORT:
+        // Rigid move: edges, tethers and sleep state are unaffected
+        for (int k = 0; k < n; ++k) {
+            P.x[k] += c.v.x;  P.y[k] += c.v.y;  P.z[k] += c.v.z;
+            P.px[k] += c.v.x; P.py[k] += c.v.y; P.pz[k] += c.v.z;
+        }
+        for (size_t k = 0; k < skin.size(); ++k) {
+            skin.x[k] += c.v.x; skin.y[k] += c.v.y; skin.z[k] += c.v.z;
+        }
+        break;
+    }
+}
+
+// ---------------------------------------------------------
+// Sleeping
+// ---------------------------------------------------------
+
+static const float kSleepMaxStrain = 0.05f;  // border edge strain a tile may fall asleep with
+static const float kSleepWakeFactor = 10.0f; // wake speed over params.sleepVelocity
+
+void SleepState::clear() {
+    awake.clear();
+    calm.clear();
+    speed2.clear();
+    savedW.clear();
+    adjOffsets.clear();
+    adj.clear();
+    edgeOffsets.clear();
+    edges.clear();
+    toWake.clear();
+    toSleep.clear();
+    version = ~0u;
+    numAsleep = 0;
+}
+
+// Tiles all awake, adjacency from the edges crossing tile boundaries
+void ClothInstance::buildSleepTiles() {
+    wake();
+    const int numT = numTiles();
+    sleep.awake.assign(numT, 1);
+    sleep.calm.assign(numT, 0);
+    sleep.speed2.assign(numT, 0.0f);
+    sleep.savedW.assign(P.size(), 0.0f);
+    sleep.toWake.reserve(numT);
+    sleep.toSleep.reserve(numT);
+
+    std::vector<std::pair<int, int>>& pairs = buildScratch().tilePairs;
+    std::vector<std::pair<int, int>>& crossing = buildScratch().tileEdges;
+    pairs.clear();
+    crossing.clear();
+    for (int k = 0; k < (int)localConstraints.size(); ++k) {
+        const auto& c = localConstraints[k];
+        int a = c.i >> kSleepTileShift, b = c.j >> kSleepTileShift;
+        if (a == b) continue;
+        pairs.push_back({a, b});
+        pairs.push_back({b, a});
+        crossing.push_back({a, k});
+        crossing.push_back({b, k});
+    }
+    std::sort(crossing.begin(), crossing.end());
+    sleep.edgeOffsets.assign(numT + 1, 0);
+    sleep.edges.resize(crossing.size());
+    for (size_t k = 0; k < crossing.size(); ++k) {
+        sleep.edgeOffsets[crossing[k].first + 1]++;
+        sleep.edges[k] = crossing[k].second;
+    }
+    for (int t = 0; t < numT; ++t) sleep.edgeOffsets[t + 1] += sleep.edgeOffsets[t];
+
+    std::sort(pairs.begin(), pairs.end());
+    pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+    sleep.adjOffsets.assign(numT + 1, 0);
+    sleep.adj.resize(pairs.size());
+    for (size_t k = 0; k < pairs.size(); ++k) {
+        sleep.adjOffsets[pairs[k].first + 1]++;
+        sleep.adj[k] = pairs[k].second;
+    }
+    for (int t = 0; t < numT; ++t) sleep.adjOffsets[t + 1] += sleep.adjOffsets[t];
+    sleep.version = topologyVersion;
+}
+
+void ClothInstance::sleepTile(int t) {
+    const int b = t << kSleepTileShift, e = std::min((int)P.size(), b + kSleepTile);
+    for (int i = b; i < e; ++i) {
+        sleep.savedW[i] = P.w[i];
+        P.w[i] = 0.0f;
+        P.px[i] = P.x[i]; P.py[i] = P.y[i]; P.pz[i] = P.z[i];
+        P.vx[i] = P.vy[i] = P.vz[i] = 0.0f;
+    }
+    sleep.awake[t] = 0;
+    sleep.calm[t] = 0;
+    ++sleep.numAsleep;
+}
+
+void ClothInstance::wakeTile(int t) {
+    if (sleep.awake[t]) return;
+    const int b = t << kSleepTileShift, e = std::min((int)P.size(), b + kSleepTile);
+    for (int i = b; i < e; ++i) P.w[i] = sleep.savedW[i];
+    sleep.awake[t] = 1;
+    --sleep.numAsleep;
+}
+
+void ClothInstance::wake() {
+    for (int t = 0; sleep.numAsleep > 0 && t < (int)sleep.awake.size(); ++t) wakeTile(t);
+}
+
+void ClothInstance::wakeParticle(int i) {
+    if (sleep.numAsleep > 0) wakeTile(i >> kSleepTileShift);
+}
+
+// Edges crossing into tile t are within kSleepMaxStrain of their rest length. A frozen tile leaves
+// the whole correction of such an edge to the awake side, so a strained border (the tug between
+// LRA and edges near the pins) would jolt the neighbour instead of letting it rest.
+bool ClothInstance::borderRelaxed(int t) const {
+    for (int k = sleep.edgeOffsets[t]; k < sleep.edgeOffsets[t + 1]; ++k) {
+        const LocalConstraint& c = localConstraints[sleep.edges[k]];
+        float strain = length(P.position(c.i) - P.position(c.j)) / c.restLen - 1.0f;
+        if (std::fabs(strain) > kSleepMaxStrain) return false;
+    }
+    return true;
+}
+
+// Once per step: calm tiles fall asleep, sleeping tiles next to a moving one wake up
+void ClothInstance::updateSleep() {
+    if (!canSleep()) {
+        wake();
+        return;
+    }
+    if (sleep.version != topologyVersion || (int)sleep.awake.size() != numTiles()) buildSleepTiles();
+
+    const int n = (int)P.size();
+    const int numT = (int)sleep.awake.size();
+    const float limit2 = params.sleepVelocity * params.sleepVelocity;
+    const float* VX = P.vx.data(); const float* VY = P.vy.data(); const float* VZ = P.vz.data();
+    for (int t = 0; t < numT; ++t) {
+        if (!sleep.awake[t]) {
+            sleep.speed2[t] = 0.0f;
+            continue;
+        }
+        const int b = t << kSleepTileShift, e = std::min(n, b + kSleepTile);
+        float m = 0.0f;
+        for (int i = b; i < e; ++i) m = std::max(m, VX[i] * VX[i] + VY[i] * VY[i] + VZ[i] * VZ[i]);
+        sleep.speed2[t] = m;
+        sleep.calm[t] = (m < limit2) ? (unsigned char)std::min(255, sleep.calm[t] + 1) : 0;
+    }
+
+    // Decide from this step's speeds before changing any state. A tile only sleeps once its whole
+    // neighbourhood has been calm as long, so freezing it does not jolt a neighbour that is still
+    // settling. Waking needs a neighbour kSleepWakeFactor times faster: a tile that just woke
+    // starts from rest and drops for a step, which must not cascade through the cloth.
+    const float wake2 = limit2 * kSleepWakeFactor * kSleepWakeFactor;
+    std::vector<int>& toWake = sleep.toWake;
+    std::vector<int>& toSleep = sleep.toSleep;
+    toWake.clear();
+    toSleep.clear();
+    for (int t = 0; t < numT; ++t) {
+        bool neighbourMoving = false, neighbourhoodCalm = true;
+        for (int k = sleep.adjOffsets[t]; k < sleep.adjOffsets[t + 1]; ++k) {
+            const int u = sleep.adj[k];
+            neighbourMoving |= sleep.speed2[u] >= wake2;
+            neighbourhoodCalm &= !sleep.awake[u] || sleep.calm[u] >= params.sleepSteps;
+        }
+        if (!sleep.awake[t] && neighbourMoving) toWake.push_back(t);
+        else if (sleep.awake[t] && neighbourhoodCalm && sleep.calm[t] >= params.sleepSteps && borderRelaxed(t)) toSleep.push_back(t);
+    }
+    for (int t : toWake) wakeTile(t);
+    for (int t : toSleep) sleepTile(t);
+}
+
+// ---------------------------------------------------------
+// Diagnostics
+// ---------------------------------------------------------
+
+StretchStats ClothInstance::measureStretch() const {
+    StretchStats s = {0.0f, 0.0f};
+    if (localConstraints.empty()) return s;
+
+    double sum = 0.0;
+    for (const auto& c : localConstraints) {
+        float strain = length(P.position(c.i) - P.position(c.j)) / c.restLen - 1.0f;
+        s.maxStrain = std::max(s.maxStrain, strain);
+        sum += std::fabs(strain);
+    }
+    s.meanStrain = (float)(sum / localConstraints.size());
+    return s;
+}
+
+void ClothInstance::copyTopology(ClothTopology& out) const {
+    out.edges.resize(localConstraints.size() * 2);
+    for (size_t k = 0; k < localConstraints.size(); ++k) {
+        out.edges[2 * k] = localConstraints[k].i;
+        out.edges[2 * k + 1] = localConstraints[k].j;
+    }
+    out.triangles = triangles;
+    out.tethers.resize(lraConstraints.size() * 2);
+    for (size_t k = 0; k < lraConstraints.size(); ++k) {
+        out.tethers[2 * k] = lraConstraints[k].particleIdx;
+        out.tethers[2 * k + 1] = lraConstraints[k].attachmentIdx;
+    }
+    out.pinned = P.pinned;
+    out.version = topologyVersion;
+}
@@ -0,0 +1,312 @@
+// simulation.h - PBD + Long Range Attachments solver core
+// Kept free of any GL/GLUT dependency so it can be driven headless (see bench/).
+
+#pragma once
+
+#include "cloth_types.h"
+#include "geodesic.h"
+#include "collision.h"
+#include "aero.h"
+#include "cloth_commands.h"
+
+#include <functional>
+#include <vector>
+
+// ---------------------------------------------------------
+// Globals
+// ---------------------------------------------------------
+
+// Simulation Constants
+static const float dt = 1.0f / 60.0f;
+static const vec3 g(0.0f, -9.8f, 0.0f);
+static const int clothW = 30;
+static const int clothH = 30; // Taller to show stretching better
+static const float spacing = 0.05f;
+
+// Solver modes for the local-constraint pass. All of them apply the XPBD update, which is plain
+// PBD for rigid (compliance 0) edges; the LRA pass runs on top unchanged.
+enum SolverMode {
+    SOLVER_GAUSS_SEIDEL = 0,     // Serial sweep over localConstraints
+    SOLVER_COLORED_PARALLEL = 1, // Colour batches projected in parallel on solverPool()
+    SOLVER_JACOBI = 2,           // Every edge against the same positions, relaxed corrections summed per particle
+};
+
+// Iteration control per substep
+enum IterationMode {
+    ITERATIONS_FIXED = 0,    // `iterations` every substep
+    ITERATIONS_ADAPTIVE = 1, // until the edge error is below `iterationTolerance`, at most `maxIterations`
+};
+
+// Parameters: defaults for the SolverParams of instances created from now on. The solver itself
+// only reads ClothInstance::params, so changing these never affects a cloth mid-step.
+extern int   g_solverMode;
+extern int   g_iterations;
+extern int   g_iterationMode;
+extern float g_iterationTolerance; // RMS relative edge error (|len / restLen - 1|) that ends a substep
+extern int   g_maxIterations;      // Per-substep cap in ITERATIONS_ADAPTIVE
+extern int   g_substeps;
+extern bool  g_useLRA;
+extern float g_lraSlack;
+extern bool  g_lraSimd;     // Use the vectorized LRA kernel (lra_simd.h)
+extern bool  g_optimizeLayout; // Run ClothInstance::optimizeLayout() at the end of buildScene()
+extern int   g_lraTethers;  // Tethers per particle (K nearest attachments), read by buildLRAConstraints()
+extern bool  g_sleep;          // Let settled tiles sleep (skip integration and projection)
+extern float g_sleepVelocity;  // Tile speed (max over its particles, m/s) counted as at rest...
+extern int   g_sleepSteps;     // ...for this many consecutive steps before the tile sleeps
+extern bool  g_selfCollision;      // Spatial-hash self-collision in the constraint loop
+extern float g_collisionThickness; // Gap kept between particles and to ClothInstance::colliders (m)
+extern float g_jacobiRelaxation;   // SOLVER_JACOBI over-relaxation (corrections are divided by the edge's larger end degree)
+extern float g_compliance;         // LocalConstraint::compliance of edges built from now on (m/N)
+extern float g_tearStrain;         // Edges stretched past this strain (len / restLen - 1) tear, 0 = never
+
+// Solver settings of one instance, initialised from the globals above when it is constructed
+// (or respawned from a ClothWorld pool). Change them between steps directly, or from any thread
+// through ClothInstance::commands.
+struct SolverParams {
+    int   solverMode = g_solverMode;
+    int   iterations = g_iterations;
+    int   iterationMode = g_iterationMode;
+    float iterationTolerance = g_iterationTolerance;
+    int   maxIterations = g_maxIterations;
+    int   substeps = g_substeps;
+    bool  useLRA = g_useLRA;
+    float lraSlack = g_lraSlack;
+    bool  lraSimd = g_lraSimd;
+    bool  sleep = g_sleep;
+    float sleepVelocity = g_sleepVelocity;
+    int   sleepSteps = g_sleepSteps;
+    bool  selfCollision = g_selfCollision;
+    float collisionThickness = g_collisionThickness;
+    float jacobiRelaxation = g_jacobiRelaxation;
+    float tearStrain = g_tearStrain;
+
+    void set(SolverParam p, float value);
+};
+
+// Sleep tiles are runs of 64 consecutive particle indices: 8 x 8 blocks after optimizeLayout()
+static const int kSleepTileShift = 6;
+static const int kSleepTile = 1 << kSleepTileShift;
+
+// Per-tile sleep state of one cloth. A sleeping tile keeps its particles frozen with w = 0, so
+// edges to awake neighbours treat it as pinned and edges inside it return before any math.
+struct SleepState {
+    std::vector<unsigned char> awake;  // per tile
+    std::vector<unsigned char> calm;   // consecutive steps below sleepVelocity (saturating)
+    std::vector<float> speed2;         // max squared speed of the last step, per tile
+    std::vector<float> savedW;         // inverse masses of sleeping particles, per particle
+    std::vector<int> adjOffsets, adj;  // tiles sharing an edge (CSR)
+    std::vector<int> edgeOffsets, edges; // localConstraints crossing each tile's border (CSR)
+    std::vector<int> toWake, toSleep;  // updateSleep(): tiles changing state this step
+    unsigned version = ~0u;            // topologyVersion the tiles were built for
+    int numAsleep = 0;
+
+    void clear();
+};
+
+// Scratch of the local pass: XPBD multipliers and the Jacobi gather
+struct LocalSolveState {
+    std::vector<float> lambda;            // per localConstraint, accumulated over one substep
+    std::vector<float> cx, cy, cz;        // Jacobi: per-edge correction of end i per unit inverse mass (end j: minus)
+    std::vector<int> vertexOffsets, vertexEdges; // Jacobi: edges around each particle (CSR), ~k at end j
+    std::vector<float> chunkMax;          // per-chunk error reduction of measured colored / Jacobi passes
+    std::vector<double> chunkSq;
+    std::vector<int> torn;                // tear(): edges past the strain limit
+    std::vector<LocalConstraint> cut;     // cutEdges(): the removed edges and triangles
+    std::vector<int> cutTriangles;
+    std::vector<int> changed;             // cutEdges(): vertices re-filled behind the cut (K > 1: the re-tethered region)
+    float invH2 = 0.0f;                   // 1 / h^2 of the current substep
+    bool compliant = false;               // some edge has compliance > 0
+    unsigned version = ~0u;               // topologyVersion `compliant` was taken from
+    unsigned jacobiVersion = ~0u;         // topologyVersion of the Jacobi CSR
+
+    void clear();
+};
+
+// Index data a renderer draws from, copied out by ClothInstance::copyTopology() so another thread
+// can read it while the cloth keeps changing (ClothFrame in sim_thread.h)
+struct ClothTopology {
+    unsigned version = ~0u;            // ClothInstance::topologyVersion it was copied at
+    std::vector<int> edges;            // i, j per local constraint
+    std::vector<int> triangles;        // 3 per triangle
+    std::vector<int> tethers;          // particle, attachment per LRA constraint
+    std::vector<unsigned char> pinned; // per particle
+
+    int numParticles() const { return (int)pinned.size(); }
+};
+
+// ---------------------------------------------------------
+// Cloth Instance
+// ---------------------------------------------------------
+
+// One independent cloth: owns its particles and constraints.
+// Instances share nothing, so many of them can be stepped concurrently (see cloth_world.h).
+class ClothInstance {
+public:
+    ParticleStore P;
+    std::vector<LocalConstraint> localConstraints;
+    std::vector<LRAConstraint> lraConstraints;
+    std::vector<int> attachmentIndices; // Indices of pinned particles
+    AttachmentSkin skin;                // Bone bindings of the attachments, empty if none are skinned
+    ColliderSet colliders;              // Body shapes in world space, collided with every iteration
+    WindField wind;                     // Air around the cloth, applied every substep (aero.h)
+    std::vector<int> triangles;         // 3 particle indices per triangle (rest topology)
+
+    SolverParams params;                // read by the solver; survives rebuilds
+    CommandQueue commands;              // edits from other threads, applied by the next simulate()
+
+    // Sees every batch applyCommands() takes, before it is applied, on the stepping thread
+    // (ReplayRecorder logs the step's inputs from here). Empty by default.
+    std::function<void(const std::vector<ClothCommand>&)> onCommands;
+
+    // localConstraints is grouped by colour: edges in [offsets[c], offsets[c+1]) share no particle
+    std::vector<int> localColorOffsets;
+
+    // Grid resolution of the last buildScene() / buildGrid()
+    int gridW = 0;
+    int gridH = 0;
+
+    int idx(int x, int y) const { return y * gridW + x; }
+
+    // Current particle index of the particle built as grid/source vertex `i`
+    // (identity until optimizeLayout() reorders the particles)
+    int particleOf(int i) const { return sourceToParticle.empty() ? i : sourceToParticle[i]; }
+
+    // Hanging cloth of w x h particles, top corners pinned, centred horizontally on `origin`
+    void buildScene(int w = clothW, int h = clothH, const vec3& origin = vec3(0.0f));
+
+    // Grid cloth of w x h particles at explicit rest positions (row-major, idx(x, y)) with the
+    // listed grid vertices pinned. buildScene() and the LOD proxies of cloth_lod.h build through it.
+    void buildGrid(int w, int h, const std::vector<vec3>& rest, const std::vector<int>& pinned);
+
+    // Cloth of any triangle mesh (mesh_import.h): one edge constraint per distinct triangle side,
+    // greedily coloured, plus with `bending` one across every interior edge between the two
+    // opposite corners. Tethers come from the geodesic pass as for grids. gridW / gridH are 0.
+    void buildMesh(const std::vector<vec3>& rest, const std::vector<int>& triangles, const std::vector<int>& pinned,
+                   bool bending = false);
+
+    // Advance by one fixed step of dt (params.substeps substeps of params.iterations iterations
+    // each), after applying the commands queued since the last step
+    void simulate();
+
+    // Apply the queued commands now; simulate() does this first. Call it before reading or
+    // transferring state that pending commands would still change (ClothLOD::setLevel()).
+    void applyCommands();
+
+    // Rebuild lraConstraints from attachmentIndices using geodesic distances in the rest state.
+    // With g_lraTethers = K > 1 every tethered particle gets its K nearest attachments, stored as
+    // K consecutive constraints (nearest first, padded by repeating the last one).
+    void buildLRAConstraints();
+
+    // Switch to K tethers per particle at runtime, reusing the rest-state geodesic field
+    void setTethersPerParticle(int K);
+
+    // Pin / release a particle at runtime (grabbing, pins torn off). Only the LRA constraints
+    // whose nearest attachment changes are touched; no scene rebuild.
+    void addAttachment(int i);
+    void removeAttachment(int i);
+
+    // Bind attachmentIndices[k] to bone bones[k] of a skinning palette (-1 = static). The anchors'
+    // current positions are their bind pose, so palette entries are boneWorld * inverse(boneBind)
+    // as for mesh skinning. Tethers keep their rest-state lengths; nothing is rebuilt.
+    void bindAttachments(const std::vector<int>& bones);
+
+    // One streaming pass over the bound anchors: target = palette[bone] * bindPose. The next
+    // simulate() sweeps the anchors to their targets linearly across its substeps.
+    void skinAttachments(const glm::mat4* palette, int numBones);
+
+    // Reorder particles along a Morton curve, remap every constraint to match, sort each colour
+    // batch by particle index and the LRA constraints by anchor. Called by buildScene() when
+    // g_optimizeLayout is set; safe to call again at any time.
+    void optimizeLayout();
+
+    // Give every local constraint XPBD compliance `compliance` (m/N, 0 = rigid). Stiffness then no
+    // longer depends on the iteration or substep count. Bumps topologyVersion.
+    void setCompliance(float compliance);
+
+    // Tear every edge stretched past `strain` (len / restLen - 1) and return how many tore.
+    // simulate() calls it at the end of each substep while params.tearStrain > 0.
+    int tear(float strain);
+
+    // Remove localConstraints[k] for every k in `edges` (sorted and de-duplicated in place), with
+    // the triangles on those edges. Each edge is swap-and-popped out of its colour batch, so the
+    // batches stay valid, and only the geodesic region behind the cut is recomputed; particles cut
+    // off from every attachment lose their tether instead of being pulled back. Bumps topologyVersion.
+    void cutEdges(std::vector<int>& edges);
+
+    // Project the constraints on the current positions without touching velocities, e.g. after a
+    // state transfer (ClothLOD::setLevel()) left the edges out of balance with the solver
+    void relax(int iterations);
+
+    StretchStats measureStretch() const;
+
+    // Copy the current edges, triangles, tethers and pins into `out`, reusing its storage
+    void copyTopology(ClothTopology& out) const;
+
+    // Wake every sleeping tile, or the one holding particle i. Call wake() after editing the cloth
+    // from outside (forces, slack changes) and before handing it to code that reads P.w, such as
+    // GpuClothSolver::upload(); the solver's own edits (pins, moving anchors, layout) wake as needed.
+    void wake();
+    void wakeParticle(int i);
+
+    int sleepingTiles() const { return sleep.numAsleep; }
+    int numTiles() const { return (int)(P.size() + kSleepTile - 1) >> kSleepTileShift; }
+
+    // Convergence monitor of the last simulate(): iterations run over all substeps and the edge
+    // error the local pass measured before its final correction. Errors are only measured in
+    // ITERATIONS_ADAPTIVE (0 otherwise).
+    struct SolveStats {
+        int iterations = 0;
+        float maxError = 0.0f;
+        float rmsError = 0.0f;
+    };
+    SolveStats lastSolve;
+
+    SleepState sleep;
+    ClothCollision collision;        // hash and broadphase of the current substep
+    ClothAero aero;                  // lumped masses and scratch rows of the wind stage
+    LocalSolveState local;           // multipliers and Jacobi scratch of the local pass
+
+    GeodesicField geodesic;          // nearest-attachment field, kept current by add/removeAttachment
+    std::vector<int> lraOfParticle;  // index of the particle's first tether in lraConstraints, -1 if none
+    int tethersPerParticle = 1;      // K of the last buildLRAConstraints()
+    int tornEdges = 0;               // edges removed by tear() / cutEdges() since the last build
+    std::vector<int> sourceToParticle; // stable permutation from build order to current order
+
+    // Bumped whenever constraints, pins or particle order change, so renderers and other
+    // caches of the topology know when to rebuild
+    unsigned topologyVersion = 0;
+
+private:
+    void substep(float h, float damping);
+    void sweepAnchors(float h, int remaining);
+    void integrate(float h);
+    void beginLocalSolve(float h);
+    void projectLocalPass();
+    void projectLocalMeasured(float& maxError, float& rmsError);
+    void projectLRAPass();
+    void projectCollisionPass();
+    void applyWindPass(float h);
+    bool canSleep() const { return params.sleep && !wind.active(); }
+    void updateVelocities(float h, float damping);
+    void updateSleep();
+    void buildSleepTiles();
+    bool borderRelaxed(int t) const;
+    void sleepTile(int t);
+    void wakeTile(int t);
+    void updateLRAConstraints(const std::vector<int>& changed);
+    void emitTethers();
+    void retetherRegion(std::vector<int>& region);
+    void applyCommand(const ClothCommand& c);
+};
+
+// ---------------------------------------------------------
+// Simulation Core
+// ---------------------------------------------------------
+
+// Returns the violation before projection (len - restLen), 0 if the edge cannot be corrected
+float projectLocal(ParticleStore& P, const LocalConstraint& c);
+void projectLRA(ParticleStore& P, const LRAConstraint& c, float slack);
+
+// Greedy edge colouring for arbitrary meshes. Reorders `cs` so each colour is contiguous
+// (stable within a colour) and fills `offsets` with numColors + 1 entries. Returns numColors.
+int colorConstraintsGreedy(std::vector<LocalConstraint>& cs, int numParticles, std::vector<int>& offsets);
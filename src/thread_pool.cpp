@@ -0,0 +1,167 @@
+// thread_pool.cpp - Work-stealing worker pool used by the parallel solver passes and ClothWorld
+
+#include "thread_pool.h"
+
+#include <algorithm>
+
+namespace {
+thread_local const ThreadPool* tl_pool = nullptr;
+thread_local int tl_worker = -1;
+}
+
+ThreadPool::ThreadPool(int numThreads) {
+    if (numThreads <= 0) numThreads = (int)std::max(1u, std::thread::hardware_concurrency());
+    for (int i = 0; i < numThreads; ++i) {
+        queues.emplace_back(new WorkQueue());
+    }
+    for (int i = 0; i + 1 < numThreads; ++i) {
+        workers.emplace_back([this, i] { workerLoop(i); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMtx);
+        stop = true;
+    }
+    sleepCv.notify_all();
+    for (auto& t : workers) t.join();
+}
+
+int ThreadPool::currentWorker() const {
+    return (tl_pool == this) ? tl_worker : -1;
+}
+
+void ThreadPool::submit(TaskGroup& group, std::function<void()> task) {
+    group.pending.fetch_add(1, std::memory_order_relaxed);
+
+    int self = currentWorker();
+    WorkQueue& q = *queues[self >= 0 ? self : queues.size() - 1];
+    {
+        std::lock_guard<std::mutex> lock(q.m);
+        q.tasks.push_back({std::move(task), &group});
+    }
+    queued.fetch_add(1, std::memory_order_release);
+
+    if (!workers.empty()) {
+        { std::lock_guard<std::mutex> lock(sleepMtx); }
+        sleepCv.notify_one();
+    }
+}
+
+bool ThreadPool::take(int self, Task& out) {
+    if (queued.load(std::memory_order_acquire) == 0) return false;
+
+    // Own queue first (LIFO end)
+    if (self >= 0) {
+        WorkQueue& q = *queues[self];
+        std::lock_guard<std::mutex> lock(q.m);
+        if (!q.tasks.empty()) {
+            out = std::move(q.tasks.back());
+            q.tasks.pop_back();
+            queued.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    // Injection queue, then steal from the other workers (FIFO end)
+    auto popFront = [&](int v) {
+        WorkQueue& q = *queues[v];
+        std::lock_guard<std::mutex> lock(q.m);
+        if (q.tasks.empty()) return false;
+        out = std::move(q.tasks.front());
+        q.tasks.pop_front();
+        queued.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    };
+    const int inject = (int)queues.size() - 1;
+    if (popFront(inject)) return true;
+    for (int k = 1; k <= inject; ++k) {
+        int v = (std::max(self, 0) + k) % inject;
+        if (v != self && popFront(v)) return true;
+    }
+    return false;
+}
+
+bool ThreadPool::tryRunOne(int self) {
+    Task task;
+    if (!take(self, task)) return false;
+    task.fn();
+    task.group->pending.fetch_sub(1, std::memory_order_release);
+    return true;
+}
+
+void ThreadPool::workerLoop(int index) {
+    tl_pool = this;
+    tl_worker = index;
+
+    while (!stop.load(std::memory_order_relaxed)) {
+        if (tryRunOne(index)) continue;
+
+        // Brief spin before sleeping: solver batches arrive in quick succession
+        bool found = false;
+        for (int spin = 0; spin < 64 && !found; ++spin) {
+            std::this_thread::yield();
+            found = queued.load(std::memory_order_acquire) > 0;
+        }
+        if (found) continue;
+
+        std::unique_lock<std::mutex> lock(sleepMtx);
+        sleepCv.wait(lock, [&] { return stop.load() || queued.load(std::memory_order_acquire) > 0; });
+    }
+}
+
+void ThreadPool::wait(TaskGroup& group) {
+    const int self = currentWorker();
+    while (!group.done()) {
+        if (!tryRunOne(self)) std::this_thread::yield();
+    }
+}
+
+void ThreadPool::parallelFor(int begin, int end, int grain, const std::function<void(int, int)>& fn) {
+    if (begin >= end) return;
+    grain = std::max(1, grain);
+
+    // Not worth waking anyone for a single chunk
+    const int numChunks = (end - begin + grain - 1) / grain;
+    if (workers.empty() || numChunks <= 1) {
+        fn(begin, end);
+        return;
+    }
+
+    // Helpers pull chunks from a shared cursor; late helpers find it exhausted and return at once.
+    std::atomic<int> next(begin);
+    auto runChunks = [&] {
+        for (;;) {
+            int b = next.fetch_add(grain, std::memory_order_relaxed);
+            if (b >= end) break;
+            fn(b, std::min(b + grain, end));
+        }
+    };
+
+    TaskGroup group;
+    const int helpers = std::min(numChunks, size()) - 1;
+    for (int i = 0; i < helpers; ++i) {
+        submit(group, runChunks);
+    }
+    runChunks();
+    wait(group);
+}
+
+// Created on first use (thread-safe static init) and only replaced by resizeSolverPool()
+static std::unique_ptr<ThreadPool>& solverPoolSlot() {
+    static std::unique_ptr<ThreadPool> pool(new ThreadPool());
+    return pool;
+}
+
+ThreadPool& solverPool() {
+    return *solverPoolSlot();
+}
+
+void resizeSolverPool(int numThreads) {
+    std::unique_ptr<ThreadPool>& pool = solverPoolSlot();
+    if (numThreads <= 0) numThreads = (int)std::max(1u, std::thread::hardware_concurrency());
+    if (pool->size() == numThreads) return;
+    pool.reset(); // join the old workers before the new ones start
+    pool.reset(new ThreadPool(numThreads));
+}
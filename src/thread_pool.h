@@ -0,0 +1,78 @@
+// thread_pool.h - Work-stealing worker pool used by the parallel solver passes and ClothWorld
+//
+// Every worker owns a deque: it pushes and pops its own tasks at the back (LIFO, cache-warm),
+// idle workers steal from the front of the others. Tasks submitted from outside the pool go to a
+// shared injection queue. Waiting on a TaskGroup runs queued tasks instead of blocking, so
+// parallelFor can be nested inside pool tasks (e.g. a coloured solve inside a cloth task).
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Counts outstanding tasks submitted against it
+class TaskGroup {
+public:
+    bool done() const { return pending.load(std::memory_order_acquire) == 0; }
+
+private:
+    friend class ThreadPool;
+    std::atomic<int> pending{0};
+};
+
+class ThreadPool {
+public:
+    // numThreads counts the calling thread; 0 = std::thread::hardware_concurrency()
+    explicit ThreadPool(int numThreads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int size() const { return (int)workers.size() + 1; }
+
+    void submit(TaskGroup& group, std::function<void()> task);
+
+    // Blocks until every task of `group` has run, executing queued tasks meanwhile
+    void wait(TaskGroup& group);
+
+    // Calls fn(begin, end) on chunks of at most `grain` items covering [begin, end).
+    // The caller participates and the call blocks until every chunk has run.
+    void parallelFor(int begin, int end, int grain, const std::function<void(int, int)>& fn);
+
+private:
+    struct Task {
+        std::function<void()> fn;
+        TaskGroup* group;
+    };
+    struct WorkQueue {
+        std::mutex m;
+        std::deque<Task> tasks;
+    };
+
+    int currentWorker() const;
+    bool take(int self, Task& out);
+    bool tryRunOne(int self);
+    void workerLoop(int index);
+
+    // queues[i] belongs to worker i; queues.back() is the injection queue for external threads
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<int> queued{0};
+    std::atomic<bool> stop{false};
+    std::mutex sleepMtx;
+    std::condition_variable sleepCv;
+};
+
+// Shared pool for the solver (sized on first use)
+ThreadPool& solverPool();
+
+// Replace the shared pool with one of numThreads threads (0 = hardware_concurrency()). Only
+// while no solver work is in flight; ClothWorlds built on the old pool must not step again.
+void resizeSolverPool(int numThreads);
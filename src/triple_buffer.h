@@ -0,0 +1,38 @@
+// triple_buffer.h - Lock-free single-producer / single-consumer triple buffer
+//
+// The writer fills back() and publish()es it; the reader acquire()s the newest published slot.
+// Neither side ever waits for the other: the writer always has a free slot, and the reader
+// keeps its slot until it asks for a newer one. Frames the reader never saw are dropped.
+
+#pragma once
+
+#include <atomic>
+
+template <typename T>
+class TripleBuffer {
+public:
+    // Writer side
+    T& back() { return slots[backIndex]; }
+    void publish() {
+        // Hand the filled slot over as the middle one and take the previous middle as the new back
+        backIndex = middle.exchange(backIndex | kFresh, std::memory_order_acq_rel) & kIndexMask;
+    }
+
+    // Reader side: the newest published slot, or the last one returned if nothing newer came.
+    // Stays untouched by the writer until the next acquire().
+    const T& acquire() {
+        if (middle.load(std::memory_order_relaxed) & kFresh) {
+            frontIndex = middle.exchange(frontIndex, std::memory_order_acq_rel) & kIndexMask;
+        }
+        return slots[frontIndex];
+    }
+
+private:
+    static const unsigned kIndexMask = 3;
+    static const unsigned kFresh = 4; // middle slot published since the reader last took it
+
+    T slots[3];
+    std::atomic<unsigned> middle{1};
+    unsigned backIndex = 0;  // writer thread only
+    unsigned frontIndex = 2; // reader thread only
+};
@@ -0,0 +1,123 @@
+// lra-bake.cpp - Offline bake of cloth assets (see cloth_asset.h)
+// Runs buildScene() (or buildMesh() on an imported OBJ / glTF) once and writes the result, so the
+// runtime only maps and copies it.
+//
+// Usage:
+//   lra-bake [--size W[xH]] [--layout on|off] [--verify] out.lrac
+//   lra-bake --mesh in.obj|in.gltf|in.glb [--bending] [--scale S] [--pin-group NAME]... [--verify] out.lrac
+
+#include "simulation.h"
+#include "cloth_asset.h"
+#include "mesh_import.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+static void usage() {
+    printf("=== SCA 2012 LRA Asset Baker ===\n");
+    printf("--size W[xH]  : Grid resolution of the hanging cloth (default %dx%d)\n", clothW, clothH);
+    printf("--layout MODE : on | off, Morton particle reordering before baking (default on)\n");
+    printf("--mesh FILE   : Bake an OBJ / glTF mesh instead of a grid (pins from its pin groups)\n");
+    printf("--bending     : With --mesh, add a bending constraint across every interior edge\n");
+    printf("--scale S     : With --mesh, scale positions by S (e.g. 0.01 for centimetres)\n");
+    printf("--pin-group N : With --mesh, pin only group N (repeatable; default every group)\n");
+    printf("--verify      : Load the written file back and compare it with the built cloth\n");
+}
+
+static double msSince(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// Baked and freshly built cloths must agree exactly
+static bool sameCloth(const ClothInstance& a, const ClothInstance& b) {
+    auto sameBytes = [](const auto& x, const auto& y) {
+        return x.size() == y.size() && (x.empty() || !memcmp(x.data(), y.data(), x.size() * sizeof(x[0])));
+    };
+    return sameBytes(a.P.x, b.P.x) && sameBytes(a.P.y, b.P.y) && sameBytes(a.P.z, b.P.z) && sameBytes(a.P.w, b.P.w) &&
+           sameBytes(a.P.pinned, b.P.pinned) && sameBytes(a.localConstraints, b.localConstraints) &&
+           sameBytes(a.localColorOffsets, b.localColorOffsets) && sameBytes(a.triangles, b.triangles) &&
+           sameBytes(a.lraConstraints, b.lraConstraints) && sameBytes(a.lraOfParticle, b.lraOfParticle) &&
+           sameBytes(a.attachmentIndices, b.attachmentIndices) && sameBytes(a.sourceToParticle, b.sourceToParticle);
+}
+
+int main(int argc, char** argv) {
+    int w = clothW, h = clothH;
+    bool verify = false, bending = false;
+    const char* out = nullptr;
+    const char* meshPath = nullptr;
+    MeshImportOptions importOpt;
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        if (!strcmp(a, "--size") && i + 1 < argc) {
+            const char* v = argv[++i];
+            w = h = atoi(v);
+            if (const char* x = strchr(v, 'x')) h = atoi(x + 1);
+        } else if (!strcmp(a, "--layout") && i + 1 < argc) {
+            g_optimizeLayout = strcmp(argv[++i], "off") != 0;
+        } else if (!strcmp(a, "--mesh") && i + 1 < argc) {
+            meshPath = argv[++i];
+        } else if (!strcmp(a, "--bending")) {
+            bending = true;
+        } else if (!strcmp(a, "--scale") && i + 1 < argc) {
+            importOpt.scale = (float)atof(argv[++i]);
+        } else if (!strcmp(a, "--pin-group") && i + 1 < argc) {
+            importOpt.pinGroups.push_back(argv[++i]);
+        } else if (!strcmp(a, "--verify")) {
+            verify = true;
+        } else if (a[0] != '-' && !out) {
+            out = a;
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    if (!out || w < 2 || h < 2) {
+        usage();
+        return 1;
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    ClothInstance cloth;
+    ClothMesh mesh;
+    if (meshPath) {
+        if (!loadClothMesh(meshPath, mesh, importOpt)) return 1;
+        printf("%s: %d vertices, %d triangles, %d pinned in %d groups (import %.2f ms)\n", meshPath,
+               (int)mesh.positions.size(), (int)mesh.triangles.size() / 3, (int)mesh.pinned.size(),
+               (int)mesh.pinGroupNames.size(), msSince(t0));
+        t0 = std::chrono::steady_clock::now();
+        cloth.buildMesh(mesh.positions, mesh.triangles, mesh.pinned, bending);
+    } else {
+        cloth.buildScene(w, h);
+    }
+    double buildMs = msSince(t0);
+
+    if (!bakeClothAsset(cloth, out)) {
+        fprintf(stderr, "Could not write %s\n", out);
+        return 1;
+    }
+    if (meshPath) {
+        printf("%s: %d particles, %d edges in %d colours, %d LRA constraints (buildMesh %.2f ms)\n", out,
+               (int)cloth.P.size(), (int)cloth.localConstraints.size(), (int)cloth.localColorOffsets.size() - 1,
+               (int)cloth.lraConstraints.size(), buildMs);
+    } else {
+        printf("%s: %dx%d, %d particles, %d edges, %d LRA constraints (buildScene %.2f ms)\n", out, w, h,
+               (int)cloth.P.size(), (int)cloth.localConstraints.size(), (int)cloth.lraConstraints.size(), buildMs);
+    }
+
+    if (verify) {
+        t0 = std::chrono::steady_clock::now();
+        ClothAsset asset;
+        if (!asset.open(out)) return 1;
+        ClothInstance loaded;
+        asset.instantiate(loaded);
+        double loadMs = msSince(t0);
+        if (!sameCloth(cloth, loaded)) {
+            fprintf(stderr, "%s: loaded cloth differs from the built one\n", out);
+            return 1;
+        }
+        printf("verified: map + instantiate %.2f ms\n", loadMs);
+    }
+    return 0;
+}